@@ -11,27 +11,105 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <unistd.h>
+#include <sched.h>
 #include "zf_log/zf_log.h"
 #include "at86rf215.h"
 #include "io_utils/io_utils.h"
 #include "at86rf215_radio.h"
 #include "at86rf215_regs.h"
 
-#define SPI_DEVICE  "/dev/spidev0.0"       // or #define SPI_DEVICE "/dev/spidev1.0"
-#define GPIO_DEVICE "/dev/gpiochip2"       // GPIO_DEVICE no 2
-#define GPIO_DEVICE_ISR "/dev/gpiochip0"   // GPIO_DEVICE no
+//===================================================================
+
+static inline int at86rf215_batch_owned(at86rf215_st* dev){
+    
+    // Only the thread which opened the batch appends to it (IRQ thread reads go directly) ...
+    return __atomic_load_n(&dev->batch_active, __ATOMIC_ACQUIRE) == 1 &&
+           pthread_equal(__atomic_load_n(&dev->batch_owner, __ATOMIC_RELAXED), pthread_self());
+}
+
+//===================================================================
+
+// at86rf215_spi_batch_flush_locked - commit the batch, caller holds the bus (shadow update is part of the transaction)
+static int at86rf215_spi_batch_flush_locked(at86rf215_st* dev){
+    
+    // The whole batch is one bus transaction (commit empties the batch, but keeps the xfer / tx / rx contents) ...
+    int len = dev->batch.num_bytes;
+    int ops = dev->batch.num_ops;
+    
+    uint64_t t0 = at86rf215_trace_begin(dev);
+    int ret = io_utils_spi_batch_commit(&dev->io, &dev->batch);
+    if(ops) at86rf215_trace_record_batch(dev, &dev->batch, ops, len, t0);
+    
+    // Queued writes reach the register shadow only once they are in the chip ...
+    at86rf215_regcache_commit_pending(dev, &dev->batch, ops, ret >= 0);
+    
+    return ret;
+}
 
 //===================================================================
 
+static int at86rf215_spi_batch_flush(at86rf215_st* dev){
+    
+    at86rf215_bus_acquire(dev);
+    int ret = at86rf215_spi_batch_flush_locked(dev);
+    at86rf215_bus_release(dev);
+    
+    return ret;
+}
+
+//===================================================================
+// The register shadow is read and written only while the bus is held - diff, transfer and shadow
+// update of one access are never interleaved with another thread's access
+
 int at86rf215_write_buffer(at86rf215_st* dev, uint16_t addr, uint8_t *buffer, uint8_t size ){
     
     // A maximal possible chunk size - 256 + 2(addr)
     uint8_t chunk_tx[256] = {0};
-    addr = (addr & 0x3FFF) | 0x8000;
+    int first = 0, len = size, ret = size;
+    
+    at86rf215_bus_acquire(dev);
+    
+    // Drop bytes already present in the chip (register shadow) ...
+    addr = (addr & 0x3FFF);
+    len = at86rf215_regcache_trim_write(dev, addr, buffer, size, &first);
+    
+    if(len == 0){
+        at86rf215_bus_release(dev);
+        return size;
+    }
+    
+    buffer += first;
+    size = len;
+    addr = (addr + first) & 0x3FFF;
+    
+    // Batch is open - queue the write, commit happens in at86rf215_batch_commit (shadow is updated there) ...
+    if(at86rf215_batch_owned(dev)){
+        if(io_utils_spi_batch_append_write(&dev->batch, addr | 0x8000, buffer, size) < 0){
+            // Batch is full - flush it and continue with a new one ...
+            ret = at86rf215_spi_batch_flush_locked(dev);
+            if(ret >= 0) io_utils_spi_batch_append_write(&dev->batch, addr | 0x8000, buffer, size);
+        }
+        if(ret >= 0){
+            at86rf215_regcache_set_pending(dev, addr, size);
+            ret = size;
+        }
+        at86rf215_bus_release(dev);
+        return ret;
+    }
     
     memcpy(chunk_tx, buffer, size);
 
-    return io_utils_spi_write_buffer(dev->io_spi, addr, chunk_tx, size);
+    uint64_t t0 = at86rf215_trace_begin(dev);
+    ret = io_utils_spi_write_buffer(&dev->io, addr | 0x8000, chunk_tx, size);
+    at86rf215_trace_record(dev, at86rf215_trace_op_write, addr | 0x8000, size, chunk_tx, t0, 0);
+    
+    // Shadow follows the chip - unknown content after a failed transfer ...
+    if(ret < 0) at86rf215_regcache_invalidate_range(dev, addr, size);
+    else at86rf215_regcache_post_write(dev, addr, chunk_tx, size);
+    
+    at86rf215_bus_release(dev);
+    
+    return ret;
 }
 
 
@@ -41,14 +119,35 @@ int at86rf215_read_buffer(at86rf215_st* dev, uint16_t addr, uint8_t *buffer, uin
     
     // A maximal possible chunk size - 256 + 2(addr)
     uint8_t chunk_rx[256] = {0};
+    int ret = size;
     addr = (addr & 0x3FFF);
+    
+    at86rf215_bus_acquire(dev);
+    
+    // Configuration registers are served from the shadow ...
+    if(at86rf215_regcache_read(dev, addr, buffer, size)){
+        at86rf215_bus_release(dev);
+        return size;
+    }
+    
+    // Batch is open - pending writes must reach the chip before this read ...
+    if(at86rf215_batch_owned(dev)){
+        ret = at86rf215_spi_batch_flush_locked(dev);
+    }
 
-    int ret = io_utils_spi_read_buffer(dev->io_spi, addr, chunk_rx, size);
+    if(ret >= 0){
+        uint64_t t0 = at86rf215_trace_begin(dev);
+        ret = io_utils_spi_read_buffer(&dev->io, addr, chunk_rx, size);
+        at86rf215_trace_record(dev, at86rf215_trace_op_read, addr, size, chunk_rx, t0, 0);
+    }
 
     if (ret > 0){
         memcpy(buffer, chunk_rx, size);
+        at86rf215_regcache_update(dev, addr, chunk_rx, size);
     }
     
+    at86rf215_bus_release(dev);
+    
     return ret;
 }
 
@@ -57,11 +156,9 @@ int at86rf215_read_buffer(at86rf215_st* dev, uint16_t addr, uint8_t *buffer, uin
 int at86rf215_write_byte(at86rf215_st* dev, uint16_t addr, uint8_t val){
     
     uint8_t chunk_tx = val;
-    addr = (addr & 0x3FFF) | 0x8000;
-    
-    return io_utils_spi_write_byte(dev->io_spi, addr, chunk_tx);
-
     
+    // Batch / register shadow handling lives in at86rf215_write_buffer ...
+    return at86rf215_write_buffer(dev, addr, &chunk_tx, 1);
 }
 
 //===================================================================
@@ -69,15 +166,176 @@ int at86rf215_write_byte(at86rf215_st* dev, uint16_t addr, uint8_t val){
 int at86rf215_read_byte(at86rf215_st* dev, uint16_t addr){
 
     uint8_t chunk_rx = {0};
+    int ret = 0;
     addr = (addr & 0x3FFF);
     
-    int ret = io_utils_spi_read_byte(dev->io_spi, addr, &chunk_rx);
+    at86rf215_bus_acquire(dev);
     
-    if (ret < 0){
-        return ret;
+    // Configuration registers are served from the shadow ...
+    if(at86rf215_regcache_read(dev, addr, &chunk_rx, 1)){
+        at86rf215_bus_release(dev);
+        return chunk_rx;
     }
     
-    return chunk_rx;
+    // Batch is open - pending writes must reach the chip before this read ...
+    if(at86rf215_batch_owned(dev)){
+        ret = at86rf215_spi_batch_flush_locked(dev);
+    }
+    
+    if(ret >= 0){
+        uint64_t t0 = at86rf215_trace_begin(dev);
+        ret = io_utils_spi_read_byte(&dev->io, addr, &chunk_rx);
+        at86rf215_trace_record(dev, at86rf215_trace_op_read, addr, 1, &chunk_rx, t0, 0);
+    }
+    
+    if (ret >= 0){
+        at86rf215_regcache_update(dev, addr, &chunk_rx, 1);
+        ret = chunk_rx;
+    }
+    
+    at86rf215_bus_release(dev);
+    
+    return ret;
+}
+
+//===================================================================
+
+int at86rf215_write_burst(at86rf215_st* dev, uint16_t addr, const uint8_t *buffer, size_t size){
+    
+    int ret = 0;
+    addr = (addr & 0x3FFF);
+    
+    at86rf215_bus_acquire(dev);
+    
+    // Batch is open - pending writes must reach the chip before this burst ...
+    if(at86rf215_batch_owned(dev)){
+        ret = at86rf215_spi_batch_flush_locked(dev);
+    }
+    
+    // No bounce buffer - data go from the caller buffer to spidev ...
+    if(ret >= 0){
+        uint64_t t0 = at86rf215_trace_begin(dev);
+        ret = io_utils_spi_write_burst(&dev->io, addr | 0x8000, buffer, size);
+        at86rf215_trace_record(dev, at86rf215_trace_op_write_burst, addr, size, buffer, t0, 0);
+        
+        // Register space - keep register shadow coherent with what reached the chip ...
+        if(addr < AT86RF215_REGCACHE_SIZE){
+            if(ret < 0) at86rf215_regcache_invalidate_range(dev, addr, size);
+            else at86rf215_regcache_post_write(dev, addr, buffer, size);
+        }
+    }
+    
+    at86rf215_bus_release(dev);
+    
+    return ret;
+}
+
+//===================================================================
+
+int at86rf215_read_burst(at86rf215_st* dev, uint16_t addr, uint8_t *buffer, size_t size){
+    
+    int ret = 0;
+    addr = (addr & 0x3FFF);
+    
+    at86rf215_bus_acquire(dev);
+    
+    // Batch is open - pending writes must reach the chip before this burst ...
+    if(at86rf215_batch_owned(dev)){
+        ret = at86rf215_spi_batch_flush_locked(dev);
+    }
+    
+    // No bounce buffer - spidev fills the caller buffer ...
+    if(ret >= 0){
+        uint64_t t0 = at86rf215_trace_begin(dev);
+        ret = io_utils_spi_read_burst(&dev->io, addr, buffer, size);
+        at86rf215_trace_record(dev, at86rf215_trace_op_read_burst, addr, size, buffer, t0, 0);
+    }
+    
+    if(ret > 0 && addr < AT86RF215_REGCACHE_SIZE){
+        at86rf215_regcache_update(dev, addr, buffer, size);
+    }
+    
+    at86rf215_bus_release(dev);
+    
+    return ret;
+}
+
+//===================================================================
+
+// at86rf215_batch_begin - open a batch; nested inside an own batch it only counts the depth,
+// a batch of another thread is waited for (one batch per device)
+void at86rf215_batch_begin(at86rf215_st* dev){
+    
+    int closed = 0;
+    int sleep_us = 1;
+    
+    if(at86rf215_batch_owned(dev)){
+        dev->batch_depth++;
+        return;
+    }
+    
+    while(!__atomic_compare_exchange_n(&dev->batch_active, &closed, 2, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)){
+        closed = 0;
+        io_utils_usleep(sleep_us);
+        sleep_us = (sleep_us < 100) ? sleep_us * 2 : 100;
+    }
+    
+    // Writes issued by this thread are queued until at86rf215_batch_commit ...
+    io_utils_spi_batch_begin(&dev->batch);
+    dev->batch_depth = 0;
+    __atomic_store_n(&dev->batch_owner, pthread_self(), __ATOMIC_RELAXED);
+    __atomic_store_n(&dev->batch_active, 1, __ATOMIC_RELEASE);
+}
+
+//===================================================================
+
+int at86rf215_batch_read(at86rf215_st* dev, uint16_t addr, uint8_t *slot, uint8_t size){
+    
+    addr = (addr & 0x3FFF);
+    
+    // No open batch - plain read ...
+    if(!at86rf215_batch_owned(dev)){
+        return at86rf215_read_buffer(dev, addr, slot, size);
+    }
+    
+    if(io_utils_spi_batch_append_read(&dev->batch, addr, slot, size) < 0){
+        // Batch is full - flush it and continue with a new one ...
+        int ret = at86rf215_spi_batch_flush(dev);
+        if(ret < 0) return ret;
+        return io_utils_spi_batch_append_read(&dev->batch, addr, slot, size);
+    }
+    
+    return 0;
+}
+
+//===================================================================
+
+int at86rf215_batch_write(at86rf215_st* dev, uint16_t addr, uint8_t *buffer, uint8_t size){
+    
+    return at86rf215_write_buffer(dev, addr, buffer, size);
+}
+
+//===================================================================
+
+int at86rf215_batch_commit(at86rf215_st* dev){
+    
+    int ret = 0;
+    
+    if(!at86rf215_batch_owned(dev)){
+        return 0;
+    }
+    
+    // Nested batch - the outermost commit sends it ...
+    if(dev->batch_depth > 0){
+        dev->batch_depth--;
+        return 0;
+    }
+    
+    // Whole batch as one SPI_IOC_MESSAGE(n), read slots are filled here ...
+    ret = at86rf215_spi_batch_flush(dev);
+    __atomic_store_n(&dev->batch_active, 0, __ATOMIC_RELEASE);
+    
+    return ret;
 }
 
 //===================================================================
@@ -111,6 +369,42 @@ int median(int a[], int n)
     return a[(n+1)/2-1];
 }
 
+//===================================================================
+// at86rf215_trx_ready_clear - drop TRXRDY signals of earlier transitions before a new command
+static void at86rf215_trx_ready_clear(at86rf215_st* dev, at86rf215_rf_channel_en radio)
+{
+    event_node_signal_ready((radio == at86rf215_rf_channel_900mhz) ? &dev->events.lo_trx_ready_event : &dev->events.hi_trx_ready_event, 0);
+}
+
+//===================================================================
+// at86rf215_wait_trx_ready - TRXRDY after TXPREP (nothing to wait for if set_state already saw TXPREP): event waits
+// (irq_mode strategy) in growing slices, RFn_STATE checked between them (edge lost) - one deadline for both
+static int at86rf215_wait_trx_ready(at86rf215_st* dev, at86rf215_rf_channel_en radio, int set_state_ret)
+{
+    event_st* ev = (radio == at86rf215_rf_channel_900mhz) ? &dev->events.lo_trx_ready_event : &dev->events.hi_trx_ready_event;
+    uint32_t timeout_us = dev->trx_ready_timeout_us ? dev->trx_ready_timeout_us : AT86RF215_TRX_READY_TIMEOUT_US;
+    uint64_t deadline = at86rf215_trace_now() + (uint64_t)timeout_us * 1000;
+    uint32_t slice_us = AT86RF215_TRX_READY_CHECK_US;
+
+    if (set_state_ret == 0) return 0;
+
+    for (uint64_t now = at86rf215_trace_now(); now < deadline; now = at86rf215_trace_now())
+    {
+        uint32_t left_us = (deadline - now + 999) / 1000;
+        if (at86rf215_wait_event(dev, ev, (slice_us < left_us) ? slice_us : left_us) == 0) return 0;
+
+        if (at86rf215_radio_get_state(dev, radio) == at86rf215_radio_state_cmd_tx_prep)
+        {
+            ZF_LOGW("TRXRDY of radio %d not signalled - TXPREP reached (RFn_STATE)", radio);
+            return 0;
+        }
+        slice_us = (slice_us * 2 < AT86RF215_TRX_READY_CHECK_MAX_US) ? slice_us * 2 : AT86RF215_TRX_READY_CHECK_MAX_US;
+    }
+
+    ZF_LOGE("Radio %d did not reach TXPREP", radio);
+    return -1;
+}
+
 //===================================================================
 
 int at86rf215_calibrate_device(at86rf215_st* dev, at86rf215_rf_channel_en ch, int* i_val, int* q_val)
@@ -120,15 +414,14 @@ int at86rf215_calibrate_device(at86rf215_st* dev, at86rf215_rf_channel_en ch, in
     bool override_flag = dev->override_cal;
     dev->override_cal = false;
     
+    at86rf215_trace_mark(dev, "calibrate");
     ZF_LOGD("Calibration of modem channel %d...", ch);
     for (int i = 0; i < NUM_CAL_STEPS; i ++)
     {
+        // TX calibration runs on the way from TRXOFF to TXPREP - results are valid once TXPREP is reported ...
         at86rf215_radio_set_state(dev, ch, at86rf215_radio_state_cmd_trx_off);
-        io_utils_usleep(2000);
         at86rf215_radio_set_state(dev, ch, at86rf215_radio_state_cmd_tx_prep);
 
-        io_utils_usleep(10000);
-
         at86rf215_radio_get_tx_iq_calibration(dev, ch, &cal_i[i], &cal_q[i]);
         //printf("[%d,%d], ", cal_i[i], cal_q[i]);
     }
@@ -153,6 +446,77 @@ int at86rf215_calibrate_device(at86rf215_st* dev, at86rf215_rf_channel_en ch, in
     return 0;
 }
 
+//===================================================================
+// at86rf215_open_io - transport, GPIO lines and chip reset only: no register traffic, no IRQ thread
+// The SPI device is opened by the caller (io_utils_spi_init) - at86rf215_init and raw session replay
+int at86rf215_open_io(at86rf215_st* dev)
+{
+	if (dev == NULL){
+        ZF_LOGE("at86rf215_st DEV is NULL");
+		return -1;
+	}
+
+    // Device nodes - defaults unless set by the caller ...
+    if (dev->spi_dev == NULL) dev->spi_dev = AT86RF215_DEFAULT_SPI_DEVICE;
+    if (dev->gpio_dev == NULL) dev->gpio_dev = AT86RF215_DEFAULT_GPIO_DEVICE;
+    if (dev->gpio_dev_isr == NULL) dev->gpio_dev_isr = AT86RF215_DEFAULT_GPIO_DEVICE_ISR;
+
+    ZF_LOGD("Configuring reset and CS pins (%s)", dev->gpio_dev);
+    
+    // Own SPI / GPIO context - devices do not share any io_utils state ...
+    io_utils_dev_init(&dev->io);
+    memset(&dev->bus, 0, sizeof(dev->bus));
+
+    // Software emulator, spidev (kernel driver) or memory mapped DesignWare SSI ...
+    if (dev->emulated)
+    {
+        if (at86rf215_emu_attach(dev) != 0) return -1;
+    }
+    else if (io_utils_set_transport(&dev->io, dev->spi_transport) != 0)
+    {
+        ZF_LOGE("unknown SPI transport %d", dev->spi_transport);
+        return -1;
+    }
+    else if (dev->spi_transport == IO_UTILS_TRANSPORT_DW_UIO)
+    {
+        // DW SSI drops its native CS whenever the TX FIFO runs empty - GPIO CS only ...
+        if (dev->cs_mode != IO_UTILS_CS_GPIO || dev->cs_uio_dev == NULL)
+        {
+            ZF_LOGE("DW_UIO transport needs GPIO CS (cs_mode = IO_UTILS_CS_GPIO, cs_uio_dev)");
+            return -1;
+        }
+        io_utils_dw_configure(&dev->io, dev->cs_uio_dev, dev->ssi_clk_hz);
+    }
+    
+    // SPI transaction trace ring ...
+    at86rf215_trace_open(dev);
+
+    // Select chip select mode (GPIO emulated or SPI controller native) ...
+    io_utils_set_cs_mode(&dev->io, dev->cs_mode);
+    
+    // Init GPIO bank - CS, RESET and IRQ lines requested once (one request per GPIO chip) ...
+    io_utils_set_gpio_event_config(&dev->io, dev->irq_event_clock, dev->irq_debounce_us);
+    io_utils_setup_gpio_lines(&dev->io, dev->gpio_dev, dev->gpio_dev_isr, dev->cs_pin, dev->reset_pin,
+                              (dev->irq_mode == AT86RF215_IRQ_MODE_POLL) ? -1 : dev->irq_pin);
+    
+    // Reset at86rf215 radio ...
+    at86rf215_reset(dev);
+
+    return 0;
+}
+
+//===================================================================
+void at86rf215_close_io(at86rf215_st* dev)
+{
+	// Release the SPI device ...
+    io_utils_spi_close(&dev->io);   
+    
+    // Release the CS line handle ...
+    io_utils_release_gpio(&dev->io);
+
+    at86rf215_trace_close(dev);
+}
+
 //===================================================================
 
 int at86rf215_init(at86rf215_st* dev)
@@ -165,21 +529,25 @@ int at86rf215_init(at86rf215_st* dev)
 		return -1;
 	}
 
-    ZF_LOGD("Configuring reset and CS pins");
+    if (at86rf215_open_io(dev) != 0) return -1;
+    at86rf215_trace_mark(dev, "init");
     
-    // Init GPIO bank + SPI CS ...  
-    io_utils_setup_gpio(GPIO_DEVICE, GPIO_DEVICE_ISR, dev->cs_pin); 
-    
-    // Reset at86rf215 radio ...
-    at86rf215_reset(dev);
+    // Register shadow starts empty, filled by reads / writes ...
+    at86rf215_regcache_enable(dev, 1);
 
     // Set GPIO (reset pin) to 1 (to known state) ...
-    // io_utils_write_gpio(dev->reset_pin, GPIO_HI_LEVEL);
+    // io_utils_write_gpio(&dev->io, dev->reset_pin, GPIO_HI_LEVEL);
     
-    ZF_LOGD("Configuring SPI device modem");
+    ZF_LOGD("Configuring SPI device modem (%s)", dev->spi_dev);
     
     // Init SPI + spi struct ...
-    ret = io_utils_spi_init(&dev->io_spi, SPI_DEVICE, dev->spi_mode, dev->spi_bits, dev->spi_speed);
+    ret = io_utils_spi_init(&dev->io, dev->spi_dev, dev->spi_mode, dev->spi_bits, dev->spi_speed);
+    
+    // Fastest reliable clock for frame buffer bursts (register accesses stay at spi_speed) ...
+    dev->spi_speed_burst = 0;
+    if (ret == 0 && dev->spi_speed_auto){
+        at86rf215_spi_characterize(dev, 0);
+    }
     
     // Setup the interrupts after clearing the register one time
     at86rf215_irq_st irq = {0};
@@ -192,20 +560,68 @@ int at86rf215_init(at86rf215_st* dev)
     // Configuring default IRQ setup on AT86RF215 ...
     at86rf215_setup_rf_irq(dev, 0, 0, at86rf215_iq_drive_current_4ma);
     
-    // Setup external interrupt callback ...
-    ret = io_utils_setup_interrupt(dev->irq_pin, &at86rf215_interrupt_handler, (void *)dev);
+    // Initialize events (before the IRQ thread may signal them) ...
+    event_node_init(&dev->events.lo_trx_ready_event);
+    event_node_init(&dev->events.lo_energy_measure_event);
+    event_node_init(&dev->events.hi_trx_ready_event);
+    event_node_init(&dev->events.hi_energy_measure_event);
+    
+    if (dev->event_spin_ns != 0)
+    {
+        dev->events.lo_trx_ready_event.spin_ns = dev->event_spin_ns;
+        dev->events.lo_energy_measure_event.spin_ns = dev->event_spin_ns;
+        dev->events.hi_trx_ready_event.spin_ns = dev->event_spin_ns;
+        dev->events.hi_energy_measure_event.spin_ns = dev->event_spin_ns;
+    }
+    
+    // Lock process memory (page faults on the IRQ path) ...
+    if (dev->lock_memory && io_utils_lock_memory() != 0)
+    {
+        ZF_LOGW("mlockall failed - memory stays pageable (RLIMIT_MEMLOCK / CAP_IPC_LOCK)");
+    }
+    
+    // IRQ thread scheduling ...
+    gpio_thread_attr_s irq_attr = {
+        .policy = dev->irq_thread_policy,
+        .priority = dev->irq_thread_priority,
+        .cpu_mask = dev->irq_thread_cpus,
+        .stack_size = dev->irq_thread_stack,
+    };
+    io_utils_set_irq_thread_attr(&dev->io, &irq_attr);
+    
+    // IRQ bit dispatch table (before the IRQ thread runs) ...
+    at86rf215_irq_table_init(dev);
+    
+    // Setup external interrupt callback (POLL - no IRQ line, waiters read IRQS) ...
+    if (dev->irq_mode == AT86RF215_IRQ_MODE_POLL)
+    {
+        ret = 0;
+    }
+    else if (dev->irq_fd_mode)
+    {
+        ret = (io_utils_setup_interrupt_fd(&dev->io, dev->irq_pin, &at86rf215_interrupt_handler, (void *)dev) < 0) ? -1 : 0;
+    }
+    else
+    {
+        ret = io_utils_setup_interrupt(&dev->io, dev->irq_pin, &at86rf215_interrupt_handler, (void *)dev);
+    }
   
+    if(ret!=0 && dev->irq_mode == AT86RF215_IRQ_MODE_HYBRID){
+       ZF_LOGW("Interrupt registration for irq_pin (%d) failed - IRQS is polled", dev->irq_pin);
+       dev->irq_mode = AT86RF215_IRQ_MODE_POLL;
+       ret = 0;
+    }
+    
     if(ret!=0){
        ZF_LOGE("Interrupt registration for irq_pin (%d) failed", dev->irq_pin);
        return -1; 
     }
     
-    // Initialize events ...
-    event_node_init(&dev->events.lo_trx_ready_event);
-    event_node_init(&dev->events.lo_energy_measure_event);
-    event_node_init(&dev->events.hi_trx_ready_event);
-    event_node_init(&dev->events.hi_energy_measure_event);
-
+    if (dev->irq_mode != AT86RF215_IRQ_MODE_POLL && !dev->irq_fd_mode && irq_attr.policy != SCHED_OTHER && !dev->io.irq_event.rt_applied)
+    {
+        ZF_LOGW("IRQ thread real-time policy %d not permitted - inherited policy is used", irq_attr.policy);
+    }
+    
 	// Get chip type ...
 	uint8_t pn = 0, vn = 0;
 	at86rf215_get_versions(dev, &pn, &vn);
@@ -239,21 +655,23 @@ int at86rf215_close(at86rf215_st* dev, int reset_dev)
 
 	dev->initialized = 0;
 
+    // Stop SPI worker (if started) before the SPI device is released ...
+    at86rf215_async_stop(dev);
+
     event_node_close(&dev->events.lo_trx_ready_event);
     event_node_close(&dev->events.lo_energy_measure_event);
     event_node_close(&dev->events.hi_trx_ready_event);
     event_node_close(&dev->events.hi_energy_measure_event);
 
     // Disable external interrupt ...
-    io_utils_disable_interrupt();
+    io_utils_disable_interrupt(&dev->io);
     
     // Reset at86rf215 if requested ...
     if(reset_dev){
        at86rf215_chip_reset_with_spi(dev); 
     }
         
-	// Release the SPI device ...
-    io_utils_spi_close(dev->io_spi);   
+    at86rf215_close_io(dev);
 
 	ZF_LOGD("Device release completed");
     
@@ -263,9 +681,12 @@ int at86rf215_close(at86rf215_st* dev, int reset_dev)
 //===================================================================
 void at86rf215_reset(at86rf215_st* dev)
 {
-	io_utils_write_gpio(dev->reset_pin, 0);
+	io_utils_write_gpio(&dev->io, dev->reset_pin, 0);
     io_utils_usleep(300);
-	io_utils_write_gpio(dev->reset_pin, 1);
+	io_utils_write_gpio(&dev->io, dev->reset_pin, 1);
+    
+    // All registers are back to their reset values ...
+    at86rf215_regcache_invalidate(dev);
 }
 
 //===================================================================
@@ -477,6 +898,16 @@ void at86rf215_get_iq_if_cfg(at86rf215_st* dev, at86rf215_iq_interface_config_st
 void at86rf215_setup_iq_if(at86rf215_st* dev, at86rf215_iq_interface_config_st* cfg)
 {
     uint8_t data[2] = {0};
+    at86rf215_pack_iq_if(cfg, data);
+    at86rf215_write_buffer(dev, REG_RF_IQIFC0, data, 2);
+}
+
+//===================================================================
+void at86rf215_pack_iq_if(at86rf215_iq_interface_config_st* cfg, uint8_t *data)
+{
+    // IQIFC0, IQIFC1
+    data[0] = 0;
+    data[1] = 0;
     data[0] |= (cfg->loopback_enable&0x01) << 7;
     data[0] |= (cfg->drv_strength&0x03) << 4;
 
@@ -504,8 +935,6 @@ void at86rf215_setup_iq_if(at86rf215_st* dev, at86rf215_iq_interface_config_st*
     }
 
     data[1] |= (cfg->clock_skew & 0x03) << 0;
-
-    at86rf215_write_buffer(dev, REG_RF_IQIFC0, data, 2);
 }
 
 //===================================================================
@@ -545,6 +974,9 @@ int64_t at86rf215_setup_channel ( at86rf215_st* dev, at86rf215_rf_channel_en ch,
     int center_freq_25khz_res = 0;
     int channel_number = 0;
     double actual_freq = at86rf215_radio_get_frequency(mode, 1, freq_hz, &center_freq_25khz_res, &channel_number);
+
+    // Phase marker only for hops which reach the chip (replay splits phases on it) ...
+    at86rf215_trace_mark(dev, "hop");
     at86rf215_radio_setup_channel(dev, ch, 1, center_freq_25khz_res, channel_number, mode);
     return (int64_t)actual_freq;
 }
@@ -553,6 +985,7 @@ int64_t at86rf215_setup_channel ( at86rf215_st* dev, at86rf215_rf_channel_en ch,
 void at86rf215_setup_iq_radio_transmit (at86rf215_st* dev, at86rf215_rf_channel_en radio, uint64_t freq_hz, at86rf215_tx_control_st *tx_control,
                                          int iqloopback, at86rf215_iq_clock_data_skew_en skew)
 {
+    at86rf215_trace_mark(dev, "setup_tx");
     /*
     It is assumed, that the radio has been reset before and is in State TRXOFF. All interrupts in register RFn_IRQS should be enabled (RFn_IRQM=0x3f).
     */
@@ -588,36 +1021,35 @@ void at86rf215_setup_iq_radio_transmit (at86rf215_st* dev, at86rf215_rf_channel_
     // 1. Set TRXOFF mode
     at86rf215_radio_set_state(dev, radio, at86rf215_radio_state_cmd_trx_off);
 
-
-    // 2. Enable all radio interrupts in 09,_24_IRQS
-    at86rf215_radio_irq_st int_mask = {
-        .wake_up_por = 1,
-        .trx_ready = 1,
-        .energy_detection_complete = 1,
-        .battery_low = 1,
-        .trx_error = 1,
-        .IQ_if_sync_fail = 1,
-        .res = 0,
-    };
-    
-    at86rf215_radio_setup_interrupt_mask(dev, radio, &int_mask);
-    
-    // 3. Enable I/Q radio mode - setting IQIFC1.CHPM=1 at AT86RF215 (in AT86RF215IQ it is the only choice)
-    at86rf215_iq_interface_config_st iq_if_config = {
-        .loopback_enable = iqloopback,
-        .drv_strength = at86rf215_iq_drive_current_4ma,
-        .common_mode_voltage = at86rf215_iq_common_mode_v_ieee1596_1v2,
-        .tx_control_with_iq_if = tx_control->tx_control_with_iq_if,
-        .radio09_mode = at86rf215_iq_if_mode,
-        .radio24_mode = at86rf215_iq_if_mode,
-        .clock_skew = skew,
-    };
-    
-    at86rf215_setup_iq_if(dev, &iq_if_config);
-    
-    
-    // 4. Configure the Transmitter Frontend
-    at86rf215_radio_tx_ctrl_st tx_ctrl = {
+    // Steps 2. - 5. - only registers which differ from the last applied state are sent (one SPI message) ...
+    at86rf215_radio_config_st radio_cfg = {
+        .sections = AT86RF215_RADIO_CFG_IRQ_MASK | AT86RF215_RADIO_CFG_IQ_IF |
+                    AT86RF215_RADIO_CFG_TX_FRONTEND | AT86RF215_RADIO_CFG_CHANNEL,
+        
+        // 2. Enable all radio interrupts in 09,_24_IRQS
+        .irq_mask = {
+            .wake_up_por = 1,
+            .trx_ready = 1,
+            .energy_detection_complete = 1,
+            .battery_low = 1,
+            .trx_error = 1,
+            .IQ_if_sync_fail = 1,
+            .res = 0,
+        },
+        
+        // 3. Enable I/Q radio mode - setting IQIFC1.CHPM=1 at AT86RF215 (in AT86RF215IQ it is the only choice)
+        .iq_if = {
+            .loopback_enable = iqloopback,
+            .drv_strength = at86rf215_iq_drive_current_4ma,
+            .common_mode_voltage = at86rf215_iq_common_mode_v_ieee1596_1v2,
+            .tx_control_with_iq_if = tx_control->tx_control_with_iq_if,
+            .radio09_mode = at86rf215_iq_if_mode,
+            .radio24_mode = at86rf215_iq_if_mode,
+            .clock_skew = skew,
+        },
+        
+        // 4. Configure the Transmitter Frontend
+        .tx = {
              .pa_ramping_time = tx_control->pa_ramping_time,
              .current_reduction = tx_control->current_reduction,
              .tx_power = tx_control->tx_power,
@@ -625,30 +1057,26 @@ void at86rf215_setup_iq_radio_transmit (at86rf215_st* dev, at86rf215_rf_channel_
              .digital_bw =tx_control->digital_bw,
              .fs = tx_control->fs, 
              .direct_modulation = 0,
+        },
+        
+        // 5. Configure the channel parameters, see section "Channel Configuration" on page 62 and transmit power
+        .freq_hz = freq_hz,
     };
     
-    at86rf215_radio_setup_tx_ctrl(dev, radio, &tx_ctrl);
-    
-    // 5. Configure the channel parameters, see section "Channel Configuration" on page 62 and transmit power
-    at86rf215_setup_channel(dev, radio, freq_hz);
+    at86rf215_radio_config_apply(dev, radio, &radio_cfg);
     
     // 6. [Optional] Perform Energy measurement ...
     
     // 7. Switch to TX/RX (transceiver) preparation mode
     ZF_LOGD("Switching to TX preparation mode  ...");
     
-    at86rf215_radio_set_state(dev, radio, at86rf215_radio_state_cmd_tx_prep); 
+    at86rf215_trx_ready_clear(dev, radio);
+    int set_state_ret = at86rf215_radio_set_state(dev, radio, at86rf215_radio_state_cmd_tx_prep);
     
     // Wait for external interrupt event (for 2.4GHz or sub-GHz) ...
-    if(radio == at86rf215_rf_channel_2400mhz){
-       event_node_wait_ready(&dev->events.hi_trx_ready_event);
-       ZF_LOGD("Get hi_trx_ready_event for 2.4GHz - OK ...");
-       
-    }
-    
-    if(radio == at86rf215_rf_channel_900mhz){
-       event_node_wait_ready(&dev->events.lo_trx_ready_event);
-       ZF_LOGD("Get hi_trx_ready_event for sub-GHz - OK ...");
+    if (at86rf215_wait_trx_ready(dev, radio, set_state_ret) != 0)
+    {
+        return;
     }
     
     // Get I/Q sync status ...
@@ -665,6 +1093,7 @@ void at86rf215_setup_iq_radio_transmit (at86rf215_st* dev, at86rf215_rf_channel_
 void at86rf215_setup_iq_radio_receive (at86rf215_st* dev, at86rf215_rf_channel_en radio, uint64_t freq_hz, at86rf215_rx_control_st *rx_control,
                                         int iqloopback, at86rf215_iq_clock_data_skew_en skew)
 {
+    at86rf215_trace_mark(dev, "setup_rx");
     /*
     It is assumed, that
         1. the radio has been reset before and is in State TRXOFF.
@@ -674,74 +1103,75 @@ void at86rf215_setup_iq_radio_receive (at86rf215_st* dev, at86rf215_rf_channel_e
     // 1. Set TRXOFF mode
     at86rf215_radio_set_state(dev, radio, at86rf215_radio_state_cmd_trx_off);
 
-
-    // 2. Enable all radio interrupts in 09,_24_IRQS
-    at86rf215_radio_irq_st int_mask = {
-        .wake_up_por = 1,
-        .trx_ready = 1,
-        .energy_detection_complete = 1,
-        .battery_low = 1,
-        .trx_error = 1,
-        .IQ_if_sync_fail = 1,
-        .res = 0,
-    };
-
-    at86rf215_radio_setup_interrupt_mask(dev, radio, &int_mask);
-
-    // 3. Enable I/Q radio mode - setting IQIFC1.CHPM=1 at AT86RF215 (in AT86RF215IQ it is the only choice)
-    at86rf215_iq_interface_config_st iq_if_config =
+    // Steps 2. - 5. - only registers which differ from the last applied state are sent (one SPI message) ...
+    at86rf215_radio_config_st radio_cfg =
     {
-        .loopback_enable = iqloopback,
-        .drv_strength = at86rf215_iq_drive_current_4ma,
-        .common_mode_voltage = at86rf215_iq_common_mode_v_ieee1596_1v2,
-        .tx_control_with_iq_if = false,
-        .radio09_mode = at86rf215_iq_if_mode,
-        .radio24_mode = at86rf215_iq_if_mode,
-        .clock_skew = skew,
-    };
-
-    at86rf215_setup_iq_if(dev, &iq_if_config);
-
-    // 4. Configure the Receiving Frontend:
-    //      Set the receiver analog frontend sub-registers RXBWC.BW and RXBWC.IFS,
-    //      Set the receiver digital frontend sub-registers RXDFE.SR and RXDFE.RCUT
-    //      Set the AGC registers RFn_AGCC and RFn_AGCS
-    at86rf215_radio_set_rx_bw_samp_st rx_bw_samp_cfg =
-    {
-        .inverter_sign_if = 0,  // A value of one configures the receiver to implement the inverted-sign IF freq.
-        .shift_if_freq = 0,     // A value of one configures the receiver to shift the IF frequency by factor of 1.25.
-        .bw = rx_control->radio_rx_bw,
-                                // The sub-register controls the receiver filter bandwidth settings - default: at86rf215_radio_rx_bw_BW2000KHZ_IF2000KHZ
-        .fcut = rx_control->digital_bw,
-                                // RX filter relative cut-off frequency - default: at86rf215_radio_rx_f_cut_half_fs
-        .fs = rx_control->fs,
-                                // RX Sample Rate - example: at86rf215_radio_rx_sample_rate_4000khz
-    };
+        .sections = AT86RF215_RADIO_CFG_IRQ_MASK | AT86RF215_RADIO_CFG_IQ_IF | AT86RF215_RADIO_CFG_RX_FRONTEND |
+                    AT86RF215_RADIO_CFG_AGC | AT86RF215_RADIO_CFG_CHANNEL,
 
-    at86rf215_radio_set_rx_bandwidth_sampling(dev, radio, &rx_bw_samp_cfg);
-
-    at86rf215_radio_agc_ctrl_st agc_ctrl =
-    {
-        // commands
-        .agc_measure_source_not_filtered = 0,           // AGC Input (0 - filterred, 1 - unfiltered, faster operation)
-        .avg = rx_control->agc_averaging,               // AGC Average Time in Number of Samples - default: at86rf215_radio_agc_averaging_8
-        .reset_cmd = 0,                                 // AGC Reset - resets the AGC and sets the maximum receiver gain.
-        .freeze_cmd = 0,                                // AGC Freeze Control - A value of one forces the AGC to
-                                                        // freeze to its current value.
-        .enable_cmd = rx_control->agc_enable,           // AGC Enable - a value of zero allows a manual setting of
-                                                        // the RX gain control by sub-register AGCS.GCW
-        .att = rx_control->agc_relative_atten,          // AGC Target Level - sets the AGC target level relative to ADC full scale - default: at86rf215_radio_agc_relative_atten_21_db
-        .gain_control_word = rx_control->agc_gain,      // Very important: If AGCC_EN is set to 1, a read of bit AGCS.GCW indicates the current
-                                                        // receiver gain setting. If AGCC_EN is set to 0, a write access to GCW
-                                                        // manually sets the receiver gain. An integer value of 23 indicates
-                                                        // the maximum receiver gain; each integer step changes the gain by 3dB.
-        .freeze_status = 0,                             // AGC Freeze Status - A value of one indicates that the AGC is on hold.
+        // 2. Enable all radio interrupts in 09,_24_IRQS
+        .irq_mask =
+        {
+            .wake_up_por = 1,
+            .trx_ready = 1,
+            .energy_detection_complete = 1,
+            .battery_low = 1,
+            .trx_error = 1,
+            .IQ_if_sync_fail = 1,
+            .res = 0,
+        },
+
+        // 3. Enable I/Q radio mode - setting IQIFC1.CHPM=1 at AT86RF215 (in AT86RF215IQ it is the only choice)
+        .iq_if =
+        {
+            .loopback_enable = iqloopback,
+            .drv_strength = at86rf215_iq_drive_current_4ma,
+            .common_mode_voltage = at86rf215_iq_common_mode_v_ieee1596_1v2,
+            .tx_control_with_iq_if = false,
+            .radio09_mode = at86rf215_iq_if_mode,
+            .radio24_mode = at86rf215_iq_if_mode,
+            .clock_skew = skew,
+        },
+
+        // 4. Configure the Receiving Frontend:
+        //      Set the receiver analog frontend sub-registers RXBWC.BW and RXBWC.IFS,
+        //      Set the receiver digital frontend sub-registers RXDFE.SR and RXDFE.RCUT
+        //      Set the AGC registers RFn_AGCC and RFn_AGCS
+        .rx_bw_samp =
+        {
+            .inverter_sign_if = 0,  // A value of one configures the receiver to implement the inverted-sign IF freq.
+            .shift_if_freq = 0,     // A value of one configures the receiver to shift the IF frequency by factor of 1.25.
+            .bw = rx_control->radio_rx_bw,
+                                    // The sub-register controls the receiver filter bandwidth settings - default: at86rf215_radio_rx_bw_BW2000KHZ_IF2000KHZ
+            .fcut = rx_control->digital_bw,
+                                    // RX filter relative cut-off frequency - default: at86rf215_radio_rx_f_cut_half_fs
+            .fs = rx_control->fs,
+                                    // RX Sample Rate - example: at86rf215_radio_rx_sample_rate_4000khz
+        },
+
+        .agc =
+        {
+            // commands
+            .agc_measure_source_not_filtered = 0,           // AGC Input (0 - filterred, 1 - unfiltered, faster operation)
+            .avg = rx_control->agc_averaging,               // AGC Average Time in Number of Samples - default: at86rf215_radio_agc_averaging_8
+            .reset_cmd = 0,                                 // AGC Reset - resets the AGC and sets the maximum receiver gain.
+            .freeze_cmd = 0,                                // AGC Freeze Control - A value of one forces the AGC to
+                                                            // freeze to its current value.
+            .enable_cmd = rx_control->agc_enable,           // AGC Enable - a value of zero allows a manual setting of
+                                                            // the RX gain control by sub-register AGCS.GCW
+            .att = rx_control->agc_relative_atten,          // AGC Target Level - sets the AGC target level relative to ADC full scale - default: at86rf215_radio_agc_relative_atten_21_db
+            .gain_control_word = rx_control->agc_gain,      // Very important: If AGCC_EN is set to 1, a read of bit AGCS.GCW indicates the current
+                                                            // receiver gain setting. If AGCC_EN is set to 0, a write access to GCW
+                                                            // manually sets the receiver gain. An integer value of 23 indicates
+                                                            // the maximum receiver gain; each integer step changes the gain by 3dB.
+            .freeze_status = 0,                             // AGC Freeze Status - A value of one indicates that the AGC is on hold.
+        },
+
+        // 5. Configure the channel parameters, see section "Channel Configuration" on page 62 and transmit power
+        .freq_hz = freq_hz,
     };
 
-    at86rf215_radio_setup_agc(dev, radio, &agc_ctrl);
-
-    // 5. Configure the channel parameters, see section "Channel Configuration" on page 62 and transmit power
-    at86rf215_setup_channel (dev, radio, freq_hz);
+    at86rf215_radio_config_apply(dev, radio, &radio_cfg);
 
     // 6. Switch to State TXPREP; interrupt IRQS.TRXRDY is issued.
     //    TXD and TXCLK are activated as shown in Figure 4-12 on page 26.
@@ -752,17 +1182,13 @@ void at86rf215_setup_iq_radio_receive (at86rf215_st* dev, at86rf215_rf_channel_e
 
     ZF_LOGD("Switching to TX/RX (transceiver) preparation mode  ...");
 
-    at86rf215_radio_set_state(dev, radio, at86rf215_radio_state_cmd_tx_prep);
+    at86rf215_trx_ready_clear(dev, radio);
+    int set_state_ret = at86rf215_radio_set_state(dev, radio, at86rf215_radio_state_cmd_tx_prep);
 
     // Wait for external interrupt event (for 2.4GHz or sub-GHz) ...
-    if(radio == at86rf215_rf_channel_2400mhz){
-       event_node_wait_ready(&dev->events.hi_trx_ready_event);
-       ZF_LOGD("Get hi_trx_ready_event for 2.4GHz - OK ...");
-    }
-
-    if(radio == at86rf215_rf_channel_900mhz){
-       event_node_wait_ready(&dev->events.lo_trx_ready_event);
-       ZF_LOGD("Get hi_trx_ready_event for sub-GHz - OK ...");
+    if (at86rf215_wait_trx_ready(dev, radio, set_state_ret) != 0)
+    {
+        return;
     }
 
     // 8. Enable the radio receiver by writing command RX to the register RFn_CMD.
@@ -773,7 +1199,7 @@ void at86rf215_setup_iq_radio_receive (at86rf215_st* dev, at86rf215_rf_channel_e
     //    after reception of the preamble, the AGC has to be released after finishing reception by setting AGCC.FRZC=0.
     /*
     if(rx_control->agc_enable){
-       at86rf215_radio_setup_agc(dev, radio, &agc_ctrl);
+       at86rf215_radio_setup_agc(dev, radio, &radio_cfg.agc);
     }
     */
 }
@@ -832,9 +1258,12 @@ void at86rf215_setup_iq_radio_dac_value_override_no_freq (at86rf215_st* dev,
         .fs = at86rf215_radio_rx_sample_rate_4000khz,
         .direct_modulation = 0,
     };
+    
+    at86rf215_batch_begin(dev);
     at86rf215_radio_setup_tx_ctrl(dev, ch, &tx_config);
-
     at86rf215_radio_set_tx_dac_input_iq(dev, ch, 1, 0x7E, 1, 0x3F);
+    at86rf215_batch_commit(dev);
+    
     at86rf215_radio_set_state(dev, ch, at86rf215_radio_state_cmd_tx);
 }
 
@@ -876,6 +1305,9 @@ void at86rf215_setup_iq_radio_dac_value_override (at86rf215_st* dev,
         .fs = at86rf215_radio_rx_sample_rate_4000khz,
         .direct_modulation = 0,
     };
+    
+    // Configuration is queued and sent as one SPI message ...
+    at86rf215_batch_begin(dev);
     at86rf215_radio_setup_tx_ctrl(dev, ch, &tx_config);
 
     at86rf215_radio_external_ctrl_st aux_cfg =
@@ -903,5 +1335,7 @@ void at86rf215_setup_iq_radio_dac_value_override (at86rf215_st* dev,
     at86rf215_setup_iq_if(dev, &iq_if_config);
     at86rf215_radio_set_tx_dac_input_iq(dev, ch, 1, 0x7E, 1, 0x3F);
     at86rf215_setup_channel (dev, ch, freq_hz);
+    at86rf215_batch_commit(dev);
+    
     at86rf215_radio_set_state(dev, ch, at86rf215_radio_state_cmd_tx);
 }
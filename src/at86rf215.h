@@ -30,10 +30,30 @@ typedef struct{
     at86rf215_radio_agc_averaging_en agc_averaging;
 } at86rf215_rx_control_st; // Rx control top - at86rf215_tx_control_st ...
 
+// Radio configuration sections (at86rf215_radio_config_st.sections) ...
+#define AT86RF215_RADIO_CFG_IQ_IF       0x01    // IQIFC0, IQIFC1 (common for both radios)
+#define AT86RF215_RADIO_CFG_IRQ_MASK    0x02    // IRQM
+#define AT86RF215_RADIO_CFG_CHANNEL     0x04    // CS, CCF0L, CCF0H, CNL, CNM
+#define AT86RF215_RADIO_CFG_RX_FRONTEND 0x08    // RXBWC, RXDFE
+#define AT86RF215_RADIO_CFG_AGC         0x10    // AGCC, AGCS
+#define AT86RF215_RADIO_CFG_TX_FRONTEND 0x20    // TXCUTC, TXDFE, PAC
+
+// Global structures - desired radio state (at86rf215_radio_config_apply) ...
+typedef struct{
+    uint32_t sections;                              // AT86RF215_RADIO_CFG_* - only these parts are applied
+    at86rf215_iq_interface_config_st iq_if;
+    at86rf215_radio_irq_st irq_mask;
+    uint64_t freq_hz;
+    at86rf215_radio_set_rx_bw_samp_st rx_bw_samp;
+    at86rf215_radio_agc_ctrl_st agc;
+    at86rf215_radio_tx_ctrl_st tx;
+} at86rf215_radio_config_st;
+
 int at86rf215_init(at86rf215_st* dev);
 int at86rf215_close(at86rf215_st* dev, int reset_dev);
 void at86rf215_reset(at86rf215_st* dev);
 void at86rf215_chip_reset_with_spi(at86rf215_st* dev);
+int at86rf215_calibrate_device(at86rf215_st* dev, at86rf215_rf_channel_en ch, int* i_val, int* q_val);
 
 void at86rf215_get_versions(at86rf215_st* dev, uint8_t *pn, uint8_t *vn);
 int at86rf215_print_version(at86rf215_st* dev);
@@ -46,6 +66,7 @@ void at86rf215_setup_rf_irq(at86rf215_st* dev,  uint8_t active_low,
 void at86rf215_set_xo_trim(at86rf215_st* dev, uint8_t fast_start, float cap_trim);
 void at86rf215_get_iq_if_cfg(at86rf215_st* dev, at86rf215_iq_interface_config_st* cfg, int verbose);
 void at86rf215_setup_iq_if(at86rf215_st* dev, at86rf215_iq_interface_config_st* cfg);
+void at86rf215_pack_iq_if(at86rf215_iq_interface_config_st* cfg, uint8_t *data);
 void at86rf215_setup_iq_radio_transmit(at86rf215_st* dev, at86rf215_rf_channel_en radio, uint64_t freq_hz, at86rf215_tx_control_st *tx_control,
                                          int iqloopback, at86rf215_iq_clock_data_skew_en skew);
 void at86rf215_setup_iq_radio_receive(at86rf215_st *dev, at86rf215_rf_channel_en radio, uint64_t freq_hz, at86rf215_rx_control_st *rx_control,
@@ -63,11 +84,72 @@ double at86rf215_check_freq (at86rf215_st* dev, at86rf215_rf_channel_en ch, uint
 
 void at86rf215_get_iq_sync_status(at86rf215_st* dev);
 
+// SPI CLOCK ...
+int at86rf215_spi_characterize(at86rf215_st* dev, int force);
+
+// RADIO CONFIGURATION ...
+int at86rf215_radio_config_apply(at86rf215_st* dev, at86rf215_rf_channel_en radio, at86rf215_radio_config_st* cfg);
+
+// REGISTER SHADOW ...
+void at86rf215_regcache_enable(at86rf215_st* dev, int enable);
+void at86rf215_regcache_invalidate(at86rf215_st* dev);
+void at86rf215_regcache_get_stats(at86rf215_st* dev, at86rf215_regcache_stats_st* stats);
+void at86rf215_regcache_reset_stats(at86rf215_st* dev);
+
+// ASYNCHRONOUS SPI ENGINE ...
+int at86rf215_async_start(at86rf215_st* dev);
+void at86rf215_async_stop(at86rf215_st* dev);
+int at86rf215_async_submit(at86rf215_st* dev, at86rf215_async_sqe_st* sqe, int count);
+int at86rf215_async_poll(at86rf215_st* dev, at86rf215_async_cqe_st* cqe);
+int at86rf215_async_wait(at86rf215_st* dev, at86rf215_async_cqe_st* cqe, int timeout_ms);
+int at86rf215_async_get_eventfd(at86rf215_st* dev);
+
+// SPI BUS ARBITER ...
+void at86rf215_bus_get_stats(at86rf215_st* dev, at86rf215_bus_stats_st* stats);
+void at86rf215_bus_reset_stats(at86rf215_st* dev);
+
+// SPI TRANSACTION TRACE ...
+void at86rf215_trace_enable(at86rf215_st* dev, int enable);
+void at86rf215_trace_mark(at86rf215_st* dev, const char* label);
+int at86rf215_trace_dump(at86rf215_st* dev, const char* path);
+int at86rf215_trace_dump_on_signal(at86rf215_st* dev, int signo, const char* path);
+
+// RAW DEVICE ACCESS (no configuration, no IRQ thread - session replay) ...
+int at86rf215_open_io(at86rf215_st* dev);
+void at86rf215_close_io(at86rf215_st* dev);
+
+// SOFTWARE EMULATOR ...
+int at86rf215_emu_get_stats(at86rf215_st* dev, at86rf215_emu_stats_st* stats);
+
+// IRQ DISPATCH ...
+int at86rf215_get_event_fd(at86rf215_st* dev);
+int at86rf215_process_events(at86rf215_st* dev);
+int at86rf215_irq_poll(at86rf215_st* dev);
+int at86rf215_wait_event(at86rf215_st* dev, event_st* ev, uint32_t timeout_us);
+void at86rf215_get_irq_wake_stats(at86rf215_st* dev, gpio_wake_stats_s* stats);
+void at86rf215_reset_irq_wake_stats(at86rf215_st* dev);
+void at86rf215_get_irq_latency(at86rf215_st* dev, at86rf215_irq_latency_st* snap);
+void at86rf215_reset_irq_latency(at86rf215_st* dev);
+void at86rf215_irq_latency_record(at86rf215_st* dev, at86rf215_irq_lat_stage_en stage, uint64_t ns);
+void at86rf215_irq_latency_waiter(at86rf215_st* dev, event_st* ev);
+uint64_t at86rf215_irq_latency_bin_ns(int bin);
+const char* at86rf215_irq_latency_stage_name(at86rf215_irq_lat_stage_en stage);
+void at86rf215_set_irq_observer(at86rf215_st* dev, at86rf215_irq_observer_ft observer, void* user);
+void at86rf215_irq_observer_print(at86rf215_st* dev, const uint8_t irqs[4], void* user);
+at86rf215_irq_sub_st* at86rf215_irq_subscribe(at86rf215_st* dev, int bit, at86rf215_irq_handler_ft callback, void* user);
+at86rf215_irq_sub_st* at86rf215_irq_subscribe_event(at86rf215_st* dev, int bit, event_st* event);
+int at86rf215_irq_unsubscribe(at86rf215_st* dev, at86rf215_irq_sub_st* sub);
+
 // EVENTS ...
 void event_node_init(event_st* ev);
 void event_node_close(event_st* ev);
 void event_node_wait_ready(event_st* ev);
+int event_node_wait_until(event_st* ev, uint64_t deadline_ns);
+int event_node_try_wait(event_st* ev);
+int event_node_wait_timeout(event_st* ev, uint32_t timeout_us);
 void event_node_signal_ready(event_st* ev, int ready);
+void event_node_get_stats(event_st* ev, event_stats_st* stats);
+void event_node_reset_stats(event_st* ev);
 
 #ifdef __cplusplus
 }
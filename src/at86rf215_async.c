@@ -0,0 +1,459 @@
+#ifndef ZF_LOG_LEVEL
+    #define ZF_LOG_LEVEL ZF_LOG_VERBOSE
+#endif
+
+#define ZF_LOG_DEF_SRCLOC ZF_LOG_SRCLOC_LONG
+#define ZF_LOG_TAG "AT86RF215_Async"
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sched.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/eventfd.h>
+#include "zf_log/zf_log.h"
+#include "at86rf215.h"
+
+#define ASYNC_RING_MASK (AT86RF215_ASYNC_RING_SIZE - 1)
+
+//===================================================================
+// Bounded MPMC ring (per slot sequence numbers) - lock-free for any number of producers / consumers
+static void at86rf215_async_ring_init(at86rf215_async_ring_st *ring)
+{
+    for (size_t i = 0; i < AT86RF215_ASYNC_RING_SIZE; i++)
+    {
+        __atomic_store_n(&ring->cell[i].seq, i, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&ring->enqueue_pos, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&ring->dequeue_pos, 0, __ATOMIC_RELAXED);
+}
+
+//===================================================================
+// at86rf215_async_ring_reserve - claim a free slot, returns NULL if the ring is full
+static at86rf215_async_cell_st* at86rf215_async_ring_reserve(at86rf215_async_ring_st *ring, size_t *pos_out)
+{
+    size_t pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+
+    for (;;)
+    {
+        at86rf215_async_cell_st *cell = &ring->cell[pos & ASYNC_RING_MASK];
+        size_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+
+        if (dif == 0)
+        {
+            if (__atomic_compare_exchange_n(&ring->enqueue_pos, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                *pos_out = pos;
+                return cell;
+            }
+        }
+        else if (dif < 0)
+        {
+            return NULL;
+        }
+        else
+        {
+            pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+//===================================================================
+// at86rf215_async_ring_take - claim a filled slot, returns NULL if the ring is empty
+static at86rf215_async_cell_st* at86rf215_async_ring_take(at86rf215_async_ring_st *ring, size_t *pos_out)
+{
+    size_t pos = __atomic_load_n(&ring->dequeue_pos, __ATOMIC_RELAXED);
+
+    for (;;)
+    {
+        at86rf215_async_cell_st *cell = &ring->cell[pos & ASYNC_RING_MASK];
+        size_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+
+        if (dif == 0)
+        {
+            if (__atomic_compare_exchange_n(&ring->dequeue_pos, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                *pos_out = pos;
+                return cell;
+            }
+        }
+        else if (dif < 0)
+        {
+            return NULL;
+        }
+        else
+        {
+            pos = __atomic_load_n(&ring->dequeue_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+//===================================================================
+static int at86rf215_async_ring_push_sqe(at86rf215_async_ring_st *ring, const at86rf215_async_sqe_st *sqe)
+{
+    size_t pos = 0;
+    at86rf215_async_cell_st *cell = at86rf215_async_ring_reserve(ring, &pos);
+    if (cell == NULL) return -1;
+
+    cell->sqe = *sqe;
+    __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+//===================================================================
+static int at86rf215_async_ring_pop_sqe(at86rf215_async_ring_st *ring, at86rf215_async_sqe_st *sqe)
+{
+    size_t pos = 0;
+    at86rf215_async_cell_st *cell = at86rf215_async_ring_take(ring, &pos);
+    if (cell == NULL) return 0;
+
+    *sqe = cell->sqe;
+    __atomic_store_n(&cell->seq, pos + AT86RF215_ASYNC_RING_SIZE, __ATOMIC_RELEASE);
+    return 1;
+}
+
+//===================================================================
+static int at86rf215_async_ring_push_cqe(at86rf215_async_ring_st *ring, const at86rf215_async_cqe_st *cqe)
+{
+    size_t pos = 0;
+    at86rf215_async_cell_st *cell = at86rf215_async_ring_reserve(ring, &pos);
+    if (cell == NULL) return -1;
+
+    cell->cqe = *cqe;
+    __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+//===================================================================
+static int at86rf215_async_ring_pop_cqe(at86rf215_async_ring_st *ring, at86rf215_async_cqe_st *cqe)
+{
+    size_t pos = 0;
+    at86rf215_async_cell_st *cell = at86rf215_async_ring_take(ring, &pos);
+    if (cell == NULL) return 0;
+
+    *cqe = cell->cqe;
+    __atomic_store_n(&cell->seq, pos + AT86RF215_ASYNC_RING_SIZE, __ATOMIC_RELEASE);
+    return 1;
+}
+
+//===================================================================
+static int at86rf215_async_ring_empty(at86rf215_async_ring_st *ring)
+{
+    return __atomic_load_n(&ring->enqueue_pos, __ATOMIC_SEQ_CST) == __atomic_load_n(&ring->dequeue_pos, __ATOMIC_SEQ_CST);
+}
+
+//===================================================================
+static int at86rf215_async_ring_full(at86rf215_async_ring_st *ring)
+{
+    return __atomic_load_n(&ring->enqueue_pos, __ATOMIC_SEQ_CST) - __atomic_load_n(&ring->dequeue_pos, __ATOMIC_SEQ_CST) >= AT86RF215_ASYNC_RING_SIZE;
+}
+
+//===================================================================
+// at86rf215_async_wait_cq_room - completion ring full: the worker sleeps until a reaper frees a slot (or stop)
+static void at86rf215_async_wait_cq_room(at86rf215_async_st *as)
+{
+    uint64_t cnt = 0;
+
+    // Announce the sleep, re-check (a reaper may have missed the flag) and block ...
+    __atomic_store_n(&as->cq_full, 1, __ATOMIC_SEQ_CST);
+    if (at86rf215_async_ring_full(&as->cq) && __atomic_load_n(&as->running, __ATOMIC_SEQ_CST))
+    {
+        struct pollfd pfd = { .fd = as->room_efd, .events = POLLIN };
+        poll(&pfd, 1, -1);
+        if (read(as->room_efd, &cnt, sizeof(cnt)) < 0) { /* EAGAIN - spurious wake up */ }
+    }
+    __atomic_store_n(&as->cq_full, 0, __ATOMIC_SEQ_CST);
+}
+
+//===================================================================
+// at86rf215_async_reap - one completion off the ring, a worker blocked on the full ring is woken
+static int at86rf215_async_reap(at86rf215_async_st *as, at86rf215_async_cqe_st *cqe)
+{
+    uint64_t cnt = 1;
+
+    if (!at86rf215_async_ring_pop_cqe(&as->cq, cqe)) return 0;
+
+    // Pairs with the cq_full store in the worker ...
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&as->cq_full, __ATOMIC_SEQ_CST))
+    {
+        if (write(as->room_efd, &cnt, sizeof(cnt)) < 0) { /* counter saturated - worker is awake */ }
+    }
+    return 1;
+}
+
+//===================================================================
+static inline uint64_t at86rf215_async_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+//===================================================================
+// at86rf215_async_execute - one submission on the worker thread
+static int at86rf215_async_execute(at86rf215_st* dev, at86rf215_async_sqe_st *sqe)
+{
+    if (sqe->op == at86rf215_async_op_write)
+    {
+        if (sqe->size > 255) return at86rf215_write_burst(dev, sqe->addr, sqe->buffer, sqe->size);
+        return at86rf215_write_buffer(dev, sqe->addr, sqe->buffer, sqe->size);
+    }
+
+    if (sqe->size > 255) return at86rf215_read_burst(dev, sqe->addr, sqe->buffer, sqe->size);
+    return at86rf215_read_buffer(dev, sqe->addr, sqe->buffer, sqe->size);
+}
+
+//===================================================================
+static void *at86rf215_async_worker(void *arg)
+{
+    at86rf215_st* dev = (at86rf215_st*)arg;
+    at86rf215_async_st *as = &dev->async;
+    at86rf215_async_sqe_st sqe;
+    uint64_t cnt = 0;
+
+    while (__atomic_load_n(&as->running, __ATOMIC_ACQUIRE))
+    {
+        // High priority ring first - IRQ status reads overtake bulk traffic ...
+        if (at86rf215_async_ring_pop_sqe(&as->sq_hi, &sqe) || at86rf215_async_ring_pop_sqe(&as->sq, &sqe))
+        {
+            // Requests from the high priority ring keep their class on the SPI bus arbiter too ...
+            at86rf215_bus_set_thread_priority(sqe.high_priority ? at86rf215_bus_prio_high : at86rf215_bus_prio_normal);
+
+            at86rf215_async_cqe_st cqe = { .tag = sqe.tag, .result = at86rf215_async_execute(dev, &sqe) };
+
+            // Completion ring full - sleep until the caller reaps (no spinning - the worker may run SCHED_FIFO
+            // on the reaper's CPU) ...
+            while (at86rf215_async_ring_push_cqe(&as->cq, &cqe) < 0 && __atomic_load_n(&as->running, __ATOMIC_ACQUIRE))
+            {
+                at86rf215_async_wait_cq_room(as);
+            }
+
+            cnt = 1;
+            if (write(as->cq_efd, &cnt, sizeof(cnt)) < 0) { /* counter saturated - readers are woken anyway */ }
+            continue;
+        }
+
+        // Nothing to do - announce sleep, re-check (submitter may have missed the flag) and block ...
+        __atomic_store_n(&as->idle, 1, __ATOMIC_SEQ_CST);
+        if (at86rf215_async_ring_empty(&as->sq_hi) && at86rf215_async_ring_empty(&as->sq) &&
+            __atomic_load_n(&as->running, __ATOMIC_SEQ_CST))
+        {
+            struct pollfd pfd = { .fd = as->sq_efd, .events = POLLIN };
+            poll(&pfd, 1, -1);
+            if (read(as->sq_efd, &cnt, sizeof(cnt)) < 0) { /* EAGAIN - spurious wake up */ }
+        }
+        __atomic_store_n(&as->idle, 0, __ATOMIC_SEQ_CST);
+    }
+
+    return NULL;
+}
+
+//===================================================================
+static void at86rf215_async_doorbell(at86rf215_async_st *as)
+{
+    uint64_t cnt = 1;
+    if (write(as->sq_efd, &cnt, sizeof(cnt)) < 0) { /* counter saturated - worker is awake */ }
+}
+
+//===================================================================
+int at86rf215_async_start(at86rf215_st* dev)
+{
+    at86rf215_async_st *as = &dev->async;
+
+    if (as->running)
+    {
+        return 0;
+    }
+
+    at86rf215_async_ring_init(&as->sq_hi);
+    at86rf215_async_ring_init(&as->sq);
+    at86rf215_async_ring_init(&as->cq);
+
+    as->sq_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    as->cq_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    as->room_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (as->sq_efd < 0 || as->cq_efd < 0 || as->room_efd < 0)
+    {
+        ZF_LOGE("eventfd creation failed");
+        if (as->sq_efd >= 0) close(as->sq_efd);
+        if (as->cq_efd >= 0) close(as->cq_efd);
+        if (as->room_efd >= 0) close(as->room_efd);
+        return -1;
+    }
+
+    as->idle = 0;
+    as->cq_full = 0;
+    as->submitters = 0;
+    as->waiters = 0;
+    as->running = 1;
+
+    if (pthread_create(&as->worker, NULL, at86rf215_async_worker, (void*)dev) != 0)
+    {
+        ZF_LOGE("SPI worker thread creation failed");
+        as->running = 0;
+        close(as->sq_efd);
+        close(as->cq_efd);
+        close(as->room_efd);
+        return -1;
+    }
+
+    // Same policy / CPUs as the IRQ thread (at86rf215_st.irq_thread_*) ...
+    if (dev->io.irq_event.attr.policy != SCHED_OTHER || dev->io.irq_event.attr.cpu_mask != 0)
+    {
+        if (gpio_thread_attr_apply(as->worker, &dev->io.irq_event.attr) != 0) ZF_LOGW("SPI worker scheduling not applied");
+    }
+
+    return 0;
+}
+
+//===================================================================
+void at86rf215_async_stop(at86rf215_st* dev)
+{
+    at86rf215_async_st *as = &dev->async;
+
+    if (!as->running)
+    {
+        return;
+    }
+
+    at86rf215_async_sqe_st sqe;
+    uint64_t cnt = 1;
+    int dropped = 0;
+
+    __atomic_store_n(&as->running, 0, __ATOMIC_SEQ_CST);
+    at86rf215_async_doorbell(as);
+    if (write(as->room_efd, &cnt, sizeof(cnt)) < 0) { /* counter saturated - worker is awake */ }
+    pthread_join(as->worker, NULL);
+
+    // Submitters which passed the running check finish queueing first ...
+    while (__atomic_load_n(&as->submitters, __ATOMIC_SEQ_CST) > 0)
+    {
+        sched_yield();
+    }
+
+    // Entries the worker did not reach complete with -ECANCELED ...
+    while (at86rf215_async_ring_pop_sqe(&as->sq_hi, &sqe) || at86rf215_async_ring_pop_sqe(&as->sq, &sqe))
+    {
+        at86rf215_async_cqe_st cqe = { .tag = sqe.tag, .result = -ECANCELED };
+        if (at86rf215_async_ring_push_cqe(&as->cq, &cqe) < 0) dropped++;
+    }
+
+    if (dropped > 0)
+    {
+        ZF_LOGW("%d cancelled completions dropped - completion ring full", dropped);
+    }
+
+    // Wake blocked waiters (they reap the rest, then see the engine stopped) before the eventfds go away ...
+    while (__atomic_load_n(&as->waiters, __ATOMIC_SEQ_CST) > 0)
+    {
+        if (write(as->cq_efd, &cnt, sizeof(cnt)) < 0) { /* counter saturated - waiters are woken anyway */ }
+        usleep(100);
+    }
+
+    close(as->sq_efd);
+    close(as->cq_efd);
+    close(as->room_efd);
+}
+
+//===================================================================
+// at86rf215_async_submit - queue up to count entries, returns number queued (-1 engine not running)
+int at86rf215_async_submit(at86rf215_st* dev, at86rf215_async_sqe_st* sqe, int count)
+{
+    at86rf215_async_st *as = &dev->async;
+    int queued = 0;
+
+    // Announce the submitter before the running check (pairs with at86rf215_async_stop) ...
+    __atomic_add_fetch(&as->submitters, 1, __ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&as->running, __ATOMIC_SEQ_CST))
+    {
+        __atomic_sub_fetch(&as->submitters, 1, __ATOMIC_SEQ_CST);
+        return -1;
+    }
+
+    for (; queued < count; queued++)
+    {
+        at86rf215_async_ring_st *ring = sqe[queued].high_priority ? &as->sq_hi : &as->sq;
+        if (at86rf215_async_ring_push_sqe(ring, &sqe[queued]) < 0) break;
+    }
+
+    // Wake the worker only if it is going to sleep (pairs with the idle store in the worker) ...
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (queued > 0 && __atomic_load_n(&as->idle, __ATOMIC_SEQ_CST))
+    {
+        at86rf215_async_doorbell(as);
+    }
+
+    __atomic_sub_fetch(&as->submitters, 1, __ATOMIC_SEQ_CST);
+    return queued;
+}
+
+//===================================================================
+// at86rf215_async_poll - reap one completion without blocking, returns 1 if cqe is filled
+int at86rf215_async_poll(at86rf215_st* dev, at86rf215_async_cqe_st* cqe)
+{
+    return at86rf215_async_reap(&dev->async, cqe);
+}
+
+//===================================================================
+// at86rf215_async_wait - reap one completion, returns 1 if cqe is filled, 0 on timeout (timeout_ms < 0 - forever),
+// -1 if the engine is stopped and no completion is left
+int at86rf215_async_wait(at86rf215_st* dev, at86rf215_async_cqe_st* cqe, int timeout_ms)
+{
+    at86rf215_async_st *as = &dev->async;
+    uint64_t deadline = (timeout_ms > 0) ? at86rf215_async_now_ns() + (uint64_t)timeout_ms * 1000000 : 0;
+    uint64_t cnt = 0;
+    int ret = 0;
+
+    // Announce the waiter before the running check (pairs with at86rf215_async_stop) ...
+    __atomic_add_fetch(&as->waiters, 1, __ATOMIC_SEQ_CST);
+
+    for (;;)
+    {
+        if (at86rf215_async_reap(as, cqe))
+        {
+            ret = 1;
+            break;
+        }
+
+        if (!__atomic_load_n(&as->running, __ATOMIC_SEQ_CST))
+        {
+            ret = -1;
+            break;
+        }
+
+        // One deadline for the whole call - a waiter which lost the completion to another one polls the rest only ...
+        int left_ms = timeout_ms;
+        if (timeout_ms > 0)
+        {
+            uint64_t now = at86rf215_async_now_ns();
+            left_ms = (now < deadline) ? (int)((deadline - now + 999999) / 1000000) : 0;
+        }
+
+        struct pollfd pfd = { .fd = as->cq_efd, .events = POLLIN };
+        if (poll(&pfd, 1, left_ms) <= 0)
+        {
+            ret = at86rf215_async_reap(as, cqe);
+            break;
+        }
+
+        // Several waiters may be woken - the loser gets EAGAIN and re-checks the ring ...
+        if (read(as->cq_efd, &cnt, sizeof(cnt)) < 0) { /* EAGAIN */ }
+    }
+
+    __atomic_sub_fetch(&as->waiters, 1, __ATOMIC_SEQ_CST);
+    return ret;
+}
+
+//===================================================================
+int at86rf215_async_get_eventfd(at86rf215_st* dev)
+{
+    return dev->async.running ? dev->async.cq_efd : -1;
+}
@@ -204,6 +204,36 @@ static const struct at86rf215_BBC_regs BBC1_regs = {
     .RG_CNT3       = 0x494,
 };
 
+#define AT86RF215_BB_REG_ADDR(c,r)  \
+            (((c)==at86rf215_rf_channel_900mhz)?(BBC0_regs.RG_##r):(BBC1_regs.RG_##r))
+
+// Frame buffer size (FBRXS - FBRXE, FBTXS - FBTXE)
+#define AT86RF215_BB_FRAME_BUFFER_SIZE  2047
+
+//==================================================================================
+// BBCn_FBRXS – RX frame buffer - one burst, split only at the spidev bufsiz limit
+int at86rf215_bb_read_rx_frame_buffer(at86rf215_st *dev, at86rf215_rf_channel_en ch, uint8_t *buffer, size_t size)
+{
+    if (size > AT86RF215_BB_FRAME_BUFFER_SIZE)
+    {
+        ZF_LOGE("frame buffer read of %zu bytes exceeds %d bytes", size, AT86RF215_BB_FRAME_BUFFER_SIZE);
+        return -1;
+    }
+    return at86rf215_read_burst(dev, AT86RF215_BB_REG_ADDR(ch, FBRXS), buffer, size);
+}
+
+//==================================================================================
+// BBCn_FBTXS – TX frame buffer - one burst, split only at the spidev bufsiz limit
+int at86rf215_bb_write_tx_frame_buffer(at86rf215_st *dev, at86rf215_rf_channel_en ch, const uint8_t *buffer, size_t size)
+{
+    if (size > AT86RF215_BB_FRAME_BUFFER_SIZE)
+    {
+        ZF_LOGE("frame buffer write of %zu bytes exceeds %d bytes", size, AT86RF215_BB_FRAME_BUFFER_SIZE);
+        return -1;
+    }
+    return at86rf215_write_burst(dev, AT86RF215_BB_REG_ADDR(ch, FBTXS), buffer, size);
+}
+
 // BBCn_PC – PHY Control
 // This register configures the baseband PHY.
 void at86rf215_bb_set_phy_control (at86rf215_st *dev, at86rf215_rf_channel_en ch, at86rf215_bb_phy_control_st* pc)
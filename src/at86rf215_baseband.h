@@ -204,6 +204,8 @@ typedef struct
 
 void at86rf215_bb_set_phy_control (at86rf215_st *dev, at86rf215_rf_channel_en ch, at86rf215_bb_phy_control_st* pc);
 void at86rf215_bb_get_phy_control (at86rf215_st *dev, at86rf215_rf_channel_en ch, at86rf215_bb_phy_control_st* pc);
+int at86rf215_bb_read_rx_frame_buffer(at86rf215_st *dev, at86rf215_rf_channel_en ch, uint8_t *buffer, size_t size);
+int at86rf215_bb_write_tx_frame_buffer(at86rf215_st *dev, at86rf215_rf_channel_en ch, const uint8_t *buffer, size_t size);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,153 @@
+#ifndef ZF_LOG_LEVEL
+    #define ZF_LOG_LEVEL ZF_LOG_VERBOSE
+#endif
+
+#define ZF_LOG_DEF_SRCLOC ZF_LOG_SRCLOC_LONG
+#define ZF_LOG_TAG "AT86RF215_Bus"
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "zf_log/zf_log.h"
+#include "at86rf215.h"
+
+// Arbiter word layout
+#define BUS_OWNED       0x1u
+#define BUS_SLEEPERS    0x2u
+#define BUS_HI_WAITER   0x4u    // One waiting high priority thread
+
+// Priority class of the calling thread (IRQ poll thread / async worker switch it to high)
+static __thread at86rf215_bus_prio_en bus_thread_prio = at86rf215_bus_prio_normal;
+
+//===================================================================
+static inline void at86rf215_bus_futex_wait(uint32_t *word, uint32_t val)
+{
+    syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+}
+
+//===================================================================
+static inline void at86rf215_bus_futex_wake_all(uint32_t *word)
+{
+    syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+//===================================================================
+static inline uint64_t at86rf215_bus_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+//===================================================================
+static void at86rf215_bus_record_wait(at86rf215_bus_stats_st *stats, int hi, uint64_t wait_ns)
+{
+    uint64_t usec = wait_ns / 1000;
+    int bin = (usec == 0) ? 0 : 64 - __builtin_clzll(usec);
+    if (bin >= AT86RF215_BUS_HIST_BINS) bin = AT86RF215_BUS_HIST_BINS - 1;
+
+    __atomic_add_fetch(&stats->acquired_slow[hi], 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->total_wait_ns[hi], wait_ns, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->wait_hist[hi][bin], 1, __ATOMIC_RELAXED);
+
+    uint64_t max = __atomic_load_n(&stats->max_wait_ns[hi], __ATOMIC_RELAXED);
+    while (wait_ns > max &&
+           !__atomic_compare_exchange_n(&stats->max_wait_ns[hi], &max, wait_ns, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+//===================================================================
+// at86rf215_bus_acquire_slow - bus is owned (or high priority requests wait) - sleep on the futex word
+static void at86rf215_bus_acquire_slow(at86rf215_st* dev, int hi)
+{
+    uint32_t *word = &dev->bus.word;
+    uint64_t t0 = at86rf215_bus_now_ns();
+
+    // Announce high priority waiter - normal requests stay behind it ...
+    if (hi) __atomic_add_fetch(word, BUS_HI_WAITER, __ATOMIC_RELAXED);
+
+    while (1)
+    {
+        uint32_t v = __atomic_load_n(word, __ATOMIC_RELAXED);
+
+        if (!(v & BUS_OWNED) && (hi || v < BUS_HI_WAITER))
+        {
+            // Taken over from the slow path - other sleepers may remain, release has to wake them ...
+            uint32_t nv = (v | BUS_OWNED | BUS_SLEEPERS) - (hi ? BUS_HI_WAITER : 0);
+            if (__atomic_compare_exchange_n(word, &v, nv, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) break;
+            continue;
+        }
+
+        if (!(v & BUS_SLEEPERS) &&
+            !__atomic_compare_exchange_n(word, &v, v | BUS_SLEEPERS, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+            continue;
+        }
+
+        at86rf215_bus_futex_wait(word, v | BUS_SLEEPERS);
+    }
+
+    at86rf215_bus_record_wait(&dev->bus.stats, hi, at86rf215_bus_now_ns() - t0);
+}
+
+//===================================================================
+// at86rf215_bus_acquire - own the SPI bus for one transaction (uncontended - one CAS)
+void at86rf215_bus_acquire(at86rf215_st* dev)
+{
+    uint32_t expected = 0;
+
+    if (__atomic_compare_exchange_n(&dev->bus.word, &expected, BUS_OWNED, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    {
+        return;
+    }
+
+    at86rf215_bus_acquire_slow(dev, bus_thread_prio == at86rf215_bus_prio_high);
+}
+
+//===================================================================
+void at86rf215_bus_release(at86rf215_st* dev)
+{
+    uint32_t old = __atomic_fetch_and(&dev->bus.word, ~(BUS_OWNED | BUS_SLEEPERS), __ATOMIC_RELEASE);
+
+    // All sleepers are woken - the priority rule decides who takes the bus ...
+    if (old & BUS_SLEEPERS)
+    {
+        at86rf215_bus_futex_wake_all(&dev->bus.word);
+    }
+}
+
+//===================================================================
+// at86rf215_bus_set_thread_priority - priority class of the calling thread, returns the previous one
+at86rf215_bus_prio_en at86rf215_bus_set_thread_priority(at86rf215_bus_prio_en prio)
+{
+    at86rf215_bus_prio_en prev = bus_thread_prio;
+    bus_thread_prio = prio;
+    return prev;
+}
+
+//===================================================================
+void at86rf215_bus_get_stats(at86rf215_st* dev, at86rf215_bus_stats_st* stats)
+{
+    uint64_t *src = (uint64_t *)&dev->bus.stats;
+    uint64_t *dst = (uint64_t *)stats;
+
+    for (size_t i = 0; i < sizeof(*stats) / sizeof(uint64_t); i++)
+    {
+        dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+    }
+}
+
+//===================================================================
+void at86rf215_bus_reset_stats(at86rf215_st* dev)
+{
+    uint64_t *p = (uint64_t *)&dev->bus.stats;
+
+    for (size_t i = 0; i < sizeof(dev->bus.stats) / sizeof(uint64_t); i++)
+    {
+        __atomic_store_n(&p[i], 0, __ATOMIC_RELAXED);
+    }
+}
@@ -114,11 +114,38 @@ typedef struct
 } at86rf215_cal_results_st;
 
 
+#define AT86RF215_EVENT_SPIN_NS         20000   // Default spin of an event wait before the futex sleep
+#define AT86RF215_TRX_READY_TIMEOUT_US  10000   // Default TRXRDY wait of the setup paths (event and RFn_STATE checks share it)
+#define AT86RF215_TRX_READY_CHECK_US    250     // First event wait slice before RFn_STATE is checked (doubles per slice)
+#define AT86RF215_TRX_READY_CHECK_MAX_US 2000   // Longest event wait slice between RFn_STATE checks
+
+// IRQ completion strategy (at86rf215_st.irq_mode) ...
+#define AT86RF215_IRQ_MODE_IRQ          0       // IRQ line and GPIO poll thread (default)
+#define AT86RF215_IRQ_MODE_POLL         1       // No IRQ line - waiters poll the IRQS bytes (adaptive backoff)
+#define AT86RF215_IRQ_MODE_HYBRID       2       // Waiters spin-poll IRQS for a short window, then wait for the IRQ
+#define AT86RF215_IRQ_POLL_WINDOW_US    250     // Default back-to-back IRQS polling (covers TRXOFF --> TXPREP, 200 us) before backoff / the IRQ wait
+#define AT86RF215_IRQ_POLL_BACKOFF_US   200     // Default max. sleep between IRQS polls (POLL)
+#define AT86RF215_IRQ_FD_BUSY_WAIT_US   1000    // irq_fd_mode waiter: event wait while another thread serves the fd
+
+typedef struct
+{
+    uint64_t signals;             // Signals (event_node_signal_ready)
+    uint64_t waits;               // Completed waits
+    uint64_t timeouts;            // Waits which reached the deadline
+    uint64_t spin_hits;           // Waits completed without sleeping
+    uint64_t total_wait_ns;       // Wait entry --> return (completed waits)
+    uint64_t max_wait_ns;
+    uint64_t total_wake_ns;       // Signal --> sleeping waiter running
+    uint64_t max_wake_ns;
+} event_stats_st;
+
 typedef struct 
 {
-    pthread_mutex_t ready_mutex;
-    pthread_cond_t ready_cond;
-    int ready;
+    uint32_t count;               // Futex word - pending signals, each wait consumes one
+    uint32_t sleepers;            // Waiters blocked in the kernel
+    uint32_t spin_ns;             // Spin before sleeping (0 --> no spin)
+    uint64_t signal_ns;           // Time of the last signal (wake-up latency)
+    event_stats_st stats;
 } event_st;
 
 typedef struct
@@ -129,26 +156,365 @@ typedef struct
     event_st hi_energy_measure_event;
 } at86rf215_events_st;
 
+// IRQ bits - RF09_IRQS, RF24_IRQS, BBC0_IRQS, BBC1_IRQS are read as one burst, bit = source * 8 + bit in IRQS
+#define AT86RF215_IRQ_BITS          32
+#define AT86RF215_IRQ_BIT(src, bit) ((src) * 8 + (bit))
+#define AT86RF215_IRQ_READ_RETRIES  20          // IRQS reads while the status is still empty after the edge
+#define AT86RF215_IRQ_RADIO(ch, bit) AT86RF215_IRQ_BIT(at86rf215_irq_src_radio09 + (ch), bit)   // ch - at86rf215_rf_channel_en
+#define AT86RF215_IRQ_BB(ch, bit)    AT86RF215_IRQ_BIT(at86rf215_irq_src_bb0 + (ch), bit)
+
+typedef enum
+{
+    at86rf215_irq_src_radio09 = 0,
+    at86rf215_irq_src_radio24 = 1,
+    at86rf215_irq_src_bb0 = 2,
+    at86rf215_irq_src_bb1 = 3,
+} at86rf215_irq_src_en;
+
+typedef enum
+{
+    at86rf215_radio_irq_wake_up_por = 0,
+    at86rf215_radio_irq_trx_ready = 1,
+    at86rf215_radio_irq_energy_detection_complete = 2,
+    at86rf215_radio_irq_battery_low = 3,
+    at86rf215_radio_irq_trx_error = 4,
+    at86rf215_radio_irq_IQ_if_sync_fail = 5,
+} at86rf215_radio_irq_en;
+
+typedef enum
+{
+    at86rf215_bb_irq_frame_rx_started = 0,
+    at86rf215_bb_irq_frame_rx_complete = 1,
+    at86rf215_bb_irq_frame_rx_address_match = 2,
+    at86rf215_bb_irq_frame_rx_match_extended = 3,
+    at86rf215_bb_irq_frame_tx_complete = 4,
+    at86rf215_bb_irq_agc_hold = 5,
+    at86rf215_bb_irq_agc_release = 6,
+    at86rf215_bb_irq_frame_buffer_level = 7,
+} at86rf215_bb_irq_en;
+
+struct at86rf215_t;
+
+// IRQ bit handler - called on the IRQ thread for every set bit, must not block
+typedef void (*at86rf215_irq_handler_ft)(struct at86rf215_t* dev, int bit, void* arg);
+
+// IRQ observer - raw IRQS bytes of every serviced interrupt (debug printing, logging)
+typedef void (*at86rf215_irq_observer_ft)(struct at86rf215_t* dev, const uint8_t irqs[4], void* user);
+
+typedef struct
+{
+    at86rf215_irq_handler_ft handler;   // NULL --> bit is ignored
+    void* arg;
+} at86rf215_irq_slot_st;
+
+// IRQ bit subscription (at86rf215_irq_subscribe / _subscribe_event) - callback and / or wait object
+typedef struct at86rf215_irq_sub_t
+{
+    struct at86rf215_irq_sub_t* next;
+    at86rf215_irq_handler_ft callback;  // NULL --> event only
+    void* user;                         // Callback context
+    event_st* event;                    // Signalled wait object (NULL --> callback only)
+    int bit;
+} at86rf215_irq_sub_st;
+
+typedef struct
+{
+    at86rf215_irq_slot_st table[AT86RF215_IRQ_BITS];  // Dispatch table (at86rf215_irq_table_init)
+    at86rf215_irq_observer_ft observer;                // NULL --> silent dispatch
+    void* observer_user;
+
+    // Subscribers - lists are walked without locks, removed nodes are freed after the dispatch left them ...
+    at86rf215_irq_sub_st* subs[AT86RF215_IRQ_BITS];
+    uint32_t subs_mask;                                // Bits with at least one subscriber
+    int subs_readers;                                  // Dispatchers inside the subscriber walk
+    int subs_lock;                                     // Serializes subscribe / unsubscribe
+
+    // IRQS pollers (AT86RF215_IRQ_MODE_POLL / _HYBRID) - reads clear the status, the IRQ thread does not retry edges served by a poll ...
+    int pollers;                                       // Waiters inside the polling phase
+    uint64_t poll_ns;                                  // Start of the last IRQS poll (CLOCK_MONOTONIC)
+
+    // irq_fd_mode - the application reactor and at86rf215_wait_event may serve the same fd ...
+    int processing;                                    // at86rf215_process_events owner (gpio_poll_process is not reentrant)
+} at86rf215_irq_dispatch_st;
+
+// IRQ latency - log-linear histogram [ns]: values < 4 are exact, above each power of two is split into 4 linear bins
+#define AT86RF215_IRQ_LAT_SUB_BITS  2
+#define AT86RF215_IRQ_LAT_BINS      96          // Last bin collects everything >= 2^25 ns (~34 ms)
+
+typedef enum
+{
+    at86rf215_irq_lat_edge_to_wake = 0,     // GPIO edge timestamp --> IRQ handler running
+    at86rf215_irq_lat_wake_to_read = 1,     // Handler running --> IRQS burst read complete
+    at86rf215_irq_lat_read_to_dispatch = 2, // IRQS read --> dispatch table and subscribers done
+    at86rf215_irq_lat_dispatch_to_waiter = 3, // Event signalled --> waiter running (at86rf215_irq_latency_waiter)
+    at86rf215_irq_lat_stages = 4,
+} at86rf215_irq_lat_stage_en;
+
+typedef struct
+{
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t hist[AT86RF215_IRQ_LAT_BINS];
+} at86rf215_irq_lat_hist_st;
+
+typedef struct
+{
+    at86rf215_irq_lat_hist_st stage[at86rf215_irq_lat_stages];
+} at86rf215_irq_latency_st;
+
+#define AT86RF215_DEFAULT_SPI_DEVICE      "/dev/spidev0.0"    // or "/dev/spidev1.0"
+#define AT86RF215_DEFAULT_GPIO_DEVICE     "/dev/gpiochip2"    // GPIO_DEVICE no 2
+#define AT86RF215_DEFAULT_GPIO_DEVICE_ISR "/dev/gpiochip0"    // GPIO_DEVICE no
+
+#define AT86RF215_SPI_SPEED_LIMIT   25000000    // Max. SPI clock of AT86RF215 (datasheet)
+
+#define AT86RF215_REGCACHE_SIZE     0x500       // Common, RF09, RF24, BBC0, BBC1 register blocks
+
+typedef struct
+{
+    uint64_t read_hits;           // Reads served from the shadow
+    uint64_t read_misses;         // Reads which went to the chip
+    uint64_t writes_skipped;      // Register bytes not written (value already in the chip)
+    uint64_t writes_issued;       // Register bytes written to the chip
+} at86rf215_regcache_stats_st;
+
+typedef struct
+{
+    int enabled;
+    uint8_t value[AT86RF215_REGCACHE_SIZE];         // Last value read from / written to the chip
+    uint8_t valid[AT86RF215_REGCACHE_SIZE / 8];     // Valid bitmap
+    uint8_t pending[AT86RF215_REGCACHE_SIZE / 8];   // Queued in the open batch - shadow is updated on commit
+    at86rf215_regcache_stats_st stats;
+} at86rf215_regcache_st;
+
+#define AT86RF215_RADIO_CFG_SIZE    0x15        // RFn offsets 0x00 (IRQM) - 0x14 (PAC)
+
+
+#define AT86RF215_STATE_TIMEOUT_US  1000        // Default RFn_STATE poll deadline of a state transition
+
+// State transitions of one radio (at86rf215_radio_set_state) - CMD write --> target state read back from RFn_STATE
+typedef struct
+{
+    uint64_t transitions;         // Commands which reached the target state
+    uint64_t timeouts;            // Target state not reached before the deadline
+    uint64_t polls;               // RFn_STATE reads
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t last_ns;             // Last completed transition
+} at86rf215_radio_state_stats_st;
+
+#define AT86RF215_ASYNC_RING_SIZE   64          // Submission / completion ring entries (power of two)
+
+typedef enum
+{
+    at86rf215_async_op_read = 0,
+    at86rf215_async_op_write = 1,
+} at86rf215_async_op_en;
+
+typedef struct
+{
+    at86rf215_async_op_en op;
+    int high_priority;          // Served before normal entries (e.g. IRQ status read)
+    uint16_t addr;
+    uint8_t *buffer;            // Caller owned until the completion is reaped
+    size_t size;                // > 255 bytes - zero-copy burst
+    uint64_t tag;               // User tag, returned in the completion
+} at86rf215_async_sqe_st;
+
+typedef struct
+{
+    uint64_t tag;
+    int result;                 // Bytes transferred or negative error
+} at86rf215_async_cqe_st;
+
+typedef struct
+{
+    size_t seq;                 // Slot sequence (bounded MPMC ring)
+    union
+    {
+        at86rf215_async_sqe_st sqe;
+        at86rf215_async_cqe_st cqe;
+    };
+} at86rf215_async_cell_st;
+
+typedef struct
+{
+    size_t enqueue_pos __attribute__((aligned(64)));
+    size_t dequeue_pos __attribute__((aligned(64)));
+    at86rf215_async_cell_st cell[AT86RF215_ASYNC_RING_SIZE] __attribute__((aligned(64)));
+} at86rf215_async_ring_st;
+
+typedef struct
+{
+    int running;
+    int idle;                   // Worker sleeps on sq_efd - submitters ring the doorbell
+    int sq_efd;                 // Submission doorbell
+    int cq_efd;                 // Completion eventfd (at86rf215_async_get_eventfd)
+    int cq_full;                // Worker sleeps on room_efd - reapers signal a freed completion slot
+    int room_efd;               // Completion ring room doorbell
+    int submitters;             // Threads inside of at86rf215_async_submit (stop drains after they left)
+    int waiters;                // Threads inside of at86rf215_async_wait (stop closes the eventfds after they left)
+    pthread_t worker;
+    at86rf215_async_ring_st sq_hi;
+    at86rf215_async_ring_st sq;
+    at86rf215_async_ring_st cq;
+} at86rf215_async_st;
+
+#define AT86RF215_BUS_HIST_BINS     16          // Wait time buckets: < 1 usec, [1, 2) usec, [2, 4) usec ... >= 16 msec
+
+typedef enum
+{
+    at86rf215_bus_prio_normal = 0,              // Control / bulk traffic
+    at86rf215_bus_prio_high = 1,                // IRQ / status reads - overtake waiting normal requests
+} at86rf215_bus_prio_en;
+
+typedef struct
+{
+    uint64_t acquired_slow[2];                          // Acquisitions which had to wait (normal, high)
+    uint64_t total_wait_ns[2];
+    uint64_t max_wait_ns[2];
+    uint64_t wait_hist[2][AT86RF215_BUS_HIST_BINS];     // Wait time histogram of the slow acquisitions
+} at86rf215_bus_stats_st;
+
+typedef struct
+{
+    uint32_t word;              // bit 0 - owned, bit 1 - sleepers, bits 2.. - high priority waiters (futex word)
+    at86rf215_bus_stats_st stats;
+} at86rf215_bus_st;
+
+#define AT86RF215_TRACE_SIZE        2048        // Transaction trace entries per device (power of two)
+#define AT86RF215_TRACE_DATA        23          // First data bytes kept per entry (a whole RFn configuration burst)
+#define AT86RF215_TRACE_MAGIC       "AT86TRC1"  // Binary dump signature (at86rf215_trace_dump)
+
+typedef enum
+{
+    at86rf215_trace_op_read = 0,
+    at86rf215_trace_op_write = 1,
+    at86rf215_trace_op_read_burst = 2,
+    at86rf215_trace_op_write_burst = 3,
+    at86rf215_trace_op_batch = 4,               // data[0] - number of operations, len - address + data bytes, the operations follow
+    at86rf215_trace_op_mark = 5,                // Phase marker (at86rf215_trace_mark), data - label
+    at86rf215_trace_op_batch_read = 6,          // One operation of the preceding batch
+    at86rf215_trace_op_batch_write = 7,
+} at86rf215_trace_op_en;
+
+typedef struct
+{
+    uint64_t ts_ns;                             // CLOCK_MONOTONIC at the start of the transaction
+    uint32_t seq;                               // Ring index + 1 once complete (other values - being written)
+    uint32_t dur_ns;                            // Duration of the io_utils call (syscall / transport)
+    uint32_t tid;
+    uint16_t addr;
+    uint16_t len;
+    uint8_t op;                                 // at86rf215_trace_op_en
+    uint8_t data[AT86RF215_TRACE_DATA];         // First min(len, AT86RF215_TRACE_DATA) bytes valid
+} at86rf215_trace_entry_st;
+
+typedef struct
+{
+    uint32_t head __attribute__((aligned(64)));  // Next entry (fetch-and-add by the recording threads)
+    int disabled;                               // Tracing is on unless disabled (at86rf215_trace_enable)
+    at86rf215_trace_entry_st *ring;             // AT86RF215_TRACE_SIZE entries (at86rf215_open_io), NULL - nothing recorded
+} at86rf215_trace_st;
+
 typedef struct
+{
+    char magic[8];                              // AT86RF215_TRACE_MAGIC
+    uint32_t entry_size;                        // sizeof(at86rf215_trace_entry_st)
+    uint32_t num_entries;                       // Entries following the header (oldest first)
+    uint64_t recorded;                          // Transactions recorded since init (older ones were overwritten)
+} at86rf215_trace_file_hdr_st;
+
+#define AT86RF215_EMU_TIMING_INSTANT    (-1)    // at86rf215_st.emu_timing_pct - state transitions complete immediately
+
+typedef struct
+{
+    uint64_t frames;            // SPI frames (address + data)
+    uint64_t bytes;             // Register / frame buffer bytes accessed
+    uint64_t commands;          // RFn_CMD / RF_RST writes
+    uint64_t transitions;       // Completed state transitions
+    uint64_t irq_edges;         // Rising edges on the IRQ line
+} at86rf215_emu_stats_st;
+
+typedef struct at86rf215_t
 {
     // Pinout ...
     int cs_pin;    // CS PIN offset
     int reset_pin; // RESET pin offset
 	int irq_pin;   // IRQ pin
 
+    // IRQ delivery ...
+    int irq_mode;                   // AT86RF215_IRQ_MODE_IRQ (0, default), _POLL (irq_pin not needed), _HYBRID (falls back to _POLL without IRQ line)
+    uint32_t irq_poll_window_us;    // Back-to-back IRQS polling of a wait (0 --> AT86RF215_IRQ_POLL_WINDOW_US)
+    uint32_t irq_poll_backoff_us;   // POLL - max. sleep between IRQS polls after the window (0 --> AT86RF215_IRQ_POLL_BACKOFF_US)
+    int irq_fd_mode;                // 1 - no IRQ poll thread: the application polls at86rf215_get_event_fd() and calls at86rf215_process_events()
+
+    // IRQ thread scheduling (the async SPI worker gets the same policy and CPUs) ...
+    int irq_thread_policy;          // SCHED_OTHER (0, default), SCHED_FIFO, SCHED_RR
+    int irq_thread_priority;        // 1 - 99 (SCHED_FIFO / SCHED_RR)
+    uint32_t irq_thread_cpus;       // CPU affinity mask (0 --> any CPU)
+    size_t irq_thread_stack;        // > 0 --> pre-faulted, locked IRQ thread stack of this size [B]
+    int lock_memory;                // 1 --> mlockall(MCL_CURRENT | MCL_FUTURE) in at86rf215_init
+
+    // Event waits ...
+    uint32_t trx_ready_timeout_us;  // TRXRDY wait of the setup paths (0 --> AT86RF215_TRX_READY_TIMEOUT_US), then RFn_STATE is polled
+    uint32_t event_spin_ns;         // Spin of event waits before blocking (0 --> AT86RF215_EVENT_SPIN_NS)
+    uint32_t state_timeout_us;      // State transition deadline - RFn_STATE is polled until then (0 --> AT86RF215_STATE_TIMEOUT_US)
+
+    // IRQ line (GPIO uAPI v2) ...
+    int irq_event_clock;      // Edge timestamp clock - GPIO_EVENT_CLOCK_MONOTONIC (0, default), _REALTIME, _HTE
+    uint32_t irq_debounce_us; // Kernel debounce of the IRQ line [us] (0 --> off)
+
     // SPI device ...
     int spi_mode;  // SPI mode
     int spi_bits;  // SPI bits 
     int spi_speed; // SPI baud rate
+    int cs_mode;   // Chip select mode - IO_UTILS_CS_GPIO (0, GPIO emulated) or IO_UTILS_CS_NATIVE (1, SPI controller)
+
+    // SPI clock characterisation (at86rf215_spi_characterize) ...
+    int spi_speed_auto;           // 1 - ramp the clock at init, bursts run at the fastest verified rate
+    int spi_speed_limit;          // Ramp upper limit [Hz] (0 --> AT86RF215_SPI_SPEED_LIMIT)
+    const char *spi_speed_cache;  // Result file (NULL - not cached), e.g. "/var/lib/at86rf215/spi_speed"
+    int spi_speed_burst;          // Result - fastest verified rate [Hz] (0 - not characterised)
+
+    // Device nodes (NULL --> AT86RF215_DEFAULT_* below) ...
+    const char *spi_dev;      // e.g. "/dev/spidev0.0"
+    const char *gpio_dev;     // GPIO chip with CS / RESET lines, e.g. "/dev/gpiochip2"
+    const char *gpio_dev_isr; // GPIO chip with IRQ line, e.g. "/dev/gpiochip0"
+
+    // SPI transport (IO_UTILS_TRANSPORT_SPIDEV - default, IO_UTILS_TRANSPORT_DW_UIO - spi_dev is the SSI UIO node) ...
+    int spi_transport;
+    const char *cs_uio_dev;   // DW_UIO - GPIO block UIO node with the CS line, e.g. "/dev/uio1"
+    uint32_t ssi_clk_hz;      // DW_UIO - SSI input clock [Hz] (0 --> IO_UTILS_DW_SSI_CLK_HZ)
+
+    // Software emulator (at86rf215_emu.c) - no device node is opened, the chip is modelled in memory ...
+    int emulated;             // 1 - emulator replaces SPI transport, RESET and IRQ lines
+    int emu_timing_pct;       // Transition delays in % of the datasheet values (0 --> 100, AT86RF215_EMU_TIMING_INSTANT)
+    uint32_t emu_seed;        // RNDV / calibration spread seed (0 --> fixed default)
 
     // internal controls
-    spi_t *io_spi; // SPI handle
+    io_utils_dev_s io; // SPI / GPIO context (one per device)
 
     int initialized;              // Initialized status 
     at86rf215_cal_results_st cal; // Cal. status
     bool override_cal;            // Overriade cal
     at86rf215_events_st events;   // Events
+    at86rf215_irq_dispatch_st irq;  // IRQ bit dispatch
 	int num_interrupts;           // Num interrupts happen 
+    uint64_t irq_timestamp_ns;    // Kernel timestamp of the IRQ edge being served (irq_event_clock)
+    uint64_t irq_last_edge_ns;    // Edge already counted in the latency stats (re-dispatch of an asserted line)
+    at86rf215_irq_latency_st irq_latency;  // Edge --> waiter latency (at86rf215_get_irq_latency)
+    
+    io_utils_spi_batch_s batch;   // Register transaction batch (at86rf215_batch_begin / commit)
+    int batch_active;             // 0 - closed, 1 - open (batch_owner valid), 2 - being opened
+    int batch_depth;              // Nested at86rf215_batch_begin calls of the owner (commit flushes at 0)
+    pthread_t batch_owner;        // Thread building the batch - other threads bypass it
+    at86rf215_regcache_st regcache; // Register shadow (write-through)
+    at86rf215_radio_state_stats_st state_stats[2]; // Measured state transitions per radio (at86rf215_radio_get_state_stats)
+    at86rf215_async_st async;     // Asynchronous SPI engine (at86rf215_async_start)
+    at86rf215_bus_st bus;         // SPI bus arbiter - one SPI transaction at a time (IRQ thread vs. control threads)
+    at86rf215_trace_st trace;     // SPI transaction trace (at86rf215_trace_dump)
 } at86rf215_st;
 
 
@@ -156,10 +522,44 @@ int at86rf215_write_buffer(at86rf215_st* dev, uint16_t addr, uint8_t *buffer, ui
 int at86rf215_read_buffer(at86rf215_st* dev, uint16_t addr, uint8_t *buffer, uint8_t size);
 int at86rf215_write_byte(at86rf215_st* dev, uint16_t addr, uint8_t val );
 int at86rf215_read_byte(at86rf215_st* dev, uint16_t addr);
+int at86rf215_write_burst(at86rf215_st* dev, uint16_t addr, const uint8_t *buffer, size_t size);
+int at86rf215_read_burst(at86rf215_st* dev, uint16_t addr, uint8_t *buffer, size_t size);
 void at86rf215_interrupt_handler (void *param, void *user_data);
+void at86rf215_irq_table_init(at86rf215_st* dev);
 int at86rf215_write_fifo(at86rf215_st* dev, uint8_t *buffer, uint8_t size );
 int at86rf215_read_fifo(at86rf215_st* dev, uint8_t *buffer, uint8_t size );
 void at86rf215_get_irqs(at86rf215_st* dev, at86rf215_irq_st* irq, int verbose);
+void at86rf215_batch_begin(at86rf215_st* dev);
+int at86rf215_batch_read(at86rf215_st* dev, uint16_t addr, uint8_t *slot, uint8_t size);
+int at86rf215_batch_write(at86rf215_st* dev, uint16_t addr, uint8_t *buffer, uint8_t size);
+int at86rf215_batch_commit(at86rf215_st* dev);
+
+// Register shadow - at86rf215_regcache.c ...
+uint8_t at86rf215_regcache_volatile_mask(uint16_t addr);
+int at86rf215_regcache_read(at86rf215_st* dev, uint16_t addr, uint8_t *buffer, int size);
+int at86rf215_regcache_holds(at86rf215_st* dev, uint16_t addr, uint8_t value);
+void at86rf215_regcache_update(at86rf215_st* dev, uint16_t addr, const uint8_t *buffer, int size);
+int at86rf215_regcache_trim_write(at86rf215_st* dev, uint16_t addr, const uint8_t *buffer, int size, int *first);
+void at86rf215_regcache_post_write(at86rf215_st* dev, uint16_t addr, const uint8_t *buffer, int size);
+void at86rf215_regcache_invalidate_range(at86rf215_st* dev, uint16_t addr, int size);
+void at86rf215_regcache_set_pending(at86rf215_st* dev, uint16_t addr, int size);
+void at86rf215_regcache_commit_pending(at86rf215_st* dev, const io_utils_spi_batch_s *batch, int num_ops, int ok);
+
+// SPI bus arbiter - at86rf215_bus.c ...
+void at86rf215_bus_acquire(at86rf215_st* dev);
+void at86rf215_bus_release(at86rf215_st* dev);
+at86rf215_bus_prio_en at86rf215_bus_set_thread_priority(at86rf215_bus_prio_en prio);
+
+// SPI transaction trace - at86rf215_trace.c ...
+uint64_t at86rf215_trace_now(void);
+int at86rf215_trace_open(at86rf215_st* dev);
+void at86rf215_trace_close(at86rf215_st* dev);
+uint64_t at86rf215_trace_begin(at86rf215_st* dev);
+void at86rf215_trace_record(at86rf215_st* dev, at86rf215_trace_op_en op, uint16_t addr, int len, const uint8_t *data, uint64_t t0, uint64_t t1);
+void at86rf215_trace_record_batch(at86rf215_st* dev, const io_utils_spi_batch_s *batch, int num_ops, int num_bytes, uint64_t t0);
+
+// Software emulator - at86rf215_emu.c ...
+int at86rf215_emu_attach(at86rf215_st* dev);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,169 @@
+#ifndef ZF_LOG_LEVEL
+    #define ZF_LOG_LEVEL ZF_LOG_VERBOSE
+#endif
+
+#define ZF_LOG_DEF_SRCLOC ZF_LOG_SRCLOC_LONG
+#define ZF_LOG_TAG "AT86RF215_Config"
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include "zf_log/zf_log.h"
+#include "at86rf215.h"
+#include "at86rf215_regs.h"
+
+// Register offsets inside of the RFn block
+#define RADIO_OFS_IRQM      0x00
+#define RADIO_OFS_CS        0x04
+#define RADIO_OFS_CNL       0x07
+#define RADIO_OFS_CNM       0x08
+#define RADIO_OFS_RXBWC     0x09
+#define RADIO_OFS_AGCC      0x0B
+#define RADIO_OFS_TXCUTC    0x12
+
+// Unchanged registers bridged inside of one burst - the same cost as a new 2 byte address header
+#define RADIO_CFG_MAX_GAP   2
+
+#define RADIO_CFG_BITS(ofs, n)  (((1u << (n)) - 1) << (ofs))
+
+//===================================================================
+static inline uint16_t at86rf215_radio_config_base(at86rf215_rf_channel_en radio)
+{
+    return (radio == at86rf215_rf_channel_900mhz) ? REG_RF09_IRQM : REG_RF24_IRQM;
+}
+
+//===================================================================
+// at86rf215_radio_config_diff - registers of the image which are not known to be in the chip (register shadow)
+static uint32_t at86rf215_radio_config_diff(at86rf215_st* dev, uint16_t base, const uint8_t *image, uint32_t managed, int size)
+{
+    uint32_t changed = 0;
+
+    for (int i = 0; i < size; i++)
+    {
+        if (!((managed >> i) & 0x1)) continue;
+        if (!at86rf215_regcache_holds(dev, base + i, image[i])) changed |= 1u << i;
+    }
+
+    return changed;
+}
+
+//===================================================================
+// at86rf215_radio_config_write_runs - write changed registers, adjacent ones merged into bursts
+static int at86rf215_radio_config_write_runs(at86rf215_st* dev, uint16_t base, uint8_t *image,
+                                             uint32_t managed, uint32_t changed, int size)
+{
+    int written = 0;
+    int i = 0;
+
+    while (i < size)
+    {
+        if (!((changed >> i) & 0x1))
+        {
+            i++;
+            continue;
+        }
+
+        // Extend the burst over managed registers, bridging short unchanged gaps ...
+        int first = i, last = i;
+        for (int j = i + 1; j < size && ((managed >> j) & 0x1); j++)
+        {
+            if ((changed >> j) & 0x1) last = j;
+            else if (j - last > RADIO_CFG_MAX_GAP) break;
+        }
+
+        at86rf215_write_buffer(dev, base + first, &image[first], last - first + 1);
+        written += last - first + 1;
+        i = last + 1;
+    }
+
+    return written;
+}
+
+//===================================================================
+// at86rf215_radio_config_apply - write only the registers which differ from the register shadow
+// Returns number of register bytes written, -1 on error
+int at86rf215_radio_config_apply(at86rf215_st* dev, at86rf215_rf_channel_en radio, at86rf215_radio_config_st* cfg)
+{
+    uint8_t image[AT86RF215_RADIO_CFG_SIZE] = {0};
+    uint8_t iq_if[2] = {0};
+    uint32_t managed = 0, changed = 0;
+    uint8_t iq_if_changed = 0;
+    int written = 0;
+
+    if (cfg->sections & AT86RF215_RADIO_CFG_CHANNEL)
+    {
+        at86rf215_radio_channel_mode_en mode = 0;
+        at86rf215_rf_channel_en req_ch = 0;
+
+        if (at86rf215_radio_get_good_channel(cfg->freq_hz, &mode, &req_ch) < 0 || req_ch != radio)
+        {
+            ZF_LOGE("the requested channel or frequency not supported");
+            return -1;
+        }
+
+        int center_freq_25khz_res = 0;
+        int channel_number = 0;
+        at86rf215_radio_get_frequency(mode, 1, cfg->freq_hz, &center_freq_25khz_res, &channel_number);
+        at86rf215_radio_pack_channel(1, center_freq_25khz_res, channel_number, mode, &image[RADIO_OFS_CS]);
+        managed |= RADIO_CFG_BITS(RADIO_OFS_CS, 5);
+    }
+
+    if (cfg->sections & AT86RF215_RADIO_CFG_IRQ_MASK)
+    {
+        image[RADIO_OFS_IRQM] = *((uint8_t*)&cfg->irq_mask);
+        managed |= RADIO_CFG_BITS(RADIO_OFS_IRQM, 1);
+    }
+
+    if (cfg->sections & AT86RF215_RADIO_CFG_RX_FRONTEND)
+    {
+        at86rf215_radio_pack_rx_bandwidth_sampling(&cfg->rx_bw_samp, &image[RADIO_OFS_RXBWC]);
+        managed |= RADIO_CFG_BITS(RADIO_OFS_RXBWC, 2);
+    }
+
+    if (cfg->sections & AT86RF215_RADIO_CFG_AGC)
+    {
+        at86rf215_radio_pack_agc(&cfg->agc, &image[RADIO_OFS_AGCC]);
+        managed |= RADIO_CFG_BITS(RADIO_OFS_AGCC, 2);
+    }
+
+    if (cfg->sections & AT86RF215_RADIO_CFG_TX_FRONTEND)
+    {
+        at86rf215_radio_pack_tx_ctrl(&cfg->tx, &image[RADIO_OFS_TXCUTC]);
+        managed |= RADIO_CFG_BITS(RADIO_OFS_TXCUTC, 3);
+    }
+
+    // Diff against the register shadow (AGC control is volatile - always written) ...
+    changed = at86rf215_radio_config_diff(dev, at86rf215_radio_config_base(radio), image, managed, AT86RF215_RADIO_CFG_SIZE);
+
+    // CNM latches CS, CCF0L/H and CNL - it is written last (highest address of the burst) ...
+    if (changed & RADIO_CFG_BITS(RADIO_OFS_CS, 4))
+    {
+        changed |= RADIO_CFG_BITS(RADIO_OFS_CNM, 1);
+    }
+
+    if (cfg->sections & AT86RF215_RADIO_CFG_IQ_IF)
+    {
+        at86rf215_pack_iq_if(&cfg->iq_if, iq_if);
+        iq_if_changed = (uint8_t)at86rf215_radio_config_diff(dev, REG_RF_IQIFC0, iq_if, 0x3, 2);
+    }
+
+    if (changed == 0 && iq_if_changed == 0)
+    {
+        return 0;
+    }
+
+    // Changed registers are queued and sent as one SPI message ...
+    at86rf215_batch_begin(dev);
+
+    written += at86rf215_radio_config_write_runs(dev, REG_RF_IQIFC0, iq_if, 0x3, iq_if_changed, 2);
+    written += at86rf215_radio_config_write_runs(dev, at86rf215_radio_config_base(radio), image,
+                                                 managed, changed, AT86RF215_RADIO_CFG_SIZE);
+
+    int ret = at86rf215_batch_commit(dev);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    return written;
+}
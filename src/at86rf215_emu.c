@@ -0,0 +1,725 @@
+#ifndef ZF_LOG_LEVEL
+    #define ZF_LOG_LEVEL ZF_LOG_VERBOSE
+#endif
+
+#define ZF_LOG_DEF_SRCLOC ZF_LOG_SRCLOC_LONG
+#define ZF_LOG_TAG "AT86RF215_Emu"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <linux/gpio.h>
+#include "zf_log/zf_log.h"
+#include "at86rf215.h"
+
+#define EMU_REG_SPACE           0x4000      // 14 bit address space (registers + frame buffers)
+
+// Register offsets inside of the RFn / BBCn blocks
+#define EMU_RF_IRQM             0x00
+#define EMU_RF_STATE            0x02
+#define EMU_RF_CMD              0x03
+#define EMU_RF_RSSI             0x0D
+#define EMU_RF_EDV              0x10
+#define EMU_RF_RNDV             0x11
+#define EMU_RF_PLL              0x21
+#define EMU_RF_TXCI             0x25
+#define EMU_RF_TXCQ             0x26
+#define EMU_BB_PC               0x01
+#define EMU_BB_TXFLL            0x06
+#define EMU_BB_TXFLH            0x07
+
+// RFn_STATE values without a command counterpart
+#define EMU_STATE_TRANSITION    0x6
+#define EMU_STATE_SLEEP         0x7         // Reads as RESET - the SPI view of a sleeping transceiver
+
+// RFn_IRQS bits
+#define EMU_RF_IRQ_WAKEUP       (1 << RF_IRQM_WAKEUP)
+#define EMU_RF_IRQ_TRXRDY       (1 << RF_IRQM_TRXRDY)
+
+#define EMU_MAX_STEPS           4
+#define EMU_STEP_CAL            0x1         // TX LO leakage calibration runs on the way (TXCI / TXCQ updated)
+#define EMU_STEP_KEEP_STATE     0x2         // STATE keeps showing the current state until the step (end of TX frame)
+
+// Datasheet transition times [usec], scaled by at86rf215_st.emu_timing_pct
+#define EMU_T_TRXOFF_TXPREP_us  200         // Includes PLL settling and TX calibration
+#define EMU_T_TXPREP_RX_us      90
+#define EMU_T_TO_TRXOFF_us      1
+#define EMU_T_WAKEUP_us         200         // SLEEP --> TRXOFF, crystal start up
+#define EMU_T_TX_BYTE_us        8           // Frame air time per byte (baseband mode)
+#define EMU_TX_OVERHEAD_BYTES   6           // SHR + PHR
+
+typedef struct
+{
+    uint64_t at_ns;
+    uint8_t state;
+    uint8_t rf_irq;
+    uint8_t bb_irq;
+    uint8_t flags;
+} at86rf215_emu_step_st;
+
+typedef struct
+{
+    uint8_t state;
+    at86rf215_emu_step_st steps[EMU_MAX_STEPS];     // Pending transition (ordered)
+    int num_steps;
+    int cal_i, cal_q;                               // Centre of the TX calibration results
+} at86rf215_emu_radio_st;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t timer;
+    int timer_run;
+
+    uint8_t regs[EMU_REG_SPACE];
+    at86rf215_emu_radio_st radio[2];
+    uint32_t rng;
+    int timing_pct;
+    int reset_pin;
+    int in_reset;
+
+    int irq_level;
+    int irq_pipe[2];                                // Read end is polled by the GPIO poll thread
+    uint32_t irq_seqno;                             // Sequence number of the last queued edge (gaps --> dropped edges)
+    int irq_offset;                                 // Line offset reported in the events
+
+    uint16_t frame_addr;
+    int frame_write;
+
+    at86rf215_emu_stats_st stats;
+} at86rf215_emu_st;
+
+//===================================================================
+static inline uint64_t at86rf215_emu_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+//===================================================================
+static inline uint32_t at86rf215_emu_rand(at86rf215_emu_st* emu)
+{
+    // xorshift32 - reproducible for a given seed
+    uint32_t x = emu->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    emu->rng = x;
+    return x;
+}
+
+//===================================================================
+static inline uint64_t at86rf215_emu_delay_ns(at86rf215_emu_st* emu, int usec)
+{
+    if (emu->timing_pct < 0) return 0;
+
+    int pct = (emu->timing_pct == 0) ? 100 : emu->timing_pct;
+    return (uint64_t)usec * 1000ull * pct / 100;
+}
+
+//===================================================================
+static inline uint16_t at86rf215_emu_rf_base(int r)
+{
+    return (r == 0) ? 0x0100 : 0x0200;
+}
+
+//===================================================================
+static inline uint16_t at86rf215_emu_bb_base(int r)
+{
+    return (r == 0) ? 0x0300 : 0x0400;
+}
+
+//===================================================================
+// Reset values (datasheet register summary), registers not listed reset to 0x00
+static void at86rf215_emu_defaults_radio(at86rf215_emu_st* emu, int r)
+{
+    uint8_t *rf = &emu->regs[at86rf215_emu_rf_base(r)];
+    uint8_t *bb = &emu->regs[at86rf215_emu_bb_base(r)];
+
+    memset(rf, 0, 0x100);
+    rf[0x01] = 0x42;                        // AUXS
+    rf[EMU_RF_STATE] = RF_CMD_TRXOFF;
+    rf[0x04] = 0x08;                        // CS
+    rf[0x05] = (r == 0) ? 0xF8 : 0x20;      // CCF0L
+    rf[0x06] = (r == 0) ? 0x8C : 0x8D;      // CCF0H
+    rf[0x09] = 0x09;                        // RXBWC
+    rf[0x0A] = 0x83;                        // RXDFE
+    rf[0x0B] = 0x01;                        // AGCC
+    rf[0x0C] = 0xB7;                        // AGCS
+    rf[EMU_RF_RSSI] = 0x7F;
+    rf[0x0F] = 0x7A;                        // EDD
+    rf[EMU_RF_EDV] = 0x7F;
+    rf[EMU_RF_RNDV] = 0xFF;
+    rf[0x12] = 0x0B;                        // TXCUTC
+    rf[0x13] = 0x81;                        // TXDFE
+    rf[0x14] = 0x7F;                        // PAC
+    rf[0x15] = 0x40;
+    rf[0x17] = 0x04;
+    rf[0x20] = 0x18;
+    rf[EMU_RF_PLL] = 0x09;
+    rf[0x22] = 0x08;                        // PLLCF
+    rf[0x23] = 0x0F;
+    rf[0x24] = 0x0F;
+    rf[EMU_RF_TXCI] = 0x20;
+    rf[EMU_RF_TXCQ] = 0x20;
+    rf[0x29] = 0x08;
+
+    memset(bb, 0, 0x100);
+    bb[EMU_BB_PC] = 0x1D;
+
+    emu->regs[REG_RF09_IRQS + r] = 0;
+    emu->regs[REG_BBC0_IRQS + r] = 0;
+
+    emu->radio[r].state = RF_CMD_TRXOFF;
+    emu->radio[r].num_steps = 0;
+}
+
+//===================================================================
+static void at86rf215_emu_defaults_common(at86rf215_emu_st* emu)
+{
+    memset(emu->regs, 0, 0x100);
+    emu->regs[REG_RF_CFG] = 0x08;
+    emu->regs[REG_RF_CLKO] = 0x09;
+    emu->regs[0x0008] = 0x03;               // BMDVC
+    emu->regs[REG_RF_XOC] = 0x0F;
+    emu->regs[REG_RF_IQIFC0] = 0x27;
+    emu->regs[REG_RF_IQIFC1] = 0x12;
+    emu->regs[REG_RF_PN] = 0x34;
+    emu->regs[REG_RF_VN] = 0x03;
+    emu->regs[0x0015] = 0x0E;
+}
+
+//===================================================================
+// at86rf215_emu_update_irq_line - IRQ pin follows (IRQS & IRQM), a rising edge is queued as GPIO uAPI v2 line event
+static void at86rf215_emu_update_irq_line(at86rf215_emu_st* emu)
+{
+    int level = 0;
+
+    for (int src = 0; src < 4; src++)
+    {
+        if (emu->regs[src] & emu->regs[(src + 1) << 8]) level = 1;
+    }
+
+    if (level && !emu->irq_level)
+    {
+        struct gpio_v2_line_event ev = {0};
+        ev.timestamp_ns = at86rf215_emu_now_ns();
+        ev.id = GPIO_V2_LINE_EVENT_RISING_EDGE;
+        ev.offset = emu->irq_offset;
+        ev.seqno = ev.line_seqno = ++emu->irq_seqno;
+
+        // Poll thread is not running (or is behind) - the edge is dropped like on a real line without consumer ...
+        if (write(emu->irq_pipe[1], &ev, sizeof(ev)) == sizeof(ev)) emu->stats.irq_edges++;
+    }
+
+    emu->irq_level = level;
+}
+
+//===================================================================
+// at86rf215_emu_raise - set IRQS bits (masked reasons only with RF_CFG.IRQMM)
+static void at86rf215_emu_raise(at86rf215_emu_st* emu, int src, uint8_t bits)
+{
+    if (bits == 0) return;
+
+    uint8_t show = (emu->regs[REG_RF_CFG] & 0x08) ? 0xFF : emu->regs[(src + 1) << 8];
+    emu->regs[src] |= bits & show;
+
+    at86rf215_emu_update_irq_line(emu);
+}
+
+//===================================================================
+static void at86rf215_emu_chip_reset(at86rf215_emu_st* emu)
+{
+    at86rf215_emu_defaults_common(emu);
+    memset(&emu->regs[0x0500], 0, EMU_REG_SPACE - 0x0500);
+
+    for (int r = 0; r < 2; r++)
+    {
+        at86rf215_emu_defaults_radio(emu, r);
+    }
+
+    emu->irq_level = 0;
+    emu->frame_addr = 0;
+    emu->frame_write = 0;
+
+    for (int r = 0; r < 2; r++)
+    {
+        at86rf215_emu_raise(emu, REG_RF09_IRQS + r, EMU_RF_IRQ_WAKEUP);
+    }
+}
+
+//===================================================================
+// at86rf215_emu_schedule - append one step of a transition, relative to the previous step (or base_ns)
+static void at86rf215_emu_schedule(at86rf215_emu_st* emu, int r, uint64_t base_ns, uint8_t state, int usec,
+                                   uint8_t rf_irq, uint8_t bb_irq, uint8_t flags)
+{
+    at86rf215_emu_radio_st *rd = &emu->radio[r];
+
+    if (rd->num_steps >= EMU_MAX_STEPS)
+    {
+        ZF_LOGW("radio %d - transition queue full, command dropped", r);
+        return;
+    }
+
+    uint64_t from = rd->num_steps ? rd->steps[rd->num_steps - 1].at_ns : base_ns;
+    rd->steps[rd->num_steps++] = (at86rf215_emu_step_st){
+        .at_ns = from + at86rf215_emu_delay_ns(emu, usec),
+        .state = state,
+        .rf_irq = rf_irq,
+        .bb_irq = bb_irq,
+        .flags = flags,
+    };
+}
+
+//===================================================================
+// at86rf215_emu_enter - complete one step: new state, calibration, interrupts
+static void at86rf215_emu_enter(at86rf215_emu_st* emu, int r, const at86rf215_emu_step_st* step)
+{
+    at86rf215_emu_radio_st *rd = &emu->radio[r];
+    uint8_t *rf = &emu->regs[at86rf215_emu_rf_base(r)];
+    uint8_t *bb = &emu->regs[at86rf215_emu_bb_base(r)];
+
+    rd->state = step->state;
+    emu->stats.transitions++;
+
+    // PLL lock status ...
+    if (rd->state == RF_CMD_TXPREP || rd->state == RF_CMD_TX || rd->state == RF_CMD_RX) rf[EMU_RF_PLL] |= 0x02;
+    else rf[EMU_RF_PLL] &= ~0x02;
+
+    // Calibration result spreads by +-1 LSB around the device specific centre ...
+    if (step->flags & EMU_STEP_CAL)
+    {
+        int di = ((at86rf215_emu_rand(emu) & 0x3) == 0) ? (int)(at86rf215_emu_rand(emu) % 3) - 1 : 0;
+        int dq = ((at86rf215_emu_rand(emu) & 0x3) == 0) ? (int)(at86rf215_emu_rand(emu) % 3) - 1 : 0;
+        rf[EMU_RF_TXCI] = (rd->cal_i + di) & 0x3F;
+        rf[EMU_RF_TXCQ] = (rd->cal_q + dq) & 0x3F;
+    }
+
+    // Baseband mode TX - frame is sent, radio returns to TXPREP with TXFE ...
+    if (rd->state == RF_CMD_TX && ((emu->regs[REG_RF_IQIFC1] >> 4) & 0x7) == 0 && (bb[EMU_BB_PC] & 0x04))
+    {
+        int len = bb[EMU_BB_TXFLL] | ((bb[EMU_BB_TXFLH] & 0x7) << 8);
+        at86rf215_emu_schedule(emu, r, step->at_ns, RF_CMD_TXPREP, (len + EMU_TX_OVERHEAD_BYTES) * EMU_T_TX_BYTE_us,
+                               0, BB_INTR_TXFE, EMU_STEP_KEEP_STATE);
+    }
+
+    at86rf215_emu_raise(emu, REG_RF09_IRQS + r, step->rf_irq);
+    at86rf215_emu_raise(emu, REG_BBC0_IRQS + r, step->bb_irq);
+}
+
+//===================================================================
+// at86rf215_emu_advance - complete all steps which are due, refresh the visible STATE registers
+static void at86rf215_emu_advance(at86rf215_emu_st* emu, uint64_t now)
+{
+    for (int r = 0; r < 2; r++)
+    {
+        at86rf215_emu_radio_st *rd = &emu->radio[r];
+
+        while (rd->num_steps && rd->steps[0].at_ns <= now)
+        {
+            at86rf215_emu_step_st step = rd->steps[0];
+            memmove(&rd->steps[0], &rd->steps[1], (--rd->num_steps) * sizeof(rd->steps[0]));
+            at86rf215_emu_enter(emu, r, &step);
+        }
+
+        int busy = rd->num_steps && !(rd->steps[0].flags & EMU_STEP_KEEP_STATE);
+        emu->regs[at86rf215_emu_rf_base(r) + EMU_RF_STATE] = busy ? EMU_STATE_TRANSITION : rd->state;
+    }
+}
+
+//===================================================================
+// at86rf215_emu_command - RFn_CMD state machine
+static void at86rf215_emu_command(at86rf215_emu_st* emu, int r, uint8_t cmd, uint64_t now)
+{
+    at86rf215_emu_radio_st *rd = &emu->radio[r];
+    uint8_t from = rd->num_steps ? rd->steps[rd->num_steps - 1].state : rd->state;
+
+    emu->stats.commands++;
+
+    switch (cmd)
+    {
+        case RF_CMD_SLEEP:
+            rd->num_steps = 0;
+            at86rf215_emu_enter(emu, r, &(at86rf215_emu_step_st){ .at_ns = now, .state = EMU_STATE_SLEEP });
+            break;
+
+        case RF_CMD_TRXOFF:
+            // Aborts any transition ...
+            rd->num_steps = 0;
+            if (rd->state == EMU_STATE_SLEEP)
+                at86rf215_emu_schedule(emu, r, now, RF_CMD_TRXOFF, EMU_T_WAKEUP_us, EMU_RF_IRQ_WAKEUP, 0, 0);
+            else if (rd->state != RF_CMD_TRXOFF)
+                at86rf215_emu_schedule(emu, r, now, RF_CMD_TRXOFF, EMU_T_TO_TRXOFF_us, 0, 0, 0);
+            break;
+
+        case RF_CMD_TXPREP:
+        case RF_CMD_TX:
+        case RF_CMD_RX:
+            if (from == EMU_STATE_SLEEP) break;
+
+            // Every path goes through TXPREP (TRXRDY + calibration when coming from TRXOFF) ...
+            if (from == RF_CMD_TRXOFF)
+                at86rf215_emu_schedule(emu, r, now, RF_CMD_TXPREP, EMU_T_TRXOFF_TXPREP_us, EMU_RF_IRQ_TRXRDY, 0, EMU_STEP_CAL);
+            else if (from == RF_CMD_TX && cmd != RF_CMD_TX)
+                at86rf215_emu_schedule(emu, r, now, RF_CMD_TXPREP, T_TX_TXPREP_CMD_us, 0, 0, 0);
+            else if (from == RF_CMD_RX && cmd != RF_CMD_RX)
+                at86rf215_emu_schedule(emu, r, now, RF_CMD_TXPREP, EMU_T_TO_TRXOFF_us, 0, 0, 0);
+
+            if (cmd == RF_CMD_TX && from != RF_CMD_TX)
+                at86rf215_emu_schedule(emu, r, now, RF_CMD_TX, T_TX_Start_Delay_us, 0, 0, 0);
+            if (cmd == RF_CMD_RX && from != RF_CMD_RX)
+                at86rf215_emu_schedule(emu, r, now, RF_CMD_RX, EMU_T_TXPREP_RX_us, 0, 0, 0);
+            break;
+
+        case RF_CMD_RESET:
+            at86rf215_emu_defaults_radio(emu, r);
+            at86rf215_emu_raise(emu, REG_RF09_IRQS + r, EMU_RF_IRQ_WAKEUP);
+            break;
+
+        default:
+            break;
+    }
+
+    at86rf215_emu_advance(emu, now);
+    pthread_cond_signal(&emu->cond);
+}
+
+//===================================================================
+static uint8_t at86rf215_emu_reg_read(at86rf215_emu_st* emu, uint16_t a)
+{
+    if (emu->in_reset) return 0;
+
+    // IRQS - cleared by reading ...
+    if (a <= REG_BBC1_IRQS)
+    {
+        uint8_t v = emu->regs[a];
+        emu->regs[a] = 0;
+        at86rf215_emu_update_irq_line(emu);
+        return v;
+    }
+
+    if ((a >> 8) == 0x01 || (a >> 8) == 0x02)
+    {
+        int r = (a >> 8) - 1;
+        uint8_t ofs = a & 0xFF;
+
+        if (emu->radio[r].state == RF_CMD_RX)
+        {
+            if (ofs == EMU_RF_RNDV) emu->regs[a] = at86rf215_emu_rand(emu) & 0xFF;
+            if (ofs == EMU_RF_RSSI) emu->regs[a] = (uint8_t)(int8_t)(-93 + (int)(at86rf215_emu_rand(emu) % 7));
+        }
+        else if (ofs == EMU_RF_RSSI)
+        {
+            emu->regs[a] = 0x7F;
+        }
+    }
+
+    return emu->regs[a];
+}
+
+//===================================================================
+static void at86rf215_emu_reg_write(at86rf215_emu_st* emu, uint16_t a, uint8_t v, uint64_t now)
+{
+    if (emu->in_reset) return;
+
+    // Read only ...
+    if (a <= REG_BBC1_IRQS || a == REG_RF_PN || a == REG_RF_VN) return;
+
+    if (a == REG_RF_RST)
+    {
+        if ((v & 0x7) == RF_CMD_RESET)
+        {
+            emu->stats.commands++;
+            at86rf215_emu_chip_reset(emu);
+        }
+        return;
+    }
+
+    if ((a >> 8) == 0x01 || (a >> 8) == 0x02)
+    {
+        int r = (a >> 8) - 1;
+        uint8_t ofs = a & 0xFF;
+
+        if (ofs == EMU_RF_STATE || ofs == EMU_RF_RSSI || ofs == EMU_RF_EDV || ofs == EMU_RF_RNDV) return;
+        if (ofs == EMU_RF_CMD)
+        {
+            emu->regs[a] = v & 0x7;
+            at86rf215_emu_command(emu, r, v & 0x7, now);
+            return;
+        }
+    }
+
+    emu->regs[a] = v;
+
+    // New masks / mask mode apply to the pin immediately ...
+    if (a == REG_RF_CFG || a == REG_RF09_IRQM || a == REG_RF24_IRQM || a == REG_BBC0_IRQM || a == REG_BBC1_IRQM)
+    {
+        at86rf215_emu_update_irq_line(emu);
+    }
+}
+
+//===================================================================
+// at86rf215_emu_access - one SPI frame (new_frame) or its continuation, address auto-increments
+static void at86rf215_emu_access(at86rf215_emu_st* emu, int new_frame, uint16_t addr, uint8_t *rx, const uint8_t *tx, int len)
+{
+    pthread_mutex_lock(&emu->lock);
+
+    uint64_t now = at86rf215_emu_now_ns();
+    at86rf215_emu_advance(emu, now);
+
+    if (new_frame)
+    {
+        emu->frame_addr = addr & (EMU_REG_SPACE - 1);
+        emu->frame_write = (addr & 0x8000) != 0;
+        emu->stats.frames++;
+    }
+
+    for (int i = 0; i < len; i++)
+    {
+        if (emu->frame_write)
+        {
+            at86rf215_emu_reg_write(emu, emu->frame_addr, tx ? tx[i] : 0, now);
+            if (rx) rx[i] = 0;
+        }
+        else
+        {
+            uint8_t v = at86rf215_emu_reg_read(emu, emu->frame_addr);
+            if (rx) rx[i] = v;
+        }
+        emu->frame_addr = (emu->frame_addr + 1) & (EMU_REG_SPACE - 1);
+    }
+    emu->stats.bytes += len;
+
+    pthread_mutex_unlock(&emu->lock);
+}
+
+//===================================================================
+// at86rf215_emu_timer - completes transitions nobody polls for (TRXRDY / TXFE interrupts)
+static void* at86rf215_emu_timer(void* arg)
+{
+    at86rf215_emu_st* emu = (at86rf215_emu_st*)arg;
+
+    pthread_mutex_lock(&emu->lock);
+    while (emu->timer_run)
+    {
+        at86rf215_emu_advance(emu, at86rf215_emu_now_ns());
+
+        uint64_t next = 0;
+        for (int r = 0; r < 2; r++)
+        {
+            if (emu->radio[r].num_steps && (next == 0 || emu->radio[r].steps[0].at_ns < next))
+                next = emu->radio[r].steps[0].at_ns;
+        }
+
+        if (next == 0)
+        {
+            pthread_cond_wait(&emu->cond, &emu->lock);
+        }
+        else
+        {
+            struct timespec ts = { .tv_sec = next / 1000000000ull, .tv_nsec = next % 1000000000ull };
+            pthread_cond_timedwait(&emu->cond, &emu->lock, &ts);
+        }
+    }
+    pthread_mutex_unlock(&emu->lock);
+
+    return NULL;
+}
+
+//===================================================================
+// Transport - everything below io_utils goes to the model
+//===================================================================
+static int at86rf215_emu_open(io_utils_dev_s *io, const char *device, int mode, int bits, int speed)
+{
+    io->xfer_max = 4096;
+    io->xfer_pad = 0;
+    return (io->priv != NULL) ? 0 : -1;
+}
+
+//===================================================================
+static void at86rf215_emu_close(io_utils_dev_s *io)
+{
+    at86rf215_emu_st* emu = (at86rf215_emu_st*)io->priv;
+
+    if (emu == NULL) return;
+
+    pthread_mutex_lock(&emu->lock);
+    emu->timer_run = 0;
+    pthread_cond_signal(&emu->cond);
+    pthread_mutex_unlock(&emu->lock);
+    pthread_join(emu->timer, NULL);
+
+    close(emu->irq_pipe[0]);
+    close(emu->irq_pipe[1]);
+    pthread_cond_destroy(&emu->cond);
+    pthread_mutex_destroy(&emu->lock);
+    free(emu);
+    io->priv = NULL;
+}
+
+//===================================================================
+static void at86rf215_emu_set_xfer_speed(io_utils_dev_s *io, int reg_speed_hz, int burst_speed_hz)
+{
+}
+
+//===================================================================
+static void at86rf215_emu_cs_write(io_utils_dev_s *io, uint8_t level)
+{
+}
+
+//===================================================================
+static int at86rf215_emu_transfer_reg16(io_utils_dev_s *io, uint16_t addr, uint8_t *rx, const uint8_t *tx, int len)
+{
+    at86rf215_emu_access((at86rf215_emu_st*)io->priv, 1, addr, rx, tx, len);
+    return len + 2;
+}
+
+//===================================================================
+static int at86rf215_emu_exchange(io_utils_dev_s *io, uint8_t *rx, const uint8_t *tx, int len)
+{
+    at86rf215_emu_access((at86rf215_emu_st*)io->priv, 0, 0, rx, tx, len);
+    return len;
+}
+
+//===================================================================
+static int at86rf215_emu_message(io_utils_dev_s *io, struct spi_ioc_transfer *xfer, int n)
+{
+    int total = 0;
+
+    // Every transfer carries its own 2 byte address header ...
+    for (int i = 0; i < n; i++)
+    {
+        const uint8_t *tx = (const uint8_t *)(uintptr_t)xfer[i].tx_buf;
+        uint8_t *rx = (uint8_t *)(uintptr_t)xfer[i].rx_buf;
+
+        if (xfer[i].len < 2 || tx == NULL) continue;
+
+        at86rf215_emu_access((at86rf215_emu_st*)io->priv, 1, (tx[0] << 8) | tx[1],
+                             rx ? rx + 2 : NULL, tx + 2, xfer[i].len - 2);
+        total += xfer[i].len;
+    }
+
+    return total;
+}
+
+//===================================================================
+static void at86rf215_emu_gpio_write(io_utils_dev_s *io, int offset, uint8_t level)
+{
+    at86rf215_emu_st* emu = (at86rf215_emu_st*)io->priv;
+
+    if (emu == NULL || offset != emu->reset_pin) return;
+
+    // RESETN - chip is held while low, comes up with reset values ...
+    pthread_mutex_lock(&emu->lock);
+    if (level == 0)
+    {
+        emu->in_reset = 1;
+    }
+    else if (emu->in_reset)
+    {
+        emu->in_reset = 0;
+        at86rf215_emu_chip_reset(emu);
+    }
+    pthread_mutex_unlock(&emu->lock);
+}
+
+//===================================================================
+static int at86rf215_emu_irq_line_fd(io_utils_dev_s *io, int offset)
+{
+    at86rf215_emu_st* emu = (at86rf215_emu_st*)io->priv;
+
+    if (emu == NULL) return -1;
+
+    emu->irq_offset = offset;
+    return emu->irq_pipe[0];
+}
+
+static const io_utils_transport_s at86rf215_emu_transport = {
+    .name = "at86rf215_emu",
+    .open = at86rf215_emu_open,
+    .close = at86rf215_emu_close,
+    .set_xfer_speed = at86rf215_emu_set_xfer_speed,
+    .cs_write = at86rf215_emu_cs_write,
+    .transfer_reg16 = at86rf215_emu_transfer_reg16,
+    .burst_reg16 = at86rf215_emu_transfer_reg16,
+    .exchange = at86rf215_emu_exchange,
+    .message = at86rf215_emu_message,
+    .gpio_write = at86rf215_emu_gpio_write,
+    .irq_line_fd = at86rf215_emu_irq_line_fd,
+};
+
+//===================================================================
+// at86rf215_emu_attach - software chip behind dev->io (after io_utils_dev_init, before the reset / SPI setup)
+int at86rf215_emu_attach(at86rf215_st* dev)
+{
+    at86rf215_emu_st* emu = calloc(1, sizeof(at86rf215_emu_st));
+    pthread_condattr_t attr;
+
+    if (emu == NULL)
+    {
+        ZF_LOGE("emulator allocation failed");
+        return -1;
+    }
+
+    if (pipe(emu->irq_pipe) != 0)
+    {
+        ZF_LOGE("emulator IRQ line pipe failed");
+        free(emu);
+        return -1;
+    }
+    fcntl(emu->irq_pipe[1], F_SETFL, O_NONBLOCK);
+
+    pthread_mutex_init(&emu->lock, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&emu->cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    emu->rng = dev->emu_seed ? dev->emu_seed : 0x215A5EEDu;
+    emu->timing_pct = dev->emu_timing_pct;
+    emu->reset_pin = dev->reset_pin;
+
+    for (int r = 0; r < 2; r++)
+    {
+        emu->radio[r].cal_i = 0x20 + (int)(at86rf215_emu_rand(emu) % 9) - 4;
+        emu->radio[r].cal_q = 0x20 + (int)(at86rf215_emu_rand(emu) % 9) - 4;
+    }
+
+    // Power on ...
+    at86rf215_emu_chip_reset(emu);
+
+    emu->timer_run = 1;
+    if (pthread_create(&emu->timer, NULL, at86rf215_emu_timer, emu) != 0)
+    {
+        ZF_LOGE("emulator timer thread failed");
+        close(emu->irq_pipe[0]);
+        close(emu->irq_pipe[1]);
+        free(emu);
+        return -1;
+    }
+
+    io_utils_set_transport_ops(&dev->io, &at86rf215_emu_transport, emu);
+
+    ZF_LOGD("AT86RF215 emulator attached (timing %d %%, seed 0x%08X)", emu->timing_pct, dev->emu_seed);
+    return 0;
+}
+
+//===================================================================
+int at86rf215_emu_get_stats(at86rf215_st* dev, at86rf215_emu_stats_st* stats)
+{
+    at86rf215_emu_st* emu = (at86rf215_emu_st*)dev->io.priv;
+
+    if (!dev->emulated || emu == NULL) return -1;
+
+    pthread_mutex_lock(&emu->lock);
+    memcpy(stats, &emu->stats, sizeof(*stats));
+    pthread_mutex_unlock(&emu->lock);
+    return 0;
+}
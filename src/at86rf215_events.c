@@ -6,173 +6,703 @@
 #define ZF_LOG_TAG "AT86RF215_Events"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 #include "zf_log/zf_log.h"
 #include "io_utils/io_utils.h"
-#include "at86rf215_common.h"
-#include <pthread.h>
+#include "at86rf215.h"
 
+//===================================================================
+static inline uint64_t event_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+//===================================================================
+static inline void event_cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || (defined(__arm__) && __ARM_ARCH >= 7)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+//===================================================================
+static inline void event_max(uint64_t *max, uint64_t val)
+{
+    uint64_t cur = __atomic_load_n(max, __ATOMIC_RELAXED);
+    while (val > cur && !__atomic_compare_exchange_n(max, &cur, val, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+//===================================================================
+// event_try_consume - take one pending signal
+static inline int event_try_consume(event_st* ev)
+{
+    uint32_t c = __atomic_load_n(&ev->count, __ATOMIC_RELAXED);
+
+    while (c != 0)
+    {
+        if (__atomic_compare_exchange_n(&ev->count, &c, c - 1, 1, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) return 1;
+    }
+    return 0;
+}
+
+//===================================================================
 void event_node_init(event_st* ev)
 {
-    pthread_cond_init(&ev->ready_cond, NULL);
-    pthread_mutex_init(&ev->ready_mutex, NULL);
+    memset(ev, 0, sizeof(event_st));
+    ev->spin_ns = AT86RF215_EVENT_SPIN_NS;
 }
 
 void event_node_close(event_st* ev)
 {
-    pthread_cond_destroy(&ev->ready_cond);
-    pthread_mutex_destroy(&ev->ready_mutex);
+    // Waiters still blocked are woken (they see no signal and go back to sleep or time out) ...
+    if (__atomic_load_n(&ev->sleepers, __ATOMIC_SEQ_CST))
+    {
+        syscall(SYS_futex, &ev->count, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+    }
 }
 
-void event_node_wait_ready(event_st* ev)
+//===================================================================
+// event_node_wait_until - consume one signal, spin first (ev->spin_ns) then sleep on the futex word
+// deadline_ns - absolute CLOCK_MONOTONIC (0 --> no deadline). Returns 0, -1 on timeout
+int event_node_wait_until(event_st* ev, uint64_t deadline_ns)
 {
-    pthread_mutex_lock(&ev->ready_mutex);
-    while (!ev->ready)
+    uint64_t t0 = event_now_ns();
+    uint64_t spin_end = t0 + ev->spin_ns;
+    int got = 0, slept = 0;
+
+    if (deadline_ns != 0 && spin_end > deadline_ns) spin_end = deadline_ns;
+
+    // Spin - short transitions (TXPREP tens of us) complete without a context switch ...
+    while (!(got = event_try_consume(ev)) && event_now_ns() < spin_end)
     {
-        pthread_cond_wait(&ev->ready_cond, &ev->ready_mutex);
+        event_cpu_relax();
     }
-    ev->ready = 0;
-    pthread_mutex_unlock(&ev->ready_mutex);
+
+    // Sleep - sleeper is announced before the count is checked again (signal_ready wakes only announced sleepers) ...
+    if (!got)
+    {
+        __atomic_add_fetch(&ev->sleepers, 1, __ATOMIC_SEQ_CST);
+
+        while (!(got = event_try_consume(ev)))
+        {
+            struct timespec abs, *pabs = NULL;
+
+            if (deadline_ns != 0)
+            {
+                if (event_now_ns() >= deadline_ns) break;
+                abs.tv_sec = deadline_ns / 1000000000ull;
+                abs.tv_nsec = deadline_ns % 1000000000ull;
+                pabs = &abs;
+            }
+
+            syscall(SYS_futex, &ev->count, FUTEX_WAIT_BITSET_PRIVATE, 0, pabs, NULL, FUTEX_BITSET_MATCH_ANY);
+            slept = 1;
+        }
+
+        __atomic_sub_fetch(&ev->sleepers, 1, __ATOMIC_RELAXED);
+    }
+
+    uint64_t t1 = event_now_ns();
+    event_stats_st *st = &ev->stats;
+
+    if (!got)
+    {
+        __atomic_add_fetch(&st->timeouts, 1, __ATOMIC_RELAXED);
+        return -1;
+    }
+
+    __atomic_add_fetch(&st->waits, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&st->total_wait_ns, t1 - t0, __ATOMIC_RELAXED);
+    event_max(&st->max_wait_ns, t1 - t0);
+
+    if (!slept)
+    {
+        __atomic_add_fetch(&st->spin_hits, 1, __ATOMIC_RELAXED);
+    }
+    else
+    {
+        uint64_t ts = __atomic_load_n(&ev->signal_ns, __ATOMIC_RELAXED);
+        uint64_t wake = (t1 > ts) ? t1 - ts : 0;
+        __atomic_add_fetch(&st->total_wake_ns, wake, __ATOMIC_RELAXED);
+        event_max(&st->max_wake_ns, wake);
+    }
+
+    return 0;
 }
 
-void event_node_signal_ready(event_st* ev, int ready)
+//===================================================================
+// event_node_try_wait - consume a pending signal without waiting (polling loops), returns 0, -1 if none is pending
+int event_node_try_wait(event_st* ev)
+{
+    if (!event_try_consume(ev)) return -1;
+
+    __atomic_add_fetch(&ev->stats.waits, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&ev->stats.spin_hits, 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+//===================================================================
+int event_node_wait_timeout(event_st* ev, uint32_t timeout_us)
 {
-    pthread_mutex_lock(&ev->ready_mutex);
-    ev->ready = ready;
-    pthread_cond_signal(&ev->ready_cond);
-    pthread_mutex_unlock(&ev->ready_mutex);
+    return event_node_wait_until(ev, event_now_ns() + (uint64_t)timeout_us * 1000);
 }
 
 //===================================================================
-static void at86rf215_radio_event_handler (at86rf215_st* dev,
-                                at86rf215_rf_channel_en ch,
-                                at86rf215_radio_irq_st *events)
+void event_node_wait_ready(event_st* ev)
 {
-    char channel_st[3];
-    if (ch == at86rf215_rf_channel_900mhz) strcpy(channel_st, "09");
-    else strcpy(channel_st, "24");
+    event_node_wait_until(ev, 0);
+}
 
-    if (events->wake_up_por)
+//===================================================================
+// event_node_signal_ready - add 'ready' signals (counted, back-to-back edges are not merged)
+// ready 0 - drop pending signals, e.g. stale edges before a new command
+void event_node_signal_ready(event_st* ev, int ready)
+{
+    if (ready <= 0)
     {
-        ZF_LOGD("INT @ RADIO%s: Woke up", channel_st);
+        __atomic_store_n(&ev->count, 0, __ATOMIC_RELEASE);
+        return;
     }
 
-    if (events->trx_ready)
+    __atomic_store_n(&ev->signal_ns, event_now_ns(), __ATOMIC_RELAXED);
+    __atomic_add_fetch(&ev->stats.signals, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&ev->count, ready, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&ev->sleepers, __ATOMIC_SEQ_CST))
     {
-        ZF_LOGD("INT @ RADIO%s: Transceiver ready", channel_st);
-        if (ch == at86rf215_rf_channel_900mhz) event_node_signal_ready(&dev->events.lo_trx_ready_event, 1);
-        else if (ch == at86rf215_rf_channel_2400mhz) event_node_signal_ready(&dev->events.hi_trx_ready_event, 1);
+        syscall(SYS_futex, &ev->count, FUTEX_WAKE_PRIVATE, ready, NULL, NULL, 0);
     }
+}
 
-    if (events->energy_detection_complete)
+//===================================================================
+void event_node_get_stats(event_st* ev, event_stats_st* stats)
+{
+    uint64_t *src = (uint64_t*)&ev->stats, *dst = (uint64_t*)stats;
+
+    for (size_t i = 0; i < sizeof(event_stats_st) / sizeof(uint64_t); i++)
     {
-        ZF_LOGD("INT @ RADIO%s: Energy detection complete", channel_st);
-        if (ch == at86rf215_rf_channel_900mhz) event_node_signal_ready(&dev->events.lo_energy_measure_event, 1);
-        else if (ch == at86rf215_rf_channel_2400mhz) event_node_signal_ready(&dev->events.hi_energy_measure_event, 1);
+        dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
     }
+}
 
-    if (events->battery_low)
+//===================================================================
+void event_node_reset_stats(event_st* ev)
+{
+    uint64_t *st = (uint64_t*)&ev->stats;
+
+    for (size_t i = 0; i < sizeof(event_stats_st) / sizeof(uint64_t); i++)
+    {
+        __atomic_store_n(&st[i], 0, __ATOMIC_RELAXED);
+    }
+}
+
+//===================================================================
+// Names of the IRQ bits (at86rf215_irq_observer_print only) ...
+static const char* at86rf215_irq_src_names[4] = {"RADIO09", "RADIO24", "BB09", "BB24"};
+
+static const char* at86rf215_irq_bit_names[AT86RF215_IRQ_BITS] = {
+    "Woke up", "Transceiver ready", "Energy detection complete", "Battery low",
+    "Transceiver error", "I/Q interface sync failed", NULL, NULL,
+    "Woke up", "Transceiver ready", "Energy detection complete", "Battery low",
+    "Transceiver error", "I/Q interface sync failed", NULL, NULL,
+    "Frame reception started", "Frame reception complete", "Frame address matched", "Frame extended address matched",
+    "Frame transmission complete", "AGC hold", "AGC released", "Frame buffer level",
+    "Frame reception started", "Frame reception complete", "Frame address matched", "Frame extended address matched",
+    "Frame transmission complete", "AGC hold", "AGC released", "Frame buffer level",
+};
+
+//===================================================================
+static void at86rf215_irq_signal_event(at86rf215_st* dev, int bit, void* arg)
+{
+    event_node_signal_ready((event_st*)arg, 1);
+}
+
+//===================================================================
+// at86rf215_irq_table_init - IRQ bit --> handler table, built once before the IRQ thread starts
+void at86rf215_irq_table_init(at86rf215_st* dev)
+{
+    at86rf215_irq_slot_st *t = dev->irq.table;
+
+    memset(t, 0, sizeof(dev->irq.table));
+
+    t[AT86RF215_IRQ_BIT(at86rf215_irq_src_radio09, at86rf215_radio_irq_trx_ready)] =
+        (at86rf215_irq_slot_st){at86rf215_irq_signal_event, &dev->events.lo_trx_ready_event};
+    t[AT86RF215_IRQ_BIT(at86rf215_irq_src_radio24, at86rf215_radio_irq_trx_ready)] =
+        (at86rf215_irq_slot_st){at86rf215_irq_signal_event, &dev->events.hi_trx_ready_event};
+    t[AT86RF215_IRQ_BIT(at86rf215_irq_src_radio09, at86rf215_radio_irq_energy_detection_complete)] =
+        (at86rf215_irq_slot_st){at86rf215_irq_signal_event, &dev->events.lo_energy_measure_event};
+    t[AT86RF215_IRQ_BIT(at86rf215_irq_src_radio24, at86rf215_radio_irq_energy_detection_complete)] =
+        (at86rf215_irq_slot_st){at86rf215_irq_signal_event, &dev->events.hi_energy_measure_event};
+}
+
+//===================================================================
+// at86rf215_set_irq_observer - raw IRQS of every serviced interrupt (NULL --> silent)
+// e.g. at86rf215_irq_observer_print; runs on the IRQ thread after the dispatch
+void at86rf215_set_irq_observer(at86rf215_st* dev, at86rf215_irq_observer_ft observer, void* user)
+{
+    __atomic_store_n(&dev->irq.observer, NULL, __ATOMIC_RELEASE);
+    dev->irq.observer_user = user;
+    __atomic_store_n(&dev->irq.observer, observer, __ATOMIC_RELEASE);
+}
+
+//===================================================================
+void at86rf215_irq_observer_print(at86rf215_st* dev, const uint8_t irqs[4], void* user)
+{
+    for (int bit = 0; bit < AT86RF215_IRQ_BITS; bit++)
     {
-        ZF_LOGD("INT @ RADIO%s: Battery low", channel_st);
+        if ((irqs[bit >> 3] & (1 << (bit & 7))) && at86rf215_irq_bit_names[bit] != NULL)
+        {
+            printf("INT @ %s: %s\n", at86rf215_irq_src_names[bit >> 3], at86rf215_irq_bit_names[bit]);
+        }
     }
+}
+
+//===================================================================
+// Subscribers ...
+static __thread int irq_dispatch_depth = 0;     // > 0 --> calling thread is inside the subscriber walk
 
-    if (events->trx_error)
+static void at86rf215_irq_subs_lock(at86rf215_st* dev)
+{
+    while (__atomic_exchange_n(&dev->irq.subs_lock, 1, __ATOMIC_ACQUIRE)) sched_yield();
+}
+
+static void at86rf215_irq_subs_unlock(at86rf215_st* dev)
+{
+    __atomic_store_n(&dev->irq.subs_lock, 0, __ATOMIC_RELEASE);
+}
+
+//===================================================================
+static at86rf215_irq_sub_st* at86rf215_irq_subscribe_node(at86rf215_st* dev, int bit, at86rf215_irq_handler_ft callback, void* user, event_st* event)
+{
+    if (bit < 0 || bit >= AT86RF215_IRQ_BITS)
     {
-        ZF_LOGD("INT @ RADIO%s: Transceiver error", channel_st);
+        ZF_LOGE("IRQ bit %d out of range", bit);
+        return NULL;
     }
 
-    if (events->IQ_if_sync_fail)
+    at86rf215_irq_sub_st* sub = (at86rf215_irq_sub_st*)calloc(1, sizeof(at86rf215_irq_sub_st));
+    if (sub == NULL)
     {
-        ZF_LOGD("INT @ RADIO%s: I/Q interface sync failed", channel_st);
+        ZF_LOGE("IRQ subscriber allocation failed");
+        return NULL;
     }
+
+    sub->callback = callback;
+    sub->user = user;
+    sub->event = event;
+    sub->bit = bit;
+
+    // Node is complete before it becomes reachable ...
+    at86rf215_irq_subs_lock(dev);
+    sub->next = dev->irq.subs[bit];
+    __atomic_store_n(&dev->irq.subs[bit], sub, __ATOMIC_RELEASE);
+    __atomic_or_fetch(&dev->irq.subs_mask, 1u << bit, __ATOMIC_RELEASE);
+    at86rf215_irq_subs_unlock(dev);
+
+    return sub;
 }
 
 //===================================================================
-static void at86rf215_baseband_event_handler (at86rf215_st* dev,
-                                at86rf215_rf_channel_en ch,
-                                at86rf215_baseband_irq_st *events)
+// at86rf215_irq_subscribe - callback for IRQ 'bit' (AT86RF215_IRQ_RADIO / AT86RF215_IRQ_BB), runs on the IRQ thread
+// The IRQ reason must be enabled in RFn_IRQM / BBCn_IRQM. Returns the subscription or NULL
+at86rf215_irq_sub_st* at86rf215_irq_subscribe(at86rf215_st* dev, int bit, at86rf215_irq_handler_ft callback, void* user)
 {
-    char channel_st[3];
-    if (ch == at86rf215_rf_channel_900mhz) strcpy(channel_st, "09");
-    else strcpy(channel_st, "24");
+    return at86rf215_irq_subscribe_node(dev, bit, callback, user, NULL);
+}
 
+//===================================================================
+// at86rf215_irq_subscribe_event - IRQ 'bit' signals 'event' (event_node_wait_ready)
+at86rf215_irq_sub_st* at86rf215_irq_subscribe_event(at86rf215_st* dev, int bit, event_st* event)
+{
+    return at86rf215_irq_subscribe_node(dev, bit, NULL, NULL, event);
+}
+
+//===================================================================
+// at86rf215_irq_unsubscribe - unlink, wait for the dispatch to leave the list, free
+// Not from a subscriber callback (the grace period would wait for itself)
+int at86rf215_irq_unsubscribe(at86rf215_st* dev, at86rf215_irq_sub_st* sub)
+{
+    if (sub == NULL) return -1;
 
-    if (events->frame_rx_started)
+    if (irq_dispatch_depth > 0)
     {
-        ZF_LOGD("INT @ BB%s: Frame reception started", channel_st);
+        ZF_LOGE("IRQ unsubscribe from a subscriber callback");
+        return -1;
     }
 
-    if (events->frame_rx_complete)
+    at86rf215_irq_subs_lock(dev);
+
+    at86rf215_irq_sub_st** link = &dev->irq.subs[sub->bit];
+    while (*link != NULL && *link != sub) link = &(*link)->next;
+
+    if (*link == NULL)
     {
-        ZF_LOGD("INT @ BB%s: Frame reception complete", channel_st);
+        at86rf215_irq_subs_unlock(dev);
+        return -1;
     }
 
-    if (events->frame_rx_address_match)
+    __atomic_store_n(link, sub->next, __ATOMIC_SEQ_CST);
+    if (dev->irq.subs[sub->bit] == NULL)
     {
-        ZF_LOGD("INT @ BB%s: Frame address matched", channel_st);
+        __atomic_and_fetch(&dev->irq.subs_mask, ~(1u << sub->bit), __ATOMIC_SEQ_CST);
     }
 
-    if (events->frame_rx_match_extended)
+    at86rf215_irq_subs_unlock(dev);
+
+    // Grace period - a dispatcher which entered before the unlink may still hold the node ...
+    while (__atomic_load_n(&dev->irq.subs_readers, __ATOMIC_SEQ_CST) != 0) sched_yield();
+
+    free(sub);
+    return 0;
+}
+
+//===================================================================
+// at86rf215_irq_edge_clock_ns - 'now' (CLOCK_MONOTONIC) in the clock of the edge timestamps (0 - HTE, not comparable)
+static uint64_t at86rf215_irq_edge_clock_ns(at86rf215_st* dev, uint64_t now)
+{
+    struct timespec ts;
+
+    if (dev->io.irq_event.event_clock == GPIO_EVENT_CLOCK_MONOTONIC) return now;
+    if (dev->io.irq_event.event_clock != GPIO_EVENT_CLOCK_REALTIME) return 0;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+//===================================================================
+// at86rf215_irq_latency_bin - log-linear bin of 'ns' (AT86RF215_IRQ_LAT_SUB_BITS linear bins per power of two)
+static inline int at86rf215_irq_latency_bin(uint64_t ns)
+{
+    const int sub = 1 << AT86RF215_IRQ_LAT_SUB_BITS;
+
+    if (ns < (uint64_t)sub) return (int)ns;
+
+    int msb = 63 - __builtin_clzll(ns);
+    int bin = (msb - AT86RF215_IRQ_LAT_SUB_BITS + 1) * sub + (int)((ns >> (msb - AT86RF215_IRQ_LAT_SUB_BITS)) & (sub - 1));
+
+    return (bin < AT86RF215_IRQ_LAT_BINS) ? bin : AT86RF215_IRQ_LAT_BINS - 1;
+}
+
+//===================================================================
+// at86rf215_irq_latency_bin_ns - lower bound of a histogram bin [ns]
+uint64_t at86rf215_irq_latency_bin_ns(int bin)
+{
+    const int sub = 1 << AT86RF215_IRQ_LAT_SUB_BITS;
+
+    if (bin < sub) return bin;
+
+    int msb = bin / sub + AT86RF215_IRQ_LAT_SUB_BITS - 1;
+    return (1ull << msb) + (uint64_t)(bin % sub) * (1ull << (msb - AT86RF215_IRQ_LAT_SUB_BITS));
+}
+
+//===================================================================
+// at86rf215_irq_latency_record - one sample (atomic increments only, any thread)
+void at86rf215_irq_latency_record(at86rf215_st* dev, at86rf215_irq_lat_stage_en stage, uint64_t ns)
+{
+    at86rf215_irq_lat_hist_st *h = &dev->irq_latency.stage[stage];
+
+    __atomic_add_fetch(&h->count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&h->total_ns, ns, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&h->hist[at86rf215_irq_latency_bin(ns)], 1, __ATOMIC_RELAXED);
+    event_max(&h->max_ns, ns);
+}
+
+//===================================================================
+// at86rf215_irq_latency_waiter - waiter returned from an IRQ signalled event: signal --> now into the last stage
+void at86rf215_irq_latency_waiter(at86rf215_st* dev, event_st* ev)
+{
+    uint64_t ts = __atomic_load_n(&ev->signal_ns, __ATOMIC_RELAXED);
+    uint64_t now = event_now_ns();
+
+    if (ts != 0 && now >= ts) at86rf215_irq_latency_record(dev, at86rf215_irq_lat_dispatch_to_waiter, now - ts);
+}
+
+//===================================================================
+void at86rf215_get_irq_latency(at86rf215_st* dev, at86rf215_irq_latency_st* snap)
+{
+    uint64_t *src = (uint64_t*)&dev->irq_latency, *dst = (uint64_t*)snap;
+
+    for (size_t i = 0; i < sizeof(at86rf215_irq_latency_st) / sizeof(uint64_t); i++)
     {
-        ZF_LOGD("INT @ BB%s: Frame extended address matched", channel_st);
+        dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
     }
+}
+
+//===================================================================
+void at86rf215_reset_irq_latency(at86rf215_st* dev)
+{
+    uint64_t *st = (uint64_t*)&dev->irq_latency;
 
-    if (events->frame_tx_complete)
+    for (size_t i = 0; i < sizeof(at86rf215_irq_latency_st) / sizeof(uint64_t); i++)
     {
-        ZF_LOGD("INT @ BB%s: Frame transmission complete", channel_st);
+        __atomic_store_n(&st[i], 0, __ATOMIC_RELAXED);
     }
+}
 
-    if (events->agc_hold)
+//===================================================================
+const char* at86rf215_irq_latency_stage_name(at86rf215_irq_lat_stage_en stage)
+{
+    static const char* names[at86rf215_irq_lat_stages] = {"edge_to_wake", "wake_to_read", "read_to_dispatch", "dispatch_to_waiter"};
+
+    return (stage >= 0 && stage < at86rf215_irq_lat_stages) ? names[stage] : "?";
+}
+
+//===================================================================
+static void at86rf215_irq_dispatch_subscribers(at86rf215_st* dev, uint32_t status)
+{
+    irq_dispatch_depth++;
+    __atomic_add_fetch(&dev->irq.subs_readers, 1, __ATOMIC_SEQ_CST);
+
+    while (status)
     {
-        ZF_LOGD("INT @ BB%s: AGC hold", channel_st);
+        int bit = __builtin_ctz(status);
+        status &= status - 1;
+
+        for (at86rf215_irq_sub_st* sub = __atomic_load_n(&dev->irq.subs[bit], __ATOMIC_ACQUIRE); sub != NULL;
+             sub = __atomic_load_n(&sub->next, __ATOMIC_ACQUIRE))
+        {
+            if (sub->callback != NULL) sub->callback(dev, bit, sub->user);
+            if (sub->event != NULL) event_node_signal_ready(sub->event, 1);
+        }
     }
 
-    if (events->agc_release)
+    __atomic_sub_fetch(&dev->irq.subs_readers, 1, __ATOMIC_SEQ_CST);
+    irq_dispatch_depth--;
+}
+
+//===================================================================
+// at86rf215_irq_read_dispatch - IRQS burst read (up to 'retries' times while empty), set bits walked through the dispatch table
+// t_wake - handler start (latency stats), 0 --> IRQS poll. Returns 1 if bits were served, 0 if the status was empty
+static int at86rf215_irq_read_dispatch(at86rf215_st* dev, int retries, uint64_t t_wake)
+{
+    uint8_t irqs[4] = {0};
+    uint32_t status = 0;
+
+    // IRQ status reads overtake waiting control / bulk transactions (caller's class restored - inline dispatch) ...
+    at86rf215_bus_prio_en prio = at86rf215_bus_set_thread_priority(at86rf215_bus_prio_high);
+
+    for (int i = 0; i < retries && status == 0; i++)
     {
-        ZF_LOGD("INT @ BB%s: AGC released", channel_st);
+        at86rf215_read_buffer(dev, REG_RF09_IRQS, irqs, 4);
+        status = irqs[0] | (irqs[1] << 8) | ((uint32_t)irqs[2] << 16) | ((uint32_t)irqs[3] << 24);
     }
 
-    if (events->frame_buffer_level)
+    at86rf215_bus_set_thread_priority(prio);
+
+    if (status == 0) return 0;
+    __atomic_add_fetch(&dev->num_interrupts, 1, __ATOMIC_RELAXED);
+
+    uint64_t t_read = event_now_ns();
+    if (t_wake != 0) at86rf215_irq_latency_record(dev, at86rf215_irq_lat_wake_to_read, t_read - t_wake);
+
+    uint32_t subs = status & __atomic_load_n(&dev->irq.subs_mask, __ATOMIC_ACQUIRE);
+
+    // Set bits only, lowest first ...
+    while (status)
     {
-        ZF_LOGD("INT @ BB%s: Frame buffer level", channel_st);
+        int bit = __builtin_ctz(status);
+        status &= status - 1;
+
+        at86rf215_irq_slot_st *slot = &dev->irq.table[bit];
+        if (slot->handler != NULL) slot->handler(dev, bit, slot->arg);
     }
+
+    if (subs != 0) at86rf215_irq_dispatch_subscribers(dev, subs);
+
+    at86rf215_irq_latency_record(dev, at86rf215_irq_lat_read_to_dispatch, event_now_ns() - t_read);
+
+    at86rf215_irq_observer_ft observer = __atomic_load_n(&dev->irq.observer, __ATOMIC_ACQUIRE);
+    if (observer != NULL) observer(dev, irqs, dev->irq.observer_user);
+
+    return 1;
 }
 
 //===================================================================
-
+// at86rf215_interrupt_handler - IRQ thread (or at86rf215_process_events) callback: one IRQS burst read, set bits walked through the dispatch table
 void at86rf215_interrupt_handler (void *param, void *user_data)
 {
-    int i=0;
-    int getEvent = 0;
-    
     at86rf215_st* dev = (at86rf215_st*)user_data;
-    at86rf215_irq_st irq = {0};
+    int retries = AT86RF215_IRQ_READ_RETRIES;
 
-    ZF_LOGD("Hit callback - start ...");
-    
-    // Test event type ...
-    if(*(int *)param == GPIOEVENT_EVENT_RISING_EDGE){
-       ZF_LOGD("Hit callback - GPIO event rising edge");   // OK ...
-    }
-    
+    // Falling edges are filtered out ...
     if(*(int *)param == GPIOEVENT_EVENT_FALLING_EDGE){
-       ZF_LOGD("Hit callback - GPIO event falling edge");  // Not allowed - filtered out ...
        return;
     }
-    
-    for(int i=0;i<20;i++){
-        // First read the irqs ...
-        at86rf215_get_irqs(dev, &irq, 1);                      // Verbose mode ...
-        uint8_t *tmp = (uint8_t *)&irq;
-        
-        if (tmp[0] != 0) {at86rf215_radio_event_handler (dev, at86rf215_rf_channel_900mhz, &irq.radio09); getEvent = 1;}
-        if (tmp[1] != 0) {at86rf215_radio_event_handler (dev, at86rf215_rf_channel_2400mhz, &irq.radio24); getEvent = 1;}
-        if (tmp[2] != 0) {at86rf215_baseband_event_handler (dev, at86rf215_rf_channel_900mhz, &irq.bb0); getEvent = 1;}
-        if (tmp[3] != 0) {at86rf215_baseband_event_handler (dev, at86rf215_rf_channel_2400mhz, &irq.bb1); getEvent = 1;}
-        
-        if(getEvent){
-           dev->num_interrupts++;
-           break; 
-        }        
+
+    // Edge time from the GPIO line event (not the time the poll thread got scheduled) ...
+    dev->irq_timestamp_ns = dev->io.irq_event.timestamp;
+    uint64_t t_wake = event_now_ns();
+
+    // Re-dispatch of a still asserted line carries the same edge - counted once ...
+    if (dev->irq_timestamp_ns != 0 && dev->irq_timestamp_ns != dev->irq_last_edge_ns)
+    {
+        uint64_t now = at86rf215_irq_edge_clock_ns(dev, t_wake);
+        if (now >= dev->irq_timestamp_ns)
+        {
+            at86rf215_irq_latency_record(dev, at86rf215_irq_lat_edge_to_wake, now - dev->irq_timestamp_ns);
+        }
+        dev->irq_last_edge_ns = dev->irq_timestamp_ns;
+    }
+
+    // HYBRID - a waiter polling IRQS may have cleared the status of this edge already, an empty read is not retried ...
+    if (__atomic_load_n(&dev->irq.pollers, __ATOMIC_ACQUIRE) > 0 ||
+        (dev->io.irq_event.event_clock == GPIO_EVENT_CLOCK_MONOTONIC &&
+         dev->irq_timestamp_ns < __atomic_load_n(&dev->irq.poll_ns, __ATOMIC_ACQUIRE)))
+    {
+        retries = 1;
+    }
+
+    at86rf215_irq_read_dispatch(dev, retries, t_wake);
+}
+
+//===================================================================
+// at86rf215_irq_poll_once - one IRQS read by a waiter (AT86RF215_IRQ_MODE_POLL / _HYBRID)
+static int at86rf215_irq_poll_once(at86rf215_st* dev)
+{
+    __atomic_store_n(&dev->irq.poll_ns, event_now_ns(), __ATOMIC_RELEASE);
+    return at86rf215_irq_read_dispatch(dev, 1, 0);
+}
+
+//===================================================================
+// at86rf215_irq_poll - IRQS read and dispatched on the calling thread (no IRQ line, e.g. from the application main loop)
+// Returns 1 if interrupt bits were served, 0 if none was pending
+int at86rf215_irq_poll(at86rf215_st* dev)
+{
+    __atomic_add_fetch(&dev->irq.pollers, 1, __ATOMIC_SEQ_CST);
+    int ret = at86rf215_irq_poll_once(dev);
+    __atomic_sub_fetch(&dev->irq.pollers, 1, __ATOMIC_SEQ_CST);
+
+    return ret;
+}
+
+//===================================================================
+// at86rf215_wait_event - wait for an IRQ signalled event with the completion strategy of the device (irq_mode)
+//   IRQ    - event wait (irq_fd_mode - the event fd is served on the calling thread)
+//   POLL   - IRQS polled back-to-back for irq_poll_window_us, then with sleeps doubling up to irq_poll_backoff_us
+//   HYBRID - IRQS polled back-to-back for irq_poll_window_us, then IRQ as above
+// Returns 0, -1 on timeout
+int at86rf215_wait_event(at86rf215_st* dev, event_st* ev, uint32_t timeout_us)
+{
+    uint64_t start = event_now_ns();
+    uint64_t deadline = start + (uint64_t)timeout_us * 1000;
+    int got = 0;
+
+    if (dev->irq_mode != AT86RF215_IRQ_MODE_IRQ)
+    {
+        uint32_t window_us = dev->irq_poll_window_us ? dev->irq_poll_window_us : AT86RF215_IRQ_POLL_WINDOW_US;
+        uint32_t backoff_us = dev->irq_poll_backoff_us ? dev->irq_poll_backoff_us : AT86RF215_IRQ_POLL_BACKOFF_US;
+        uint64_t window_end = start + (uint64_t)window_us * 1000;
+        uint32_t sleep_us = 1;
+
+        __atomic_add_fetch(&dev->irq.pollers, 1, __ATOMIC_SEQ_CST);
+
+        while (!(got = (event_node_try_wait(ev) == 0)))
+        {
+            uint64_t now = event_now_ns();
+            if (now >= deadline || (dev->irq_mode == AT86RF215_IRQ_MODE_HYBRID && now >= window_end)) break;
+
+            // Served bits signal the event through the dispatch table - checked on the next turn ...
+            if (at86rf215_irq_poll_once(dev))
+            {
+                sleep_us = 1;
+                continue;
+            }
+            if (now < window_end) continue;
+
+            // Adaptive backoff - nothing pending after the window ...
+            io_utils_usleep(sleep_us);
+            sleep_us = (sleep_us * 2 < backoff_us) ? sleep_us * 2 : backoff_us;
+        }
+
+        __atomic_sub_fetch(&dev->irq.pollers, 1, __ATOMIC_SEQ_CST);
+    }
+
+    if (!got && dev->irq_mode != AT86RF215_IRQ_MODE_POLL)
+    {
+        if (dev->irq_fd_mode)
+        {
+            // No IRQ thread - the event fd is served here until the event is signalled ...
+            struct pollfd pfd = {.fd = at86rf215_get_event_fd(dev), .events = POLLIN};
+
+            while (!(got = (event_node_try_wait(ev) == 0)))
+            {
+                uint64_t now = event_now_ns();
+                if (now >= deadline) break;
+
+                // Served by another thread (application reactor) - its dispatch signals the event ...
+                if (__atomic_exchange_n(&dev->irq.processing, 1, __ATOMIC_ACQUIRE))
+                {
+                    uint64_t until = now + (uint64_t)AT86RF215_IRQ_FD_BUSY_WAIT_US * 1000;
+                    got = (event_node_wait_until(ev, (until < deadline) ? until : deadline) == 0);
+                    if (got) break;
+                    continue;
+                }
+
+                // Owner of the fd - a dispatch which finished before taking it is seen here ...
+                got = (event_node_try_wait(ev) == 0);
+                if (!got && poll(&pfd, 1, (deadline - now + 999999) / 1000000) > 0) io_utils_process_interrupt(&dev->io);
+                __atomic_store_n(&dev->irq.processing, 0, __ATOMIC_RELEASE);
+                if (got) break;
+            }
+        }
+        else
+        {
+            got = (event_node_wait_until(ev, deadline) == 0);
+        }
     }
 
+    if (!got) return -1;
+
+    at86rf215_irq_latency_waiter(dev, ev);
+    return 0;
+}
+
+//===================================================================
+// at86rf215_get_event_fd - pollable IRQ fd of a device initialized with irq_fd_mode = 1 (-1 otherwise)
+int at86rf215_get_event_fd(at86rf215_st* dev)
+{
+    return dev->io.irq_epfd;
+}
+
+//===================================================================
+// at86rf215_process_events - event fd readable: IRQS read and dispatched on the calling thread
+// One thread serves the fd at a time (the application or a setup path inside at86rf215_wait_event) - a concurrent
+// call returns 0, the owner drains all queued edges (an edge arriving after its drain keeps the fd readable)
+// Returns number of serviced interrupts (0 - spurious wake-up or served elsewhere), -1 if the device is not in irq_fd_mode
+int at86rf215_process_events(at86rf215_st* dev)
+{
+    if (__atomic_exchange_n(&dev->irq.processing, 1, __ATOMIC_ACQUIRE))
+    {
+        return 0;
+    }
+
+    int ret = io_utils_process_interrupt(&dev->io);
+
+    __atomic_store_n(&dev->irq.processing, 0, __ATOMIC_RELEASE);
+    return ret;
+}
+
+//===================================================================
+// at86rf215_get_irq_wake_stats - IRQ edge timestamp --> IRQ thread running (histogram, log2 us bins)
+void at86rf215_get_irq_wake_stats(at86rf215_st* dev, gpio_wake_stats_s* stats)
+{
+    gpio_poll_get_wake_stats(&dev->io.irq_event, stats);
+}
+
+//===================================================================
+void at86rf215_reset_irq_wake_stats(at86rf215_st* dev)
+{
+    gpio_poll_reset_wake_stats(&dev->io.irq_event);
 }
@@ -10,11 +10,14 @@
 #include <string.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <time.h>
 #include "zf_log/zf_log.h"
 #include "io_utils/io_utils.h"
 #include "at86rf215_radio.h"
 #include "at86rf215_regs.h"
 
+#define AT86RF215_TRXOFF_RETRY_US   10      // Errata #6 - RFn_CMD=TRXOFF repeated at this interval while not reached
+
 static const struct at86rf215_radio_regs RF09_regs = {
     .RG_IRQS   = 0x00,
     .RG_IRQM   = 0x100,
@@ -141,39 +144,124 @@ at86rf215_radio_state_cmd_en at86rf215_radio_get_state(at86rf215_st* dev, at86rf
 }
 
 //==================================================================================
-void at86rf215_radio_set_state(at86rf215_st* dev, at86rf215_rf_channel_en ch, at86rf215_radio_state_cmd_en cmd)
+static inline uint64_t at86rf215_radio_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+//==================================================================================
+// at86rf215_radio_set_state - command, then RFn_STATE is polled until the target state is reached (no fixed sleep)
+// TRXOFF, TXPREP, TX, RX wait up to state_timeout_us, the transition time goes to dev->state_stats. Returns 0, -1 on timeout
+// TX in baseband mode (IQIFC1.CHPM = 0, BBCn_PC.BBEN = 1) returns to TXPREP by itself once the frame is sent (TXFE) -
+// there TXPREP seen after the TX start delay of a command issued in TXPREP completes the TX command as well
+int at86rf215_radio_set_state(at86rf215_st* dev, at86rf215_rf_channel_en ch, at86rf215_radio_state_cmd_en cmd)
 {
     // "RG_CMD" RFn_CMD – Transceiver Command
 
     uint16_t reg_address = AT86RF215_REG_ADDR(ch, CMD);
+    at86rf215_radio_state_cmd_en from = at86rf215_radio_state_transition;
+
+    // Baseband TX - TXPREP before the command tells whether a later TXPREP is the end of the frame
+    // (I/Q radio mode stays in TX, mode registers come from the register shadow) ...
+    if (cmd == at86rf215_radio_state_cmd_tx)
+    {
+        uint16_t reg_bb_pc = (ch == at86rf215_rf_channel_900mhz) ? REG_BBC0_PC : REG_BBC1_PC;
+        int chpm = (at86rf215_read_byte(dev, REG_RF_IQIFC1) >> 4) & 0x7;
+        int bben = (at86rf215_read_byte(dev, reg_bb_pc) >> 2) & 0x1;
+
+        if (chpm == 0 && bben) from = at86rf215_radio_get_state(dev, ch);
+    }
+
+    uint64_t t0 = at86rf215_radio_now_ns();
     at86rf215_write_byte(dev, reg_address, cmd & 0x7);
 
+    // NOP, SLEEP, RESET - no target state to wait for ...
+    if (cmd < at86rf215_radio_state_cmd_trx_off || cmd > at86rf215_radio_state_cmd_rx)
+    {
+        return 0;
+    }
+
+    uint32_t timeout_us = dev->state_timeout_us ? dev->state_timeout_us : AT86RF215_STATE_TIMEOUT_US;
+    uint64_t deadline = t0 + (uint64_t)timeout_us * 1000;
+    at86rf215_radio_state_stats_st *st = &dev->state_stats[ch];
+    at86rf215_radio_state_cmd_en state;
+    uint64_t polls = 0, t1, t_cmd = t0;
+    int reached = 0;
+
     /*Errata #6:    State Machine Command RFn_CMD=TRXOFF may not be succeeded
                     Description: If the current state is different from SLEEP, the execution of the command TRXOFF may fail.
                     Software workaround: Check state by reading register RFn_STATE Repeat the command RFn_CMD=TRXOFF
                     if the target state was not reached.
     */
-    if (cmd == at86rf215_radio_state_cmd_trx_off)
+    while (1)
     {
-        int retries = 5;
-        while (at86rf215_radio_get_state(dev, ch) != cmd && retries--)
+        state = at86rf215_radio_get_state(dev, ch);
+        polls++;
+        t1 = at86rf215_radio_now_ns();
+
+        reached = (state == cmd) ||
+                  (cmd == at86rf215_radio_state_cmd_tx && from == at86rf215_radio_state_cmd_tx_prep &&
+                   state == at86rf215_radio_state_cmd_tx_prep && t1 - t0 >= T_TX_Start_Delay_us * 1000ull);
+        if (reached || t1 >= deadline) break;
+
+        // Repeated once the command had time to take effect (TRXOFF is reached within a few us) ...
+        if (cmd == at86rf215_radio_state_cmd_trx_off && state != at86rf215_radio_state_transition &&
+            t1 - t_cmd >= AT86RF215_TRXOFF_RETRY_US * 1000ull)
         {
-            io_utils_usleep(100);
             at86rf215_write_byte(dev, reg_address, cmd & 0x7);
+            t_cmd = t1;
         }
     }
-    if (cmd == at86rf215_radio_state_cmd_tx_prep || cmd == at86rf215_radio_state_cmd_tx || cmd == at86rf215_radio_state_cmd_rx)
+
+    __atomic_add_fetch(&st->polls, polls, __ATOMIC_RELAXED);
+
+    if (reached)
+    {
+        uint64_t ns = t1 - t0;
+        uint64_t max = __atomic_load_n(&st->max_ns, __ATOMIC_RELAXED);
+
+        __atomic_add_fetch(&st->transitions, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&st->total_ns, ns, __ATOMIC_RELAXED);
+        __atomic_store_n(&st->last_ns, ns, __ATOMIC_RELAXED);
+        while (ns > max && !__atomic_compare_exchange_n(&st->max_ns, &max, ns, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    }
+    else
     {
-        //if (ch == at86rf215_rf_channel_900mhz) event_node_wait_ready(&dev->events.lo_trx_ready_event);
-        //else if (ch == at86rf215_rf_channel_2400mhz) event_node_wait_ready(&dev->events.hi_trx_ready_event);
+        __atomic_add_fetch(&st->timeouts, 1, __ATOMIC_RELAXED);
+        ZF_LOGW("Radio %d: state %d not reached within %u us (RFn_STATE %d)", ch, cmd, timeout_us, state);
+    }
 
-        io_utils_usleep(1000);
-        if (dev->override_cal)
-        {
-            int i = ch == at86rf215_rf_channel_900mhz ? dev->cal.low_ch_i : dev->cal.hi_ch_i;
-            int q = ch == at86rf215_rf_channel_900mhz ? dev->cal.low_ch_q : dev->cal.hi_ch_q;
-            at86rf215_radio_set_tx_iq_calibration(dev, ch, i, q);
-        }
+    if (cmd != at86rf215_radio_state_cmd_trx_off && dev->override_cal)
+    {
+        int i = ch == at86rf215_rf_channel_900mhz ? dev->cal.low_ch_i : dev->cal.hi_ch_i;
+        int q = ch == at86rf215_rf_channel_900mhz ? dev->cal.low_ch_q : dev->cal.hi_ch_q;
+        at86rf215_radio_set_tx_iq_calibration(dev, ch, i, q);
+    }
+
+    return reached ? 0 : -1;
+}
+
+//==================================================================================
+void at86rf215_radio_get_state_stats(at86rf215_st* dev, at86rf215_rf_channel_en ch, at86rf215_radio_state_stats_st* stats)
+{
+    uint64_t *src = (uint64_t*)&dev->state_stats[ch], *dst = (uint64_t*)stats;
+
+    for (size_t i = 0; i < sizeof(at86rf215_radio_state_stats_st) / sizeof(uint64_t); i++)
+    {
+        dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+    }
+}
+
+//==================================================================================
+void at86rf215_radio_reset_state_stats(at86rf215_st* dev, at86rf215_rf_channel_en ch)
+{
+    uint64_t *st = (uint64_t*)&dev->state_stats[ch];
+
+    for (size_t i = 0; i < sizeof(at86rf215_radio_state_stats_st) / sizeof(uint64_t); i++)
+    {
+        __atomic_store_n(&st[i], 0, __ATOMIC_RELAXED);
     }
 }
 
@@ -282,12 +370,23 @@ void at86rf215_radio_setup_channel(at86rf215_st* dev, at86rf215_rf_channel_en ch
 
     uint16_t reg_address_spacing = AT86RF215_REG_ADDR(ch, CS);
     uint8_t buf[5] = {0};
+    at86rf215_radio_pack_channel(channel_spacing_25khz_res, center_freq_25khz_res, channel_number, mode, buf);
+    at86rf215_write_buffer(dev, reg_address_spacing, buf, 5);
+}
+
+//==================================================================================
+void at86rf215_radio_pack_channel(int channel_spacing_25khz_res,
+                                    int center_freq_25khz_res,
+                                    int channel_number,
+                                    at86rf215_radio_channel_mode_en mode,
+                                    uint8_t *buf)
+{
+    // CS, CCF0L, CCF0H, CNL, CNM - CNM is the last byte (latches the others)
     buf[0] = channel_spacing_25khz_res;
     buf[1] = /*LOW*/ center_freq_25khz_res & 0xFF;
     buf[2] = /*HIGH*/ (center_freq_25khz_res >> 8) & 0xFF;
     buf[3] = /*LOW*/ channel_number & 0xFF;
     buf[4] = /*HIGH + MODE*/ ((channel_number>>8)&0x01) | ((mode & 0x3)<<6);
-    at86rf215_write_buffer(dev, reg_address_spacing, buf, 5);
 }
 
 //==================================================================================
@@ -316,12 +415,21 @@ void at86rf215_radio_set_rx_bandwidth_sampling(at86rf215_st* dev, at86rf215_rf_c
     uint16_t reg_address_bw = AT86RF215_REG_ADDR(ch, RXBWC);
 
     uint8_t buf[2] = {0};
+    at86rf215_radio_pack_rx_bandwidth_sampling(cfg, buf);
+    at86rf215_write_buffer(dev, reg_address_bw, buf, 2);
+}
+
+//==================================================================================
+void at86rf215_radio_pack_rx_bandwidth_sampling(at86rf215_radio_set_rx_bw_samp_st* cfg, uint8_t *buf)
+{
+    // RXBWC, RXDFE
+    buf[0] = 0;
+    buf[1] = 0;
     buf[0] |= (cfg->inverter_sign_if & 0x1)<<5;
     buf[0] |= (cfg->shift_if_freq & 0x1)<<4;
     buf[0] |= (cfg->bw & 0xF);
     buf[1] |= (cfg->fcut & 0x7) << 5;
     buf[1] |= (cfg->fs & 0xF);
-    at86rf215_write_buffer(dev, reg_address_bw, buf, 2);
 }
 
 //==================================================================================
@@ -378,6 +486,16 @@ void at86rf215_radio_setup_agc(at86rf215_st* dev, at86rf215_rf_channel_en ch,
     uint16_t reg_address_agc = AT86RF215_REG_ADDR(ch, AGCC);
     uint8_t buf[2] = {0};
 
+    at86rf215_radio_pack_agc(agc_ctrl, buf);
+    at86rf215_write_buffer(dev, reg_address_agc, buf, 2);
+}
+
+//==================================================================================
+void at86rf215_radio_pack_agc(at86rf215_radio_agc_ctrl_st *agc_ctrl, uint8_t *buf)
+{
+    // AGCC, AGCS
+    buf[0] = 0;
+    buf[1] = 0;
     buf[0] |= (agc_ctrl->agc_measure_source_not_filtered & 0x1)<<6;
     buf[0] |= (agc_ctrl->avg & 0x3)<<4;
     buf[0] |= (agc_ctrl->reset_cmd & 0x1) << 3;
@@ -385,7 +503,6 @@ void at86rf215_radio_setup_agc(at86rf215_st* dev, at86rf215_rf_channel_en ch,
     buf[0] |= (agc_ctrl->enable_cmd & 0x1);
     buf[1] |= (agc_ctrl->att & 0x7) << 5;
     buf[1] |= (agc_ctrl->gain_control_word & 0x1F);
-    at86rf215_write_buffer(dev, reg_address_agc, buf, 2);
 }
 
 //==================================================================================
@@ -567,6 +684,17 @@ void at86rf215_radio_setup_tx_ctrl(at86rf215_st* dev, at86rf215_rf_channel_en ch
     uint16_t reg_address_txcut = AT86RF215_REG_ADDR(ch, TXCUTC);
     uint8_t buf[3] = {0};
 
+    at86rf215_radio_pack_tx_ctrl(cfg, buf);
+    at86rf215_write_buffer(dev, reg_address_txcut, buf, 3);
+}
+
+//==================================================================================
+void at86rf215_radio_pack_tx_ctrl(at86rf215_radio_tx_ctrl_st* cfg, uint8_t *buf)
+{
+    // TXCUTC, TXDFE, PAC
+    buf[0] = 0;
+    buf[1] = 0;
+    buf[2] = 0;
     buf[0] |= (cfg->pa_ramping_time & 0x3) << 6;
     buf[0] |= (cfg->analog_bw & 0xF);
     buf[1] |= (cfg->digital_bw & 0x7) << 5;
@@ -574,8 +702,6 @@ void at86rf215_radio_setup_tx_ctrl(at86rf215_st* dev, at86rf215_rf_channel_en ch
     buf[1] |= (cfg->fs & 0xF);
     buf[2] |= (cfg->current_reduction & 0x3) << 5;
     buf[2] |= (cfg->tx_power & 0x1F);
-
-    at86rf215_write_buffer(dev, reg_address_txcut, buf, 3);
 }
 
 //==================================================================================
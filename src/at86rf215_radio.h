@@ -299,7 +299,11 @@ void at86rf215_radio_get_external_settings(at86rf215_st* dev, at86rf215_rf_chann
 
 at86rf215_radio_state_cmd_en at86rf215_radio_get_state(at86rf215_st* dev, at86rf215_rf_channel_en ch);
 
-void at86rf215_radio_set_state(at86rf215_st* dev, at86rf215_rf_channel_en ch, at86rf215_radio_state_cmd_en cmd);
+int at86rf215_radio_set_state(at86rf215_st* dev, at86rf215_rf_channel_en ch, at86rf215_radio_state_cmd_en cmd);
+
+void at86rf215_radio_get_state_stats(at86rf215_st* dev, at86rf215_rf_channel_en ch, at86rf215_radio_state_stats_st* stats);
+
+void at86rf215_radio_reset_state_stats(at86rf215_st* dev, at86rf215_rf_channel_en ch);
 
 double at86rf215_radio_get_frequency( /*IN*/ at86rf215_radio_channel_mode_en mode,
                                      /*IN*/ int channel_spacing_25khz_res,
@@ -313,15 +317,25 @@ void at86rf215_radio_setup_channel(at86rf215_st* dev, at86rf215_rf_channel_en ch
                                         int channel_number,
                                         at86rf215_radio_channel_mode_en mode);
 
+void at86rf215_radio_pack_channel(int channel_spacing_25khz_res,
+                                    int center_freq_25khz_res,
+                                    int channel_number,
+                                    at86rf215_radio_channel_mode_en mode,
+                                    uint8_t *buf);
+
 void at86rf215_radio_set_rx_bandwidth_sampling(at86rf215_st* dev, at86rf215_rf_channel_en ch,
                                                 at86rf215_radio_set_rx_bw_samp_st* cfg);
 
+void at86rf215_radio_pack_rx_bandwidth_sampling(at86rf215_radio_set_rx_bw_samp_st* cfg, uint8_t *buf);
+
 void at86rf215_radio_get_rx_bandwidth_sampling(at86rf215_st* dev, at86rf215_rf_channel_en ch,
                                                 at86rf215_radio_set_rx_bw_samp_st* cfg);
 
 void at86rf215_radio_setup_agc(at86rf215_st* dev, at86rf215_rf_channel_en ch,
                                                     at86rf215_radio_agc_ctrl_st *agc_ctrl);
 
+void at86rf215_radio_pack_agc(at86rf215_radio_agc_ctrl_st *agc_ctrl, uint8_t *buf);
+
 void at86rf215_radio_get_agc(at86rf215_st* dev, at86rf215_rf_channel_en ch,
                                                 at86rf215_radio_agc_ctrl_st *agc_ctrl);
 
@@ -338,6 +352,8 @@ uint8_t at86rf215_radio_get_random_value(at86rf215_st* dev, at86rf215_rf_channel
 void at86rf215_radio_setup_tx_ctrl(at86rf215_st* dev, at86rf215_rf_channel_en ch,
                                                 at86rf215_radio_tx_ctrl_st* cfg);
 
+void at86rf215_radio_pack_tx_ctrl(at86rf215_radio_tx_ctrl_st* cfg, uint8_t *buf);
+
 void at86rf215_radio_get_tx_ctrl(at86rf215_st* dev, at86rf215_rf_channel_en ch,
                                 at86rf215_radio_tx_ctrl_st* cfg);
 
@@ -0,0 +1,338 @@
+#ifndef ZF_LOG_LEVEL
+    #define ZF_LOG_LEVEL ZF_LOG_VERBOSE
+#endif
+
+#define ZF_LOG_DEF_SRCLOC ZF_LOG_SRCLOC_LONG
+#define ZF_LOG_TAG "AT86RF215_RegCache"
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include "zf_log/zf_log.h"
+#include "at86rf215.h"
+
+// Register block offsets (RF09 = 0x01xx, RF24 = 0x02xx)
+#define RADIO_OFS_CNM   0x08
+#define RADIO_OFS_CMD   0x03
+
+#define REGCACHE_STAT_INC(dev, name, n) \
+            __atomic_add_fetch(&(dev)->regcache.stats.name, (n), __ATOMIC_RELAXED)
+
+//===================================================================
+// Common registers (0x0000 - 0x00FF)
+static uint8_t at86rf215_regcache_common_mask(uint8_t ofs)
+{
+    switch (ofs)
+    {
+        case 0x06:                  // RF_CFG
+        case 0x07:                  // RF_CLKO
+        case 0x09:                  // RF_XOC
+        case 0x0D:                  // RF_PN
+        case 0x0E:                  // RF_VN
+            return 0x00;
+        case 0x08: return 0x20;     // RF_BMDVC - BMS status
+        case 0x0A: return 0x40;     // RF_IQIFC0 - SF status
+        case 0x0B: return 0x80;     // RF_IQIFC1 - FAILSF status
+        default:   return 0xFF;     // IRQS, RST, IQIFC2, reserved
+    }
+}
+
+//===================================================================
+// Radio registers (RFn, 0x0100 - 0x02FF)
+static uint8_t at86rf215_regcache_radio_mask(uint8_t ofs)
+{
+    switch (ofs)
+    {
+        case 0x00:                  // IRQM
+        case 0x04:                  // CS
+        case 0x05:                  // CCF0L
+        case 0x06:                  // CCF0H
+        case 0x07:                  // CNL
+        case 0x08:                  // CNM (cached for reads, writes are never trimmed - latches the channel)
+        case 0x09:                  // RXBWC
+        case 0x0A:                  // RXDFE
+        case 0x0F:                  // EDD
+        case 0x12:                  // TXCUTC
+        case 0x13:                  // TXDFE
+        case 0x14:                  // PAC
+        case 0x16:                  // PADFE
+        case 0x22:                  // PLLCF
+        case 0x27:                  // TXDACI
+        case 0x28:                  // TXDACQ
+            return 0x00;
+        case 0x01: return 0x04;     // AUXS - AVS status
+        case 0x21: return 0x02;     // PLL - LS status
+        default:   return 0xFF;     // STATE, CMD, AGCC, AGCS, RSSI, EDC, EDV, RNDV, TXCI, TXCQ, reserved
+    }
+}
+
+//===================================================================
+// Baseband registers (BBCn, 0x0300 - 0x04FF)
+static uint8_t at86rf215_regcache_bb_mask(uint8_t ofs)
+{
+    if (ofs >= 0x25 && ofs <= 0x3C) return 0x00;        // MACEA, MACPID, MACSHA
+    if (ofs >= 0x60 && ofs <= 0x6A) return 0x00;        // FSKC0 - FSKPHRTX
+    if (ofs >= 0x6C && ofs <= 0x6E) return 0x00;        // FSKRPC - FSKRPCOFFT
+    if (ofs >= 0x72 && ofs <= 0x75) return 0x00;        // FSKDM - FSKPE2
+
+    switch (ofs)
+    {
+        case 0x00:                  // IRQM
+        case 0x06:                  // TXFLL
+        case 0x07:                  // TXFLH
+        case 0x0A:                  // FBLIL
+        case 0x0B:                  // FBLIH
+        case 0x0C:                  // OFDMPHRTX
+        case 0x0E:                  // OFDMC
+        case 0x0F:                  // OFDMSW
+        case 0x10:                  // OQPSKC0
+        case 0x11:                  // OQPSKC1
+        case 0x12:                  // OQPSKC2
+        case 0x13:                  // OQPSKC3
+        case 0x14:                  // OQPSKPHRTX
+        case 0x20:                  // AFC0
+        case 0x21:                  // AFC1
+        case 0x22:                  // AFFTM
+        case 0x23:                  // AFFVM
+        case 0x41:                  // AMEDT
+        case 0x42:                  // AMAACKPD
+        case 0x43:                  // AMAACKTL
+        case 0x44:                  // AMAACKTH
+        case 0x80:                  // PMUC
+            return 0x00;
+        case 0x01: return 0x20;     // PC - FCSOK status
+        default:   return 0xFF;     // PS, RXFL, FBL, PHRRX, AFS, AMCS, PMU values, counters, reserved
+    }
+}
+
+//===================================================================
+// at86rf215_regcache_volatile_mask - status bits of the register (0xFF - fully volatile, never cached)
+uint8_t at86rf215_regcache_volatile_mask(uint16_t addr)
+{
+    if (addr >= AT86RF215_REGCACHE_SIZE) return 0xFF;
+
+    switch (addr >> 8)
+    {
+        case 0x00: return at86rf215_regcache_common_mask(addr & 0xFF);
+        case 0x01:
+        case 0x02: return at86rf215_regcache_radio_mask(addr & 0xFF);
+        default:   return at86rf215_regcache_bb_mask(addr & 0xFF);
+    }
+}
+
+//===================================================================
+static inline int at86rf215_regcache_is_valid(at86rf215_st* dev, uint16_t addr)
+{
+    return (dev->regcache.valid[addr >> 3] >> (addr & 0x7)) & 0x1;
+}
+
+//===================================================================
+static inline int at86rf215_regcache_is_pending(at86rf215_st* dev, uint16_t addr)
+{
+    return (dev->regcache.pending[addr >> 3] >> (addr & 0x7)) & 0x1;
+}
+
+//===================================================================
+void at86rf215_regcache_enable(at86rf215_st* dev, int enable)
+{
+    at86rf215_regcache_invalidate(dev);
+    dev->regcache.enabled = enable;
+}
+
+//===================================================================
+void at86rf215_regcache_invalidate(at86rf215_st* dev)
+{
+    memset(dev->regcache.valid, 0, sizeof(dev->regcache.valid));
+}
+
+//===================================================================
+void at86rf215_regcache_invalidate_range(at86rf215_st* dev, uint16_t addr, int size)
+{
+    for (int i = 0; i < size; i++)
+    {
+        uint16_t a = addr + i;
+        if (a >= AT86RF215_REGCACHE_SIZE) break;
+        dev->regcache.valid[a >> 3] &= ~(1 << (a & 0x7));
+    }
+}
+
+//===================================================================
+// at86rf215_regcache_read - serve read from shadow, returns 1 on hit (all bytes valid configuration registers)
+int at86rf215_regcache_read(at86rf215_st* dev, uint16_t addr, uint8_t *buffer, int size)
+{
+    if (!dev->regcache.enabled || addr + size > AT86RF215_REGCACHE_SIZE)
+    {
+        return 0;
+    }
+
+    for (int i = 0; i < size; i++)
+    {
+        if (at86rf215_regcache_volatile_mask(addr + i) != 0x00 || !at86rf215_regcache_is_valid(dev, addr + i))
+        {
+            REGCACHE_STAT_INC(dev, read_misses, 1);
+            return 0;
+        }
+    }
+
+    memcpy(buffer, &dev->regcache.value[addr], size);
+    REGCACHE_STAT_INC(dev, read_hits, 1);
+    return 1;
+}
+
+//===================================================================
+// at86rf215_regcache_update - store values read from / written to the chip
+void at86rf215_regcache_update(at86rf215_st* dev, uint16_t addr, const uint8_t *buffer, int size)
+{
+    if (!dev->regcache.enabled) return;
+
+    for (int i = 0; i < size; i++)
+    {
+        uint16_t a = addr + i;
+        if (a >= AT86RF215_REGCACHE_SIZE) break;
+        if (at86rf215_regcache_volatile_mask(a) == 0xFF) continue;
+
+        dev->regcache.value[a] = buffer[i];
+        dev->regcache.valid[a >> 3] |= 1 << (a & 0x7);
+    }
+}
+
+//===================================================================
+// at86rf215_regcache_holds - the chip is known to contain the value (cacheable bits valid, equal and not queued)
+int at86rf215_regcache_holds(at86rf215_st* dev, uint16_t addr, uint8_t value)
+{
+    if (!dev->regcache.enabled || addr >= AT86RF215_REGCACHE_SIZE)
+    {
+        return 0;
+    }
+
+    uint8_t mask = at86rf215_regcache_volatile_mask(addr);
+    return mask != 0xFF &&
+           at86rf215_regcache_is_valid(dev, addr) &&
+           !at86rf215_regcache_is_pending(dev, addr) &&
+           ((value ^ dev->regcache.value[addr]) & ~mask) == 0;
+}
+
+//===================================================================
+static inline int at86rf215_regcache_write_needed(at86rf215_st* dev, uint16_t addr, uint8_t value)
+{
+    // CNM latches CS, CCF0L/H and CNL (possibly written by an earlier call) - always written, like CMD ...
+    if (((addr >> 8) == 0x01 || (addr >> 8) == 0x02) && (addr & 0xFF) == RADIO_OFS_CNM)
+    {
+        return 1;
+    }
+
+    return !at86rf215_regcache_holds(dev, addr, value);
+}
+
+//===================================================================
+// at86rf215_regcache_trim_write - find the smallest sub-range which has to be written
+// Returns number of bytes to write starting at buffer[*first] (0 - whole write is redundant)
+int at86rf215_regcache_trim_write(at86rf215_st* dev, uint16_t addr, const uint8_t *buffer, int size, int *first)
+{
+    int lo = -1, hi = -1;
+
+    *first = 0;
+
+    if (!dev->regcache.enabled)
+    {
+        return size;
+    }
+
+    for (int i = 0; i < size; i++)
+    {
+        if (at86rf215_regcache_write_needed(dev, addr + i, buffer[i]))
+        {
+            if (lo < 0) lo = i;
+            hi = i;
+        }
+    }
+
+    if (lo < 0)
+    {
+        REGCACHE_STAT_INC(dev, writes_skipped, size);
+        return 0;
+    }
+
+    REGCACHE_STAT_INC(dev, writes_skipped, size - (hi - lo + 1));
+    REGCACHE_STAT_INC(dev, writes_issued, hi - lo + 1);
+
+    *first = lo;
+    return hi - lo + 1;
+}
+
+//===================================================================
+// at86rf215_regcache_post_write - shadow update + invalidation on reset commands
+void at86rf215_regcache_post_write(at86rf215_st* dev, uint16_t addr, const uint8_t *buffer, int size)
+{
+    for (int i = 0; i < size; i++)
+    {
+        uint16_t a = addr + i;
+
+        // RF_RST - chip reset, all registers return to defaults ...
+        if (a == REG_RF_RST && buffer[i] == 0x07)
+        {
+            at86rf215_regcache_invalidate(dev);
+            return;
+        }
+
+        // RFn_CMD=RESET - transceiver registers return to defaults ...
+        if (((a >> 8) == 0x01 || (a >> 8) == 0x02) && (a & 0xFF) == RADIO_OFS_CMD && (buffer[i] & 0x7) == 0x07)
+        {
+            at86rf215_regcache_update(dev, addr, buffer, i);
+            at86rf215_regcache_invalidate_range(dev, a & 0xFF00, 0x100);
+            return;
+        }
+    }
+
+    at86rf215_regcache_update(dev, addr, buffer, size);
+}
+
+//===================================================================
+// at86rf215_regcache_set_pending - bytes queued in the open batch, the shadow keeps the chip content until commit
+void at86rf215_regcache_set_pending(at86rf215_st* dev, uint16_t addr, int size)
+{
+    for (int i = 0; i < size; i++)
+    {
+        uint16_t a = addr + i;
+        if (a >= AT86RF215_REGCACHE_SIZE) break;
+        dev->regcache.pending[a >> 3] |= 1 << (a & 0x7);
+    }
+}
+
+//===================================================================
+// at86rf215_regcache_commit_pending - committed batch writes go to the shadow, a failed commit drops their range
+void at86rf215_regcache_commit_pending(at86rf215_st* dev, const io_utils_spi_batch_s *batch, int num_ops, int ok)
+{
+    for (int i = 0; i < num_ops; i++)
+    {
+        const uint8_t *tx = (const uint8_t *)(uintptr_t)batch->xfer[i].tx_buf;
+        uint16_t addr = (tx[0] << 8) | tx[1];
+        int size = batch->xfer[i].len - 2;
+
+        if (!(addr & 0x8000)) continue;
+        addr &= 0x3FFF;
+
+        if (ok) at86rf215_regcache_post_write(dev, addr, tx + 2, size);
+        else at86rf215_regcache_invalidate_range(dev, addr, size);
+    }
+
+    memset(dev->regcache.pending, 0, sizeof(dev->regcache.pending));
+}
+
+//===================================================================
+void at86rf215_regcache_get_stats(at86rf215_st* dev, at86rf215_regcache_stats_st* stats)
+{
+    stats->read_hits = __atomic_load_n(&dev->regcache.stats.read_hits, __ATOMIC_RELAXED);
+    stats->read_misses = __atomic_load_n(&dev->regcache.stats.read_misses, __ATOMIC_RELAXED);
+    stats->writes_skipped = __atomic_load_n(&dev->regcache.stats.writes_skipped, __ATOMIC_RELAXED);
+    stats->writes_issued = __atomic_load_n(&dev->regcache.stats.writes_issued, __ATOMIC_RELAXED);
+}
+
+//===================================================================
+void at86rf215_regcache_reset_stats(at86rf215_st* dev)
+{
+    __atomic_store_n(&dev->regcache.stats.read_hits, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&dev->regcache.stats.read_misses, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&dev->regcache.stats.writes_skipped, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&dev->regcache.stats.writes_issued, 0, __ATOMIC_RELAXED);
+}
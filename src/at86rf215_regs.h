@@ -56,6 +56,7 @@ extern "C" {
 #define REG_BBC0_FSKPHRTX                   0x036A
 #define REG_BBC0_PC                         0x0301
 #define REG_BBC0_FSKDM                      0x0372
+#define REG_BBC0_MACEA0                     0x0325      // MAC extended address (8 bytes) - plain storage with frame filter off
 
 #define REG_BBC1_TXFLL                      0x0406
 #define REG_BBC1_TXFLH                      0x0407
@@ -0,0 +1,197 @@
+#ifndef ZF_LOG_LEVEL
+    #define ZF_LOG_LEVEL ZF_LOG_VERBOSE
+#endif
+
+#define ZF_LOG_DEF_SRCLOC ZF_LOG_SRCLOC_LONG
+#define ZF_LOG_TAG "AT86RF215_Spi"
+
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "zf_log/zf_log.h"
+#include "at86rf215.h"
+#include "at86rf215_regs.h"
+
+#define SPI_CHAR_ROUNDS         8       // Pattern rounds per rate
+#define SPI_CHAR_SCRATCH_SIZE   8       // BBC0_MACEA0..7
+#define SPI_CHAR_FRAME_SIZE     2047    // BBC0 TX frame buffer
+
+// Ramp steps [Hz] - controllers round down to their divider grid
+static const int spi_char_rates[] = {  1000000,  2000000,  4000000,  5000000,  8000000, 10000000,
+                                      12500000, 16000000, 20000000, 25000000, 32000000, 40000000, 50000000 };
+
+//===================================================================
+static inline uint32_t at86rf215_spi_char_xorshift(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+//===================================================================
+static void at86rf215_spi_char_pattern(uint8_t *buf, int size, int round)
+{
+    // Static patterns first (stuck lines, toggling neighbours), then pseudo random ...
+    static const uint8_t fixed[] = { 0x00, 0xFF, 0x55, 0xAA };
+    uint32_t state = 0x9E3779B9u ^ (uint32_t)(round * 0x85EBCA6Bu);
+
+    for (int i = 0; i < size; i++)
+    {
+        if (round < (int)sizeof(fixed)) buf[i] = (i & 1) ? ~fixed[round] : fixed[round];
+        else buf[i] = (uint8_t)at86rf215_spi_char_xorshift(&state);
+    }
+}
+
+//===================================================================
+// at86rf215_spi_char_verify - pattern write / read-back at the current transfer speed, 1 - pass
+// buf - 2 * SPI_CHAR_FRAME_SIZE bytes of the caller (devices may be characterised concurrently)
+static int at86rf215_spi_char_verify(at86rf215_st* dev, int rounds, uint8_t *buf)
+{
+    uint8_t *tx = buf, *rx = buf + SPI_CHAR_FRAME_SIZE;
+    int pass = 1;
+
+    at86rf215_bus_acquire(dev);
+
+    for (int r = 0; r < rounds && pass; r++)
+    {
+        // Register path (2 byte address + data in one transfer) ...
+        at86rf215_spi_char_pattern(tx, SPI_CHAR_SCRATCH_SIZE, r);
+        memset(rx, 0, SPI_CHAR_SCRATCH_SIZE);
+        io_utils_spi_write_buffer(&dev->io, REG_BBC0_MACEA0 | 0x8000, tx, SPI_CHAR_SCRATCH_SIZE);
+        io_utils_spi_read_buffer(&dev->io, REG_BBC0_MACEA0, rx, SPI_CHAR_SCRATCH_SIZE);
+        if (memcmp(tx, rx, SPI_CHAR_SCRATCH_SIZE) != 0) pass = 0;
+
+        // Burst path (whole frame buffer) ...
+        at86rf215_spi_char_pattern(tx, SPI_CHAR_FRAME_SIZE, r);
+        memset(rx, 0, SPI_CHAR_FRAME_SIZE);
+        io_utils_spi_write_burst(&dev->io, REG_BBC0_FBTXS | 0x8000, tx, SPI_CHAR_FRAME_SIZE);
+        io_utils_spi_read_burst(&dev->io, REG_BBC0_FBTXS, rx, SPI_CHAR_FRAME_SIZE);
+        if (memcmp(tx, rx, SPI_CHAR_FRAME_SIZE) != 0) pass = 0;
+    }
+
+    at86rf215_bus_release(dev);
+
+    return pass;
+}
+
+//===================================================================
+static int at86rf215_spi_char_try(at86rf215_st* dev, int rate, int rounds, uint8_t *buf)
+{
+    io_utils_spi_set_xfer_speed(&dev->io, rate, rate);
+    return at86rf215_spi_char_verify(dev, rounds, buf);
+}
+
+//===================================================================
+static int at86rf215_spi_char_load(const char *path)
+{
+    int rate = 0;
+
+    if (path == NULL) return 0;
+
+    FILE *f = fopen(path, "r");
+    if (f == NULL) return 0;
+    if (fscanf(f, "%d", &rate) != 1) rate = 0;
+    fclose(f);
+
+    return rate;
+}
+
+//===================================================================
+static void at86rf215_spi_char_store(const char *path, int rate)
+{
+    if (path == NULL) return;
+
+    FILE *f = fopen(path, "w");
+    if (f == NULL)
+    {
+        ZF_LOGW("unable to store SPI characterisation result to %s", path);
+        return;
+    }
+    fprintf(f, "%d\n", rate);
+    fclose(f);
+}
+
+//===================================================================
+// at86rf215_spi_characterize - find the fastest SPI clock passing pattern read-back on the scratch
+// registers (BBC0_MACEA) and the TX frame buffer. Register accesses stay at dev->spi_speed,
+// bursts (frame buffers) switch to the found rate.
+// force - ignore cached result. Returns the burst rate [Hz], -1 if even dev->spi_speed failed
+int at86rf215_spi_characterize(at86rf215_st* dev, int force)
+{
+    uint8_t scratch[SPI_CHAR_SCRATCH_SIZE] = {0};
+    int limit = dev->spi_speed_limit > 0 ? dev->spi_speed_limit : AT86RF215_SPI_SPEED_LIMIT;
+    int best = 0;
+
+    // Pattern buffers - per call, not shared between devices ...
+    uint8_t *buf = malloc(2 * SPI_CHAR_FRAME_SIZE);
+    if (buf == NULL)
+    {
+        ZF_LOGE("SPI characterisation buffers can not be allocated");
+        return -1;
+    }
+
+    // Scratch registers are restored at the end ...
+    at86rf215_bus_acquire(dev);
+    io_utils_spi_set_xfer_speed(&dev->io, dev->spi_speed, dev->spi_speed);
+    io_utils_spi_read_buffer(&dev->io, REG_BBC0_MACEA0, scratch, SPI_CHAR_SCRATCH_SIZE);
+    at86rf215_bus_release(dev);
+
+    // Cached result - one confirmation pass instead of the whole ramp ...
+    int cached = force ? 0 : at86rf215_spi_char_load(dev->spi_speed_cache);
+    if (cached > 0 && cached <= limit && at86rf215_spi_char_try(dev, cached, 1, buf))
+    {
+        best = cached;
+        ZF_LOGD("SPI clock %d Hz (cached in %s)", best, dev->spi_speed_cache);
+    }
+    else
+    {
+        if (at86rf215_spi_char_try(dev, dev->spi_speed, SPI_CHAR_ROUNDS, buf))
+        {
+            best = dev->spi_speed;
+        }
+
+        // Ramp up to the first failing rate ...
+        for (size_t i = 0; best > 0 && i < sizeof(spi_char_rates) / sizeof(spi_char_rates[0]); i++)
+        {
+            int rate = spi_char_rates[i];
+            if (rate <= dev->spi_speed) continue;
+            if (rate > limit) break;
+
+            if (!at86rf215_spi_char_try(dev, rate, SPI_CHAR_ROUNDS, buf))
+            {
+                ZF_LOGD("SPI clock %d Hz failed pattern read-back", rate);
+                break;
+            }
+            best = rate;
+        }
+
+        if (best > 0)
+        {
+            at86rf215_spi_char_store(dev->spi_speed_cache, best);
+        }
+    }
+
+    at86rf215_bus_acquire(dev);
+    io_utils_spi_set_xfer_speed(&dev->io, dev->spi_speed, dev->spi_speed);
+    io_utils_spi_write_buffer(&dev->io, REG_BBC0_MACEA0 | 0x8000, scratch, SPI_CHAR_SCRATCH_SIZE);
+    at86rf215_bus_release(dev);
+    free(buf);
+
+    if (best == 0)
+    {
+        ZF_LOGE("SPI pattern read-back failed at %d Hz", dev->spi_speed);
+        dev->spi_speed_burst = 0;
+        return -1;
+    }
+
+    // Register pokes keep the conservative rate, bursts run at the verified maximum ...
+    dev->spi_speed_burst = best;
+    io_utils_spi_set_xfer_speed(&dev->io, dev->spi_speed, best);
+
+    ZF_LOGD("SPI clock: registers %d Hz, bursts %d Hz", dev->spi_speed, best);
+    return best;
+}
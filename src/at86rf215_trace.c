@@ -0,0 +1,281 @@
+#ifndef ZF_LOG_LEVEL
+    #define ZF_LOG_LEVEL ZF_LOG_VERBOSE
+#endif
+
+#define ZF_LOG_DEF_SRCLOC ZF_LOG_SRCLOC_LONG
+#define ZF_LOG_TAG "AT86RF215_Trace"
+
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "zf_log/zf_log.h"
+#include "at86rf215.h"
+
+#define TRACE_MASK          (AT86RF215_TRACE_SIZE - 1)
+#define TRACE_DUMP_CHUNK    64          // Entries copied to the stack per write()
+#define TRACE_SIG_MAX_DEVS  4           // Devices dumped by at86rf215_trace_dump_on_signal
+
+// Kernel thread id of the calling thread (gettid once per thread, not per transaction)
+static __thread uint32_t trace_tid = 0;
+
+// Devices / files dumped from the signal handler
+static at86rf215_st* trace_sig_dev[TRACE_SIG_MAX_DEVS];
+static const char* trace_sig_path[TRACE_SIG_MAX_DEVS];
+
+//===================================================================
+uint64_t at86rf215_trace_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+//===================================================================
+// at86rf215_trace_open - empty ring (kept over re-opens), on the heap - the device struct stays small
+// Returns 0, -1 if it can not be allocated (the device works, nothing is recorded)
+int at86rf215_trace_open(at86rf215_st* dev)
+{
+    at86rf215_trace_st *tr = &dev->trace;
+
+    tr->head = 0;
+    if (tr->ring == NULL) tr->ring = calloc(AT86RF215_TRACE_SIZE, sizeof(at86rf215_trace_entry_st));
+    if (tr->ring == NULL)
+    {
+        ZF_LOGW("SPI transaction trace ring can not be allocated - tracing is off");
+        return -1;
+    }
+
+    memset(tr->ring, 0, AT86RF215_TRACE_SIZE * sizeof(at86rf215_trace_entry_st));
+    return 0;
+}
+
+//===================================================================
+// at86rf215_trace_close - release the ring, the device must not transfer anymore
+void at86rf215_trace_close(at86rf215_st* dev)
+{
+    at86rf215_trace_entry_st *ring = dev->trace.ring;
+
+    __atomic_store_n(&dev->trace.ring, NULL, __ATOMIC_SEQ_CST);
+    free(ring);
+}
+
+//===================================================================
+// at86rf215_trace_begin - start timestamp of a transaction, no clock read while tracing is disabled
+uint64_t at86rf215_trace_begin(at86rf215_st* dev)
+{
+    return (dev->trace.disabled || dev->trace.ring == NULL) ? 0 : at86rf215_trace_now();
+}
+
+//===================================================================
+// at86rf215_trace_record - one transaction into the ring (wait-free, any thread)
+// t1 - end timestamp the caller already has (0 - read here)
+void at86rf215_trace_record(at86rf215_st* dev, at86rf215_trace_op_en op, uint16_t addr, int len, const uint8_t *data, uint64_t t0, uint64_t t1)
+{
+    at86rf215_trace_st *tr = &dev->trace;
+
+    if (tr->disabled || tr->ring == NULL) return;
+
+    if (t1 == 0) t1 = at86rf215_trace_now();
+
+    if (trace_tid == 0) trace_tid = (uint32_t)syscall(SYS_gettid);
+
+    // Slot is claimed by fetch-and-add, seq marks it incomplete until all fields are written ...
+    uint32_t idx = __atomic_fetch_add(&tr->head, 1, __ATOMIC_RELAXED);
+    at86rf215_trace_entry_st *e = &tr->ring[idx & TRACE_MASK];
+
+    __atomic_store_n(&e->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    e->ts_ns = t0;
+    e->dur_ns = (uint32_t)(t1 - t0);
+    e->tid = trace_tid;
+    e->addr = addr & 0x3FFF;
+    e->len = (uint16_t)len;
+    e->op = (uint8_t)op;
+    if (data != NULL) memcpy(e->data, data, (len < AT86RF215_TRACE_DATA) ? len : AT86RF215_TRACE_DATA);
+
+    __atomic_store_n(&e->seq, idx + 1, __ATOMIC_RELEASE);
+}
+
+//===================================================================
+// at86rf215_trace_record_batch - batch header followed by each of its operations
+// All num_ops + 1 slots are claimed at once, the operations stay contiguous with their header
+void at86rf215_trace_record_batch(at86rf215_st* dev, const io_utils_spi_batch_s *batch, int num_ops, int num_bytes, uint64_t t0)
+{
+    at86rf215_trace_st *tr = &dev->trace;
+
+    if (tr->disabled || tr->ring == NULL) return;
+
+    uint64_t t1 = at86rf215_trace_now();
+
+    if (trace_tid == 0) trace_tid = (uint32_t)syscall(SYS_gettid);
+
+    uint32_t idx = __atomic_fetch_add(&tr->head, num_ops + 1, __ATOMIC_RELAXED);
+
+    for (int i = -1; i < num_ops; i++, idx++)
+    {
+        at86rf215_trace_entry_st *e = &tr->ring[idx & TRACE_MASK];
+        const struct spi_ioc_transfer *x = &batch->xfer[(i < 0) ? 0 : i];
+        const uint8_t *tx = (const uint8_t *)(uintptr_t)x->tx_buf;
+
+        __atomic_store_n(&e->seq, 0, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+
+        e->ts_ns = t0;
+        e->tid = trace_tid;
+        e->addr = ((tx[0] << 8) | tx[1]) & 0x3FFF;
+
+        if (i < 0)
+        {
+            // Header - duration of the whole commit ...
+            e->dur_ns = (uint32_t)(t1 - t0);
+            e->len = (uint16_t)num_bytes;
+            e->op = at86rf215_trace_op_batch;
+            e->data[0] = (uint8_t)num_ops;
+        }
+        else
+        {
+            // Operation - written data or data read back (address bytes skipped) ...
+            int len = x->len - 2;
+            const uint8_t *data = (x->rx_buf != 0) ? (const uint8_t *)(uintptr_t)x->rx_buf + 2 : tx + 2;
+
+            e->dur_ns = 0;
+            e->len = (uint16_t)len;
+            e->op = (x->rx_buf != 0) ? at86rf215_trace_op_batch_read : at86rf215_trace_op_batch_write;
+            memcpy(e->data, data, (len < AT86RF215_TRACE_DATA) ? len : AT86RF215_TRACE_DATA);
+        }
+
+        __atomic_store_n(&e->seq, idx + 1, __ATOMIC_RELEASE);
+    }
+}
+
+//===================================================================
+// at86rf215_trace_mark - phase marker (e.g. "init", "calibrate"), used by the replay tool to split the session
+void at86rf215_trace_mark(at86rf215_st* dev, const char* label)
+{
+    int len = strlen(label);
+    if (len > AT86RF215_TRACE_DATA) len = AT86RF215_TRACE_DATA;
+
+    uint64_t now = at86rf215_trace_now();
+    at86rf215_trace_record(dev, at86rf215_trace_op_mark, 0, len, (const uint8_t *)label, now, now);
+}
+
+//===================================================================
+void at86rf215_trace_enable(at86rf215_st* dev, int enable)
+{
+    dev->trace.disabled = !enable;
+}
+
+//===================================================================
+// at86rf215_trace_dump - ring to binary file, oldest entry first
+// Only open / write / close - safe to call from a signal handler. Returns number of entries or -1
+int at86rf215_trace_dump(at86rf215_st* dev, const char* path)
+{
+    at86rf215_trace_st *tr = &dev->trace;
+    at86rf215_trace_entry_st chunk[TRACE_DUMP_CHUNK];
+    at86rf215_trace_file_hdr_st hdr = {0};
+    int n = 0, total = 0;
+
+    if (tr->ring == NULL) return -1;
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+
+    uint32_t head = __atomic_load_n(&tr->head, __ATOMIC_ACQUIRE);
+    uint32_t first = (head > AT86RF215_TRACE_SIZE) ? head - AT86RF215_TRACE_SIZE : 0;
+
+    // Header is rewritten with the final count at the end ...
+    memcpy(hdr.magic, AT86RF215_TRACE_MAGIC, sizeof(hdr.magic));
+    hdr.entry_size = sizeof(at86rf215_trace_entry_st);
+    hdr.recorded = head;
+    if (write(fd, &hdr, sizeof(hdr)) != sizeof(hdr))
+    {
+        close(fd);
+        return -1;
+    }
+
+    for (uint32_t idx = first; idx != head; idx++)
+    {
+        at86rf215_trace_entry_st *e = &tr->ring[idx & TRACE_MASK];
+
+        // Skip entries being written or already overwritten by a newer transaction ...
+        if (__atomic_load_n(&e->seq, __ATOMIC_ACQUIRE) != idx + 1) continue;
+        chunk[n] = *e;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&e->seq, __ATOMIC_RELAXED) != idx + 1) continue;
+
+        if (++n == TRACE_DUMP_CHUNK)
+        {
+            if (write(fd, chunk, sizeof(chunk)) != sizeof(chunk)) break;
+            total += n;
+            n = 0;
+        }
+    }
+
+    if (n > 0 && write(fd, chunk, n * sizeof(chunk[0])) == (ssize_t)(n * sizeof(chunk[0])))
+    {
+        total += n;
+    }
+
+    hdr.num_entries = total;
+    if (lseek(fd, 0, SEEK_SET) == 0 && write(fd, &hdr, sizeof(hdr)) == sizeof(hdr))
+    {
+        close(fd);
+        return total;
+    }
+
+    close(fd);
+    return -1;
+}
+
+//===================================================================
+static void at86rf215_trace_signal_handler(int signo)
+{
+    for (int i = 0; i < TRACE_SIG_MAX_DEVS; i++)
+    {
+        if (trace_sig_dev[i] != NULL) at86rf215_trace_dump(trace_sig_dev[i], trace_sig_path[i]);
+    }
+}
+
+//===================================================================
+// at86rf215_trace_dump_on_signal - dump the ring to 'path' whenever 'signo' (e.g. SIGUSR1) arrives
+// 'path' must stay valid for the process lifetime
+int at86rf215_trace_dump_on_signal(at86rf215_st* dev, int signo, const char* path)
+{
+    struct sigaction sa;
+    int slot = -1;
+
+    for (int i = 0; i < TRACE_SIG_MAX_DEVS; i++)
+    {
+        if (trace_sig_dev[i] == dev || (slot < 0 && trace_sig_dev[i] == NULL)) slot = i;
+        if (trace_sig_dev[i] == dev) break;
+    }
+
+    if (slot < 0)
+    {
+        ZF_LOGE("no free trace signal slot (max. %d devices)", TRACE_SIG_MAX_DEVS);
+        return -1;
+    }
+
+    trace_sig_path[slot] = path;
+    trace_sig_dev[slot] = dev;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = at86rf215_trace_signal_handler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+
+    if (sigaction(signo, &sa, NULL) != 0)
+    {
+        ZF_LOGE("sigaction(%d) failed", signo);
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * at86rf215_trace_decode - offline decoder of at86rf215_trace_dump files
+ * Addresses are annotated with the REG_* names parsed from at86rf215_regs.h
+ *
+ * Usage: at86rf215_trace_decode [-r at86rf215_regs.h] trace.bin
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "at86rf215_common.h"
+
+#ifndef AT86RF215_REGS_H_PATH
+    #define AT86RF215_REGS_H_PATH "at86rf215_regs.h"
+#endif
+
+// Used when the installed header is missing (running from the build tree) ...
+#ifndef AT86RF215_REGS_H_FALLBACK
+    #define AT86RF215_REGS_H_FALLBACK "src/at86rf215_regs.h"
+#endif
+
+#define DECODE_MAX_NAMES    512
+#define DECODE_NAME_LEN     40
+#define DECODE_FB_SPAN      0x800       // Frame buffer names cover the whole buffer (+offset)
+
+typedef struct
+{
+    uint16_t addr;
+    char name[DECODE_NAME_LEN];
+} decode_name_st;
+
+static decode_name_st names[DECODE_MAX_NAMES];
+static int num_names = 0;
+
+static const char* op_names[] = {"R ", "W ", "RB", "WB", "BT", "MK", "BR", "BW"};
+
+//===================================================================
+// decode_load_names - "#define REG_<name> <address>" lines, first name of an address wins
+static int decode_load_names(const char* path)
+{
+    char line[256], name[DECODE_NAME_LEN + 1];
+    unsigned int addr;
+
+    FILE* f = fopen(path, "r");
+    if (f == NULL) return -1;
+
+    while (fgets(line, sizeof(line), f) && num_names < DECODE_MAX_NAMES)
+    {
+        if (sscanf(line, " #define %40s %x", name, &addr) != 2 || strncmp(name, "REG_", 4) != 0) continue;
+
+        int dup = 0;
+        for (int i = 0; i < num_names; i++)
+        {
+            if (names[i].addr == addr) dup = 1;
+        }
+        if (dup) continue;
+
+        names[num_names].addr = addr & 0x3FFF;
+        snprintf(names[num_names].name, DECODE_NAME_LEN, "%s", name + 4);
+        num_names++;
+    }
+
+    fclose(f);
+    return num_names;
+}
+
+//===================================================================
+// decode_annotate - exact name, else nearest lower name in the same register block (frame buffer) + offset
+static void decode_annotate(uint16_t addr, char* out, size_t size)
+{
+    int best = -1;
+
+    for (int i = 0; i < num_names; i++)
+    {
+        if (names[i].addr == addr)
+        {
+            snprintf(out, size, "%s", names[i].name);
+            return;
+        }
+
+        int span = (names[i].addr >= 0x2000) ? DECODE_FB_SPAN : 0x100 - (names[i].addr & 0xFF);
+        if (names[i].addr < addr && addr - names[i].addr < span && (best < 0 || names[i].addr > names[best].addr))
+        {
+            best = i;
+        }
+    }
+
+    if (best >= 0) snprintf(out, size, "%s+%d", names[best].name, addr - names[best].addr);
+    else snprintf(out, size, "-");
+}
+
+//===================================================================
+int main(int argc, char *argv[])
+{
+    const char* regs_path = AT86RF215_REGS_H_PATH;
+    at86rf215_trace_file_hdr_st hdr;
+    at86rf215_trace_entry_st e;
+    uint64_t t_first = 0, t_prev = 0;
+    int user_regs = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:")) != -1)
+    {
+        if (opt == 'r')
+        {
+            regs_path = optarg;
+            user_regs = 1;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [-r at86rf215_regs.h] trace.bin\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (optind >= argc)
+    {
+        fprintf(stderr, "Usage: %s [-r at86rf215_regs.h] trace.bin\n", argv[0]);
+        return 1;
+    }
+
+    if (!user_regs && access(regs_path, R_OK) != 0)
+    {
+        regs_path = AT86RF215_REGS_H_FALLBACK;
+    }
+
+    if (decode_load_names(regs_path) < 0)
+    {
+        fprintf(stderr, "Warning: register names not available (%s)\n", regs_path);
+    }
+
+    FILE* f = fopen(argv[optind], "rb");
+    if (f == NULL)
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    if (fread(&hdr, sizeof(hdr), 1, f) != 1 || memcmp(hdr.magic, AT86RF215_TRACE_MAGIC, sizeof(hdr.magic)) != 0 ||
+        hdr.entry_size != sizeof(at86rf215_trace_entry_st))
+    {
+        fprintf(stderr, "%s: not an AT86RF215 trace (or different entry layout)\n", argv[optind]);
+        fclose(f);
+        return 1;
+    }
+
+    printf("# %u entries, %llu transactions recorded\n", hdr.num_entries, (unsigned long long)hdr.recorded);
+    printf("#      time [us]    gap [us]  dur [us]    tid  op  addr    register                  len  data\n");
+
+    for (uint32_t i = 0; i < hdr.num_entries && fread(&e, sizeof(e), 1, f) == 1; i++)
+    {
+        char reg[DECODE_NAME_LEN + 8];
+
+        if (i == 0) t_first = t_prev = e.ts_ns;
+        if (e.op == at86rf215_trace_op_mark) snprintf(reg, sizeof(reg), "-");
+        else decode_annotate(e.addr, reg, sizeof(reg));
+
+        printf("%15.3f %11.3f %9.3f %6u  %s  0x%04X  %-24s %5u ",
+               (e.ts_ns - t_first) / 1e3, (e.ts_ns - t_prev) / 1e3, e.dur_ns / 1e3, e.tid,
+               (e.op < sizeof(op_names) / sizeof(op_names[0])) ? op_names[e.op] : "??", e.addr, reg, e.len);
+
+        if (e.op == at86rf215_trace_op_batch)
+        {
+            printf(" ops=%u", e.data[0]);
+        }
+        else if (e.op == at86rf215_trace_op_mark)
+        {
+            printf(" --- %.*s ---", e.len, (const char*)e.data);
+        }
+        else
+        {
+            for (int b = 0; b < e.len && b < AT86RF215_TRACE_DATA; b++) printf(" %02X", e.data[b]);
+            if (e.len > AT86RF215_TRACE_DATA) printf(" ...");
+        }
+        printf("\n");
+
+        t_prev = e.ts_ns;
+    }
+
+    fclose(f);
+    return 0;
+}
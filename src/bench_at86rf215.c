@@ -0,0 +1,364 @@
+/*
+ * bench_at86rf215 - control-plane latency benchmarks against the hardware or the software emulator
+ *
+ * One machine-readable line per benchmark (all times in usec) plus its log2 histogram:
+ *   BENCH:AT86RF215:<name>:N=<n>,MIN=..,P50=..,P90=..,P99=..,P999=..,MAX=..,MEAN=..
+ *   BENCH:AT86RF215:<name>:HIST=<upper bound usec>:<count>,...
+ *
+ * Usage: bench_at86rf215 [-e emulated] [-z instant emulator timing] [-d /dev/spidevX.Y] [-s spi_speed]
+ *                        [-n iterations] [-m slow iterations] [-b burst bytes] [-c native CS]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "at86rf215.h"
+#include "at86rf215_radio.h"
+#include "io_utils/io_utils.h"
+
+#define GPIO_CS_OFFSET 0
+#define GPIO_RESET_OFFSET 1
+#define GPIO_EXT_INT_OFFSET 26
+
+#define BENCH_HIST_BUCKETS  24          // log2 buckets, 1 usec ... 8 sec
+#define BENCH_IRQ_TIMEOUT_MS 100
+
+at86rf215_st dev =
+{
+    .cs_pin = GPIO_CS_OFFSET,
+    .reset_pin = GPIO_RESET_OFFSET,
+    .irq_pin = GPIO_EXT_INT_OFFSET,
+
+    .spi_mode = 0,
+    .spi_bits = 0,
+    .spi_speed = 1000000,
+    .cs_mode = IO_UTILS_CS_GPIO,
+};
+
+static int burst_bytes = 128;
+
+//===================================================================
+static uint64_t bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int bench_compare(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double bench_percentile(const double* sorted, int n, double p)
+{
+    int idx = (int)(p / 100.0 * n + 0.999999) - 1;
+    if (idx < 0) idx = 0;
+    if (idx >= n) idx = n - 1;
+    return sorted[idx];
+}
+
+//===================================================================
+// bench_report - percentiles and log2 histogram of 'n' samples [usec]
+static void bench_report(const char* name, double* us, int n, int missed)
+{
+    int hist[BENCH_HIST_BUCKETS] = {0};
+    double sum = 0.0;
+
+    if (n == 0)
+    {
+        printf("BENCH:AT86RF215:%s:N=0,MISSED=%d\n", name, missed);
+        return;
+    }
+
+    qsort(us, n, sizeof(double), bench_compare);
+
+    for (int i = 0; i < n; i++)
+    {
+        int b = 0;
+        sum += us[i];
+        while (b < BENCH_HIST_BUCKETS - 1 && us[i] >= (double)(1 << b)) b++;
+        hist[b]++;
+    }
+
+    printf("BENCH:AT86RF215:%s:N=%d,MIN=%.2f,P50=%.2f,P90=%.2f,P99=%.2f,P999=%.2f,MAX=%.2f,MEAN=%.2f", name, n,
+           us[0], bench_percentile(us, n, 50), bench_percentile(us, n, 90), bench_percentile(us, n, 99),
+           bench_percentile(us, n, 99.9), us[n - 1], sum / n);
+    if (missed) printf(",MISSED=%d", missed);
+    printf("\n");
+
+    printf("BENCH:AT86RF215:%s:HIST=", name);
+    for (int b = 0, first = 1; b < BENCH_HIST_BUCKETS; b++)
+    {
+        if (hist[b] == 0) continue;
+        printf("%s%u:%d", first ? "" : ",", 1u << b, hist[b]);
+        first = 0;
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+//===================================================================
+// Timed operations (i - iteration, lets writes alternate so the register shadow does not trim them) ...
+static void bench_reg_read(at86rf215_st* dev, int i)
+{
+    at86rf215_read_byte(dev, REG_RF09_STATE);
+}
+
+static void bench_reg_write(at86rf215_st* dev, int i)
+{
+    at86rf215_write_byte(dev, REG_BBC0_MACEA0, (uint8_t)i);
+}
+
+static void bench_burst_read(at86rf215_st* dev, int i)
+{
+    static uint8_t buf[0x800];
+    at86rf215_read_burst(dev, REG_BBC0_FBTXS, buf, burst_bytes);
+}
+
+static void bench_burst_write(at86rf215_st* dev, int i)
+{
+    static uint8_t buf[0x800];
+    buf[0] = (uint8_t)i;
+    at86rf215_write_burst(dev, REG_BBC0_FBTXS, buf, burst_bytes);
+}
+
+static void bench_get_irqs(at86rf215_st* dev, int i)
+{
+    at86rf215_irq_st irq;
+    at86rf215_get_irqs(dev, &irq, 0);
+}
+
+static void bench_setup_channel(at86rf215_st* dev, int i)
+{
+    at86rf215_setup_channel(dev, at86rf215_rf_channel_900mhz, (i & 1) ? 915000000 : 900000000);
+}
+
+static void bench_setup_rx(at86rf215_st* dev, int i)
+{
+    at86rf215_rx_control_st rx_control = {0};
+    at86rf215_setup_iq_radio_receive(dev, at86rf215_rf_channel_900mhz, (i & 1) ? 915000000 : 900000000,
+                                     &rx_control, 0, at86rf215_iq_clock_data_skew_1_906ns);
+}
+
+static void bench_setup_tx(at86rf215_st* dev, int i)
+{
+    at86rf215_tx_control_st tx_control = {0};
+    at86rf215_setup_iq_radio_transmit(dev, at86rf215_rf_channel_900mhz, (i & 1) ? 915000000 : 900000000,
+                                      &tx_control, 0, at86rf215_iq_clock_data_skew_1_906ns);
+}
+
+static void bench_calibrate(at86rf215_st* dev, int i)
+{
+    at86rf215_calibrate_device(dev, at86rf215_rf_channel_900mhz, NULL, NULL);
+}
+
+//===================================================================
+static void bench_run(const char* name, int n, void (*op)(at86rf215_st*, int))
+{
+    double* us = malloc(n * sizeof(double));
+
+    for (int i = 0; i < n; i++)
+    {
+        uint64_t t0 = bench_now();
+        op(&dev, i);
+        us[i] = (bench_now() - t0) / 1e3;
+    }
+
+    bench_report(name, us, n, 0);
+    free(us);
+}
+
+//===================================================================
+// bench_states - TRXOFF --> TXPREP --> RX through at86rf215_radio_set_state, each transition on its own
+static void bench_states(int n)
+{
+    double* us[3];
+    static const at86rf215_radio_state_cmd_en cmd[3] = {at86rf215_radio_state_cmd_trx_off,
+                                                        at86rf215_radio_state_cmd_tx_prep,
+                                                        at86rf215_radio_state_cmd_rx};
+    static const char* name[3] = {"state_trxoff", "state_txprep", "state_rx"};
+
+    for (int s = 0; s < 3; s++) us[s] = malloc(n * sizeof(double));
+    at86rf215_radio_reset_state_stats(&dev, at86rf215_rf_channel_900mhz);
+
+    for (int i = 0; i < n; i++)
+    {
+        for (int s = 0; s < 3; s++)
+        {
+            uint64_t t0 = bench_now();
+            at86rf215_radio_set_state(&dev, at86rf215_rf_channel_900mhz, cmd[s]);
+            us[s][i] = (bench_now() - t0) / 1e3;
+        }
+    }
+
+    for (int s = 0; s < 3; s++)
+    {
+        bench_report(name[s], us[s], n, 0);
+        free(us[s]);
+    }
+
+    // Transition time measured by the library (CMD write --> RFn_STATE) ...
+    at86rf215_radio_state_stats_st st;
+    at86rf215_radio_get_state_stats(&dev, at86rf215_rf_channel_900mhz, &st);
+    printf("BENCH:AT86RF215:state_transitions:N=%llu,TIMEOUTS=%llu,POLLS=%llu,MEAN=%.2f,MAX=%.2f\n",
+           (unsigned long long)st.transitions, (unsigned long long)st.timeouts, (unsigned long long)st.polls,
+           st.transitions ? st.total_ns / 1e3 / st.transitions : 0.0, st.max_ns / 1e3);
+
+    at86rf215_radio_set_state(&dev, at86rf215_rf_channel_900mhz, at86rf215_radio_state_cmd_trx_off);
+}
+
+//===================================================================
+// bench_irq_waiter - RF09_CMD=TXPREP write until the TRXRDY waiter returns (at86rf215_wait_event, -I strategy)
+// IRQ: chip transition + IRQ line + GPIO poll thread + IRQS read + event signal + wake-up, POLL: transition + IRQS polls
+static void bench_irq_waiter(int n)
+{
+    double* us = malloc(n * sizeof(double));
+    event_st* ev = &dev.events.lo_trx_ready_event;
+    int got = 0, missed = 0;
+
+    int irqm = at86rf215_read_byte(&dev, REG_RF09_IRQM);
+    at86rf215_write_byte(&dev, REG_RF09_IRQM, irqm | (1 << RF_IRQM_TRXRDY));
+
+    for (int i = 0; i < n; i++)
+    {
+        at86rf215_radio_set_state(&dev, at86rf215_rf_channel_900mhz, at86rf215_radio_state_cmd_trx_off);
+        event_node_signal_ready(ev, 0);
+
+        uint64_t t0 = bench_now();
+        at86rf215_write_byte(&dev, REG_RF09_CMD, at86rf215_radio_state_cmd_tx_prep);
+        if (at86rf215_wait_event(&dev, ev, BENCH_IRQ_TIMEOUT_MS * 1000) == 0) us[got++] = (bench_now() - t0) / 1e3;
+        else missed++;
+    }
+
+    at86rf215_write_byte(&dev, REG_RF09_IRQM, irqm);
+    at86rf215_radio_set_state(&dev, at86rf215_rf_channel_900mhz, at86rf215_radio_state_cmd_trx_off);
+
+    bench_report("irq_waiter", us, got, missed);
+    free(us);
+}
+
+//===================================================================
+// bench_irq_wake_report - IRQ edge timestamp --> IRQ thread running, recorded by the thread itself
+static void bench_irq_wake_report(void)
+{
+    gpio_wake_stats_s st;
+
+    at86rf215_get_irq_wake_stats(&dev, &st);
+    if (st.count == 0)
+    {
+        printf("BENCH:AT86RF215:irq_wake:N=0\n");
+        return;
+    }
+
+    printf("BENCH:AT86RF215:irq_wake:N=%llu,MAX=%.2f,MEAN=%.2f\n", (unsigned long long)st.count, st.max_ns / 1e3,
+           st.total_ns / 1e3 / st.count);
+    printf("BENCH:AT86RF215:irq_wake:HIST=");
+    for (int b = 0, first = 1; b < GPIO_WAKE_HIST_BINS; b++)
+    {
+        if (st.hist[b] == 0) continue;
+        printf("%s%u:%llu", first ? "" : ",", 1u << b, (unsigned long long)st.hist[b]);
+        first = 0;
+    }
+    printf("\n");
+}
+
+//===================================================================
+// bench_irq_latency_report - where the TRXRDY latency goes: edge --> handler --> IRQS read --> dispatch --> waiter
+static void bench_irq_latency_report(void)
+{
+    at86rf215_irq_latency_st lat;
+
+    at86rf215_get_irq_latency(&dev, &lat);
+    for (int s = 0; s < at86rf215_irq_lat_stages; s++)
+    {
+        at86rf215_irq_lat_hist_st *h = &lat.stage[s];
+        const char* name = at86rf215_irq_latency_stage_name(s);
+
+        if (h->count == 0)
+        {
+            printf("BENCH:AT86RF215:irq_lat_%s:N=0\n", name);
+            continue;
+        }
+
+        // Median from the histogram (lower bound of the bin) ...
+        uint64_t acc = 0;
+        int b = 0;
+        for (; b < AT86RF215_IRQ_LAT_BINS - 1 && (acc += h->hist[b]) * 2 < h->count; b++);
+
+        printf("BENCH:AT86RF215:irq_lat_%s:N=%llu,MAX=%.2f,MEAN=%.2f,MEDIAN>=%.2f\n", name, (unsigned long long)h->count,
+               h->max_ns / 1e3, h->total_ns / 1e3 / h->count, at86rf215_irq_latency_bin_ns(b) / 1e3);
+    }
+}
+
+//===================================================================
+int main(int argc, char *argv[])
+{
+    int iterations = 1000;
+    int slow = 20;
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "ezd:s:n:m:b:cP:C:kLI:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'e': dev.emulated = 1; break;
+            case 'z': dev.emu_timing_pct = AT86RF215_EMU_TIMING_INSTANT; break;
+            case 'd': dev.spi_dev = optarg; break;
+            case 's': dev.spi_speed = atoi(optarg); break;
+            case 'n': iterations = atoi(optarg); break;
+            case 'm': slow = atoi(optarg); break;
+            case 'b': burst_bytes = atoi(optarg); break;
+            case 'c': dev.cs_mode = IO_UTILS_CS_NATIVE; break;
+            case 'P': dev.irq_thread_policy = SCHED_FIFO; dev.irq_thread_priority = atoi(optarg); break;
+            case 'C': dev.irq_thread_cpus = strtoul(optarg, NULL, 0); break;
+            case 'k': dev.irq_thread_stack = 64 * 1024; break;
+            case 'L': dev.lock_memory = 1; break;
+            case 'I': dev.irq_mode = atoi(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s [-e emulated] [-z instant emulator timing] [-d /dev/spidevX.Y] [-s spi_speed] "
+                                "[-n iterations] [-m slow iterations] [-b burst bytes] [-c native CS] "
+                                "[-P IRQ thread SCHED_FIFO priority] [-C IRQ thread CPU mask] [-k locked IRQ stack] [-L mlockall] "
+                                "[-I IRQ mode 0 - irq, 1 - poll, 2 - hybrid]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (iterations < 1) iterations = 1;
+    if (slow < 1) slow = 1;
+    if (burst_bytes < 1 || burst_bytes > 0x800) burst_bytes = 128;
+
+    if (at86rf215_init(&dev) == -1)
+    {
+        return 1;
+    }
+
+    printf("BENCH:AT86RF215:CONFIG:TRANSPORT=%s,EMULATED=%d,SPI_SPEED=%d,CS_MODE=%d,ITERATIONS=%d,SLOW_ITERATIONS=%d,BURST=%d,"
+           "IRQ_POLICY=%d,IRQ_PRIO=%d,IRQ_RT=%d,IRQ_CPUS=0x%x,IRQ_MODE=%d\n",
+           dev.io.transport->name, dev.emulated, dev.spi_speed, dev.cs_mode, iterations, slow, burst_bytes,
+           dev.irq_thread_policy, dev.irq_thread_priority, dev.io.irq_event.rt_applied, dev.irq_thread_cpus, dev.irq_mode);
+
+    bench_run("reg_read", iterations, bench_reg_read);
+    bench_run("reg_write", iterations, bench_reg_write);
+    bench_run("burst_read", iterations, bench_burst_read);
+    bench_run("burst_write", iterations, bench_burst_write);
+    bench_run("get_irqs", iterations, bench_get_irqs);
+    bench_run("setup_channel", iterations, bench_setup_channel);
+    bench_states(slow);
+    at86rf215_reset_irq_wake_stats(&dev);
+    at86rf215_reset_irq_latency(&dev);
+    bench_irq_waiter(slow);
+    bench_irq_wake_report();
+    bench_irq_latency_report();
+    bench_run("setup_rx", slow, bench_setup_rx);
+    at86rf215_stop_iq_radio_receive(&dev, at86rf215_rf_channel_900mhz);
+    bench_run("setup_tx", slow, bench_setup_tx);
+    bench_run("calibrate", (slow / 4 > 3) ? slow / 4 : 3, bench_calibrate);
+
+    at86rf215_close(&dev, 1);
+    return 0;
+}
@@ -0,0 +1,188 @@
+/*
+ * DesignWare SSI / GPIO transport - register level test against memory backed fake register blocks
+ * File: "dw_test_fake_regs.c" - test module (built with IO_UTILS_DW_REG_HOOKS)
+ */
+
+#include "io_utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FAKE_FIFO_DEPTH   64      // Power of two - TXFTLR keeps log2(depth) bits
+#define FAKE_CLOCK_BYTES  5       // Bytes shifted per FIFO level poll
+#define FAKE_CS_OFFSET    3
+
+// Plain memory behind the register blocks ...
+static uint32_t ssi_mem[0x100 / 4];
+static uint32_t gpio_mem[0x80 / 4];
+
+// FIFOs + AT86RF215 like slave (2 byte address, bit 15 - write, auto increment) ...
+static uint8_t tx_fifo[FAKE_FIFO_DEPTH], rx_fifo[FAKE_FIFO_DEPTH];
+static int tx_head, tx_count, rx_head, rx_count;
+static uint8_t chip[0x4000];
+static int frame_idx, frame_write;
+static uint16_t frame_addr;
+static int cs_low;
+static int stalled;                 // Slave clock stopped - transfer never completes
+static int err_tx_overflow, err_rx_overflow, err_rx_underflow, err_cs_high, cs_frames;
+
+static uint8_t fake_slave_byte(uint8_t mosi){
+    
+    uint8_t miso = 0;
+    
+    if(frame_idx == 0){
+       frame_write = (mosi & 0x80) != 0;
+       frame_addr = (uint16_t)(mosi & 0x3F) << 8;
+    }else if(frame_idx == 1){
+       frame_addr |= mosi;
+    }else{
+       if(frame_write) chip[frame_addr] = mosi;
+       else miso = chip[frame_addr];
+       frame_addr = (frame_addr + 1) & 0x3FFF;
+    }
+    frame_idx++;
+    
+    return miso;
+}
+
+// fake_clock - shift a few bytes from TX FIFO to slave, responses into RX FIFO
+static void fake_clock(void){
+    
+    if(stalled || !ssi_mem[DW_SSI_SSIENR >> 2] || !ssi_mem[DW_SSI_SER >> 2]) return;
+    
+    for(int i=0;i<FAKE_CLOCK_BYTES && tx_count > 0;i++){
+        uint8_t mosi = tx_fifo[tx_head];
+        tx_head = (tx_head + 1) % FAKE_FIFO_DEPTH;
+        tx_count--;
+        
+        if(!cs_low) err_cs_high++;
+        
+        if(rx_count == FAKE_FIFO_DEPTH){
+           err_rx_overflow++;
+           continue;
+        }
+        rx_fifo[(rx_head + rx_count) % FAKE_FIFO_DEPTH] = fake_slave_byte(mosi);
+        rx_count++;
+    }
+}
+
+uint32_t io_utils_dw_reg_read(volatile uint32_t *base, uint32_t ofs){
+    
+    if(base == ssi_mem){
+       switch(ofs){
+           case DW_SSI_TXFLR: fake_clock(); return tx_count;
+           case DW_SSI_RXFLR: fake_clock(); return rx_count;
+           case DW_SSI_SR: return tx_count ? DW_SSI_SR_BUSY : 0;
+           case DW_SSI_DR:
+               if(rx_count == 0){ err_rx_underflow++; return 0; }
+               uint8_t b = rx_fifo[rx_head];
+               rx_head = (rx_head + 1) % FAKE_FIFO_DEPTH;
+               rx_count--;
+               return b;
+       }
+    }
+    
+    return base[ofs >> 2];
+}
+
+void io_utils_dw_reg_write(volatile uint32_t *base, uint32_t ofs, uint32_t val){
+    
+    if(base == ssi_mem){
+       switch(ofs){
+           case DW_SSI_DR:
+               if(tx_count == FAKE_FIFO_DEPTH){ err_tx_overflow++; return; }
+               tx_fifo[(tx_head + tx_count) % FAKE_FIFO_DEPTH] = (uint8_t)val;
+               tx_count++;
+               return;
+           case DW_SSI_TXFTLR:
+               val &= FAKE_FIFO_DEPTH - 1;
+               break;
+           case DW_SSI_SSIENR:
+               if(!val) tx_count = rx_count = 0;   // Disabling SSI clears both FIFOs
+               break;
+       }
+    }
+    
+    if(base == gpio_mem && ofs == DW_GPIO_DR){
+       int low = !(val & (1u << FAKE_CS_OFFSET));
+       if(low && !cs_low){ frame_idx = 0; cs_frames++; }
+       cs_low = low;
+    }
+    
+    base[ofs >> 2] = val;
+}
+
+static int check(const char *name, int pass){
+    
+    printf("TEST:IO_UTILS_DW:%s:PASS=%d\n", name, pass);
+    return pass ? 0 : 1;
+}
+
+int main(int argc, char *argv[]){
+    
+    io_utils_dev_s io;
+    static uint8_t tx[2047], rx[2047];
+    uint8_t ea[8] = {0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF}, ea_rx[8] = {0};
+    uint8_t slot[2] = {0};
+    int fails = 0;
+    
+    io_utils_dev_init(&io);
+    io_utils_set_transport(&io, IO_UTILS_TRANSPORT_DW_UIO);
+    io_utils_setup_gpio(&io, "fake", "fake", FAKE_CS_OFFSET);
+    io_utils_dw_configure(&io, NULL, 200000000);
+    io_utils_dw_attach(&io, ssi_mem, gpio_mem, 0, 1000000);
+    
+    // Controller setup ...
+    fails += check("FIFO_DEPTH", io.dw.fifo_depth == FAKE_FIFO_DEPTH);
+    fails += check("BAUDR", ssi_mem[DW_SSI_BAUDR >> 2] == 200 && io_utils_dw_baudr(200000000, 30000000) == 8 &&
+                            io_utils_dw_baudr(200000000, 400000000) == 2);
+    fails += check("CS_IDLE_HI", (gpio_mem[DW_GPIO_DDR >> 2] & (1u << FAKE_CS_OFFSET)) && !cs_low);
+    
+    // Register path ...
+    io_utils_spi_write_buffer(&io, 0x8325, ea, sizeof(ea));
+    io_utils_spi_read_buffer(&io, 0x0325, ea_rx, sizeof(ea_rx));
+    fails += check("REG_RW", memcmp(ea, ea_rx, sizeof(ea)) == 0 && memcmp(&chip[0x0325], ea, sizeof(ea)) == 0);
+    
+    // Burst path (longer than FIFO) + per-transfer speed ...
+    for(int i=0;i<(int)sizeof(tx);i++) tx[i] = (uint8_t)(i * 7 + 3);
+    io_utils_spi_set_xfer_speed(&io, 1000000, 25000000);
+    io_utils_spi_write_burst(&io, 0xA800, tx, sizeof(tx));
+    io_utils_spi_read_burst(&io, 0x2800, rx, sizeof(rx));
+    fails += check("BURST_RW", memcmp(tx, rx, sizeof(tx)) == 0 && ssi_mem[DW_SSI_BAUDR >> 2] == 8);
+    
+    // Batch (one CS frame per operation) ...
+    io_utils_spi_batch_s *batch = calloc(1, sizeof(*batch));
+    uint8_t v = 0x5A;
+    io_utils_spi_batch_begin(batch);
+    io_utils_spi_batch_append_write(batch, 0x8100, &v, 1);
+    io_utils_spi_batch_append_read(batch, 0x0325, slot, 2);
+    io_utils_spi_batch_commit(&io, batch);
+    fails += check("BATCH", chip[0x0100] == 0x5A && slot[0] == 0x01 && slot[1] == 0x23 && ssi_mem[DW_SSI_BAUDR >> 2] == 200);
+    free(batch);
+    
+    fails += check("FIFO_ERRORS", err_tx_overflow == 0 && err_rx_overflow == 0 && err_rx_underflow == 0 && tx_count == 0 && rx_count == 0);
+    fails += check("CS_FRAMING", err_cs_high == 0 && cs_frames == 6 && !cs_low);
+    
+    // Stalled transfer - FIFOs flushed, next access starts clean at the right speed ...
+    stalled = 1;
+    int ret = io_utils_spi_write_buffer(&io, 0x8325, ea, sizeof(ea));
+    int flushed = (tx_count == 0 && rx_count == 0);
+    stalled = 0;
+    memset(ea_rx, 0, sizeof(ea_rx));
+    io_utils_spi_read_buffer(&io, 0x0325, ea_rx, sizeof(ea_rx));
+    fails += check("STALL_FLUSH", ret < 0 && flushed && memcmp(ea, ea_rx, sizeof(ea)) == 0 && ssi_mem[DW_SSI_BAUDR >> 2] == 200);
+    
+    // Native CS is rejected (SSI drops it whenever the TX FIFO runs empty) ...
+    io_utils_dev_s io_native;
+    io_utils_dev_init(&io_native);
+    io_utils_set_transport(&io_native, IO_UTILS_TRANSPORT_DW_UIO);
+    io_utils_set_cs_mode(&io_native, IO_UTILS_CS_NATIVE);
+    fails += check("CS_NATIVE_REJECTED", io_utils_dw_attach(&io_native, ssi_mem, gpio_mem, 0, 1000000) < 0);
+    
+    printf("TEST:IO_UTILS_DW:RESULT=%s\n", fails ? "FAIL" : "PASS");
+    
+    return fails ? 1 : 0;
+}
+
+/*** end of "dw_test_fake_regs.c" file ***/
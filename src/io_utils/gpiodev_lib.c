@@ -3,6 +3,10 @@
  * Pavel Fiala @ 2024
  **/
 
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE     // cpu_set_t, pthread_attr_setaffinity_np
+#endif
+
 #include <sys/ioctl.h>
 #include <sys/poll.h>
 #include <unistd.h>
@@ -14,6 +18,9 @@
 #include <getopt.h>
 #include <stdlib.h>
 #include <pthread.h>
+#include <sched.h>
+#include <limits.h>
+#include <sys/mman.h>
 #include <errno.h>
 
 #include "gpiodev_lib.h"
@@ -21,21 +28,10 @@
 // Enable GPIO debug option
 // #define GPIODEV_DEBUG
 
-typedef struct gpio_event_t{
-    char *dev_name;
-    int offset;
-    int thread_status;
-    uint32_t event_flags;
-    time_t wait_time;
-    void (*gpio_event_isr_callback)(void *user_param, void *user_data);
-    void *gpio_event_isr_param;
-    void *gpio_event_isr_user_data;
-}gpio_event_s;
-
-// Static variables
-int pipes[2];
-static pthread_t event_thread;
-static gpio_event_s event_struct;
+// Event clock flags by value - older (5.10+) uAPI headers do not name them yet
+#define GPIO_LIB_V2_FLAG_CLOCK_REALTIME (1ULL << 11)   // GPIO_V2_LINE_FLAG_EVENT_CLOCK_REALTIME (5.11)
+#define GPIO_LIB_V2_FLAG_CLOCK_HTE      (1ULL << 12)   // GPIO_V2_LINE_FLAG_EVENT_CLOCK_HTE (5.19)
+
 // Static function
 void *gpio_poll_wait_thread(void *ptr);
 
@@ -148,6 +144,65 @@ void gpio_write_single(const char *dev_name, int offset, uint8_t value){
     close(rq.fd);
 }
 
+/* GPIO request single output line - returns line handle fd (kept open by caller) or -1 */
+int gpio_line_request_output(const char *dev_name, int offset, uint8_t value){
+    
+    int fd = 0, ret = 0;
+    
+    struct gpiohandle_request rq = {0};
+    
+    fd = open(dev_name, O_RDONLY | O_NONBLOCK);
+    
+    if(fd < 0){
+#ifdef GPIODEV_DEBUG        
+       printf("Unabled to open %s: %s", dev_name, strerror(errno));
+#endif       
+       return -1;
+    }
+    
+    rq.lineoffsets[0] = offset;
+    // Set GPIO as output with initial value ...
+    rq.flags = GPIOHANDLE_REQUEST_OUTPUT;
+    rq.default_values[0] = value;
+    rq.lines = 1;
+    strncpy(rq.consumer_label, "at86rf215_cs", sizeof(rq.consumer_label) - 1);
+    // Request a GPIO line from the kernel - line handle stays valid after chip fd is closed ...
+    ret = ioctl(fd, GPIO_GET_LINEHANDLE_IOCTL, &rq);
+    close(fd);
+    
+    if(ret == -1){
+#ifdef GPIODEV_DEBUG         
+       printf("Unable to line handle from ioctl : %s", strerror(errno));
+#endif          
+       return -1;
+    }
+    
+    return rq.fd;
+}
+
+/* GPIO set value on already requested line handle - single ioctl */
+int gpio_line_set_value(int line_fd, uint8_t value){
+    
+    struct gpiohandle_data data = {0};
+    
+    data.values[0] = value;
+    
+    if(ioctl(line_fd, GPIOHANDLE_SET_LINE_VALUES_IOCTL, &data) == -1){
+#ifdef GPIODEV_DEBUG        
+        printf("Unable to set line value using ioctl : %s", strerror(errno));
+#endif        
+        return -1;
+    }
+    
+    return 0;
+}
+
+/* GPIO release line handle */
+void gpio_line_release(int line_fd){
+    
+    if(line_fd >= 0) close(line_fd);
+}
+
 /* GPIO read single GPIO */
 int gpio_read_single(const char *dev_name, int offset, uint8_t *value){
     
@@ -257,117 +312,394 @@ int gpio_poll_wait(const char *dev_name, int offset, int timeout, uint32_t event
 }
 
 
-void *gpio_poll_wait_thread(void *ptr){
+/* ---------------------------------------------------------------------------------------------
+ * GPIO character device uAPI v2 - output lines and the edge detected input on one request fd
+ * --------------------------------------------------------------------------------------------- */
+
+/* gpio_v2_line_index - index of the line offset in the request (-1 - not part of it) */
+int gpio_v2_line_index(const gpio_v2_lines_s *lines, int offset){
     
-    int fd = 0, ret = 0, res = 0;
-    int gpio_event_enables = 0;
+    if(lines->fd < 0 || offset < 0) return -1;
     
-    struct gpioevent_request rq = {0};
-    struct pollfd pfds[2] = {0};
-    struct timespec remaining = {0};
-    struct timespec request = {0};
+    for(int i = 0; i < lines->num_lines; i++){
+        if(lines->offsets[i] == (unsigned int)offset) return i;
+    }
     
-    // Set to zero ...
-    memset(&pfds, 0, sizeof(pfds));
+    return -1;
+}
 
-    struct gpio_event_t *thread_ptr = (struct gpio_event_t *)ptr;
+/* gpio_v2_request_lines - outputs (initial values) + optional input with edge detection, kernel debounce and event clock
+ * Returns 0 or -1 (kernel without uAPI v2 - caller falls back to v1). HTE clock falls back to MONOTONIC if not available */
+int gpio_v2_request_lines(gpio_v2_lines_s *lines, const char *dev_name, const char *consumer,
+                          const int *out_offsets, const uint8_t *out_values, int num_out,
+                          int irq_offset, uint32_t event_flags, int event_clock, uint32_t debounce_us){
     
-    pfds[0].fd = pipes[0];
-    pfds[0].events = POLLIN;
+    struct gpio_v2_line_request rq;
+    int ret = -1;
+    
+    lines->fd = -1;
+    lines->num_lines = 0;
+    lines->event_clock = GPIO_EVENT_CLOCK_MONOTONIC;
+    
+    if(num_out + (irq_offset >= 0) > GPIO_V2_REQ_MAX_LINES || num_out + (irq_offset >= 0) == 0) return -1;
     
-    // Wait if thread_ptr->wait_time is higher then 0 ... 
-    if(thread_ptr->wait_time !=0){
-       request.tv_sec = 0;
-       request.tv_nsec = thread_ptr->wait_time; 
+    int fd = open(dev_name, O_RDONLY | O_NONBLOCK);
+    
+    if(fd < 0){
+#ifdef GPIODEV_DEBUG        
+       printf("Unabled to open %s: %s", dev_name, strerror(errno));
+#endif       
+       return -1;
     }
     
-#ifdef GPIODEV_DEBUG    
-    printf("Pthread will be executed ...\n");
+    while(1){
+        memset(&rq, 0, sizeof(rq));
+        strncpy(rq.consumer, consumer, sizeof(rq.consumer) - 1);
+        
+        uint64_t out_mask = 0, out_bits = 0, irq_mask = 0;
+        
+        for(int i = 0; i < num_out; i++){
+            rq.offsets[i] = out_offsets[i];
+            out_mask |= 1ULL << i;
+            if(out_values[i]) out_bits |= 1ULL << i;
+        }
+        rq.num_lines = num_out;
+        
+        // Input line - default config of the request, outputs get their own attributes ...
+        if(irq_offset >= 0){
+            irq_mask = 1ULL << rq.num_lines;
+            rq.offsets[rq.num_lines++] = irq_offset;
+            
+            rq.config.flags = GPIO_V2_LINE_FLAG_INPUT;
+            if(event_flags & GPIOEVENT_REQUEST_RISING_EDGE) rq.config.flags |= GPIO_V2_LINE_FLAG_EDGE_RISING;
+            if(event_flags & GPIOEVENT_REQUEST_FALLING_EDGE) rq.config.flags |= GPIO_V2_LINE_FLAG_EDGE_FALLING;
+            if(event_clock == GPIO_EVENT_CLOCK_REALTIME) rq.config.flags |= GPIO_LIB_V2_FLAG_CLOCK_REALTIME;
+            if(event_clock == GPIO_EVENT_CLOCK_HTE) rq.config.flags |= GPIO_LIB_V2_FLAG_CLOCK_HTE;
+            rq.event_buffer_size = GPIO_POLL_EVENT_BATCH * 4;
+            
+            if(debounce_us > 0){
+                struct gpio_v2_line_config_attribute *attr = &rq.config.attrs[rq.config.num_attrs++];
+                attr->attr.id = GPIO_V2_LINE_ATTR_ID_DEBOUNCE;
+                attr->attr.debounce_period_us = debounce_us;
+                attr->mask = irq_mask;
+            }
+        }else{
+            rq.config.flags = GPIO_V2_LINE_FLAG_OUTPUT;
+        }
+        
+        if(num_out > 0){
+            struct gpio_v2_line_config_attribute *attr = &rq.config.attrs[rq.config.num_attrs++];
+            attr->attr.id = GPIO_V2_LINE_ATTR_ID_FLAGS;
+            attr->attr.flags = GPIO_V2_LINE_FLAG_OUTPUT;
+            attr->mask = out_mask;
+            
+            attr = &rq.config.attrs[rq.config.num_attrs++];
+            attr->attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+            attr->attr.values = out_bits;
+            attr->mask = out_mask;
+        }
+        
+        ret = ioctl(fd, GPIO_V2_GET_LINE_IOCTL, &rq);
+        
+        // No hardware timestamp engine for this line - kernel MONOTONIC timestamps ...
+        if(ret == -1 && irq_offset >= 0 && event_clock == GPIO_EVENT_CLOCK_HTE){
+#ifdef GPIODEV_DEBUG
+           printf("HTE timestamps not available (%s), using CLOCK_MONOTONIC\n", strerror(errno));
 #endif
+           event_clock = GPIO_EVENT_CLOCK_MONOTONIC;
+           continue;
+        }
+        break;
+    }
     
-    // While (1) loop ...
-    while(1){
-        if(!gpio_event_enables){
-            fd = open(thread_ptr->dev_name, O_RDONLY | O_NONBLOCK);
+    close(fd);
+    
+    if(ret == -1){
+#ifdef GPIODEV_DEBUG         
+       printf("Unable to get v2 line request from ioctl : %s", strerror(errno));
+#endif          
+       return -1;
+    }
+    
+    lines->fd = rq.fd;
+    lines->num_lines = rq.num_lines;
+    lines->event_clock = event_clock;
+    memcpy(lines->offsets, rq.offsets, rq.num_lines * sizeof(rq.offsets[0]));
+    
+    return 0;
+}
+
+/* gpio_v2_set_value - one output line of the request - single ioctl */
+int gpio_v2_set_value(gpio_v2_lines_s *lines, int offset, uint8_t value){
+    
+    struct gpio_v2_line_values values = {0};
+    int idx = gpio_v2_line_index(lines, offset);
+    
+    if(idx < 0) return -1;
+    
+    values.mask = 1ULL << idx;
+    values.bits = value ? values.mask : 0;
+    
+    if(ioctl(lines->fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values) == -1){
+#ifdef GPIODEV_DEBUG        
+        printf("Unable to set v2 line value using ioctl : %s", strerror(errno));
+#endif        
+        return -1;
+    }
+    
+    return 0;
+}
+
+/* gpio_v2_get_value - current level of one line of the request (0 / 1, -1 on error) */
+int gpio_v2_get_value(gpio_v2_lines_s *lines, int offset){
     
-            if(fd < 0){
+    struct gpio_v2_line_values values = {0};
+    int idx = gpio_v2_line_index(lines, offset);
+    
+    if(idx < 0) return -1;
+    
+    values.mask = 1ULL << idx;
+    
+    if(ioctl(lines->fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) == -1) return -1;
+    
+    return (values.bits & values.mask) ? 1 : 0;
+}
+
+/* gpio_v2_release - release all lines of the request */
+void gpio_v2_release(gpio_v2_lines_s *lines){
+    
+    if(lines->fd >= 0) close(lines->fd);
+    lines->fd = -1;
+    lines->num_lines = 0;
+}
+
+/* gpio_poll_request_line - line event fd (requested once, kept for the thread lifetime) */
+static int gpio_poll_request_line(struct gpio_event_t *thread_ptr){
+    
+    struct gpioevent_request rq = {0};
+    
+    int fd = open(thread_ptr->dev_name, O_RDONLY | O_NONBLOCK);
+    
+    if(fd < 0){
 #ifdef GPIODEV_DEBUG           
-                printf("Unabled to open %s: %s", thread_ptr->dev_name, strerror(errno));
+        printf("Unabled to open %s: %s", thread_ptr->dev_name, strerror(errno));
 #endif        
-                return NULL;
-            } 
-            // https://dri.freedesktop.org/docs/drm/userspace-api/gpio/gpio-handle-get-line-values-ioctl.html
-            rq.handleflags = GPIOHANDLE_REQUEST_INPUT; /* !!! Do not use this option here: GPIOHANDLE_REQUEST_ACTIVE_LOW | */          
-            rq.lineoffset = thread_ptr->offset;
-            rq.eventflags = thread_ptr->event_flags; // GPIOEVENT_EVENT_RISING_EDGE or GPIOEVENT_EVENT_FALLING_EDGE
-          
-            ret = ioctl(fd, GPIO_GET_LINEEVENT_IOCTL, &rq);
-            close(fd); fd = 0;
+        return -1;
+    } 
+    // https://dri.freedesktop.org/docs/drm/userspace-api/gpio/gpio-handle-get-line-values-ioctl.html
+    rq.handleflags = GPIOHANDLE_REQUEST_INPUT; /* !!! Do not use this option here: GPIOHANDLE_REQUEST_ACTIVE_LOW | */          
+    rq.lineoffset = thread_ptr->offset;
+    rq.eventflags = thread_ptr->event_flags; // GPIOEVENT_EVENT_RISING_EDGE or GPIOEVENT_EVENT_FALLING_EDGE
+    
+    int ret = ioctl(fd, GPIO_GET_LINEEVENT_IOCTL, &rq);
+    close(fd);
     
-            if(ret == -1){
+    if(ret == -1){
 #ifdef GPIODEV_DEBUG         
-               printf("Unable to get line event from ioctl : %s", strerror(errno));
+       printf("Unable to get line event from ioctl : %s", strerror(errno));
 #endif
-               close(fd);
-               return NULL;
-            }  
-            
-            pfds[1].fd = rq.fd;
-            pfds[1].events = POLLIN;
-            
-            gpio_event_enables = 1;
+       return -1;
+    }
+    
+    return rq.fd;
+}
+
+/* gpio_poll_line_asserted - line still at the level of the watched edge (1), released (0), unknown (-1 - e.g. pipe) */
+static int gpio_poll_line_asserted(struct gpio_event_t *thread_ptr, int fd){
+    
+    int level = 0;
+    
+    if(thread_ptr->abi == GPIO_ABI_V2){
+       struct gpio_v2_line_values values = {0};
+       
+       if(thread_ptr->line_index < 0) return -1;
+       values.mask = 1ULL << thread_ptr->line_index;
+       if(ioctl(fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) == -1) return -1;
+       level = (values.bits & values.mask) != 0;
+    }else{
+       struct gpiohandle_data data = {0};
+       
+       if(ioctl(fd, GPIOHANDLE_GET_LINE_VALUES_IOCTL, &data) == -1) return -1;
+       level = data.values[0] != 0;
+    }
+    
+    return (thread_ptr->event_flags & GPIOEVENT_EVENT_RISING_EDGE) ? level : !level;
+}
+
+/* gpio_poll_read_events - drain queued edges with one read (v1 / v2 records), newest edge type + timestamp, -1 if nothing read
+ * v2 line sequence numbers expose edges dropped by a full kernel event buffer (thread_ptr->lost) */
+static int gpio_poll_read_events(struct gpio_event_t *thread_ptr, int fd, uint32_t *id, uint64_t *timestamp){
+    
+    int num = 0;
+    
+    if(thread_ptr->abi == GPIO_ABI_V2){
+       struct gpio_v2_line_event events[GPIO_POLL_EVENT_BATCH];
+       ssize_t len = read(fd, events, sizeof(events));
+       
+       if(len < (ssize_t)sizeof(events[0])) return -1;
+       num = len / sizeof(events[0]);
+       
+       for(int i = 0; i < num; i++){
+           if(thread_ptr->last_seqno != 0 && events[i].line_seqno != thread_ptr->last_seqno + 1){
+              thread_ptr->lost += events[i].line_seqno - thread_ptr->last_seqno - 1;
+           }
+           thread_ptr->last_seqno = events[i].line_seqno;
        }
-        
-       if(poll(pfds,2,-1)){ 
+       
+       *id = events[num - 1].id;
+       *timestamp = events[num - 1].timestamp_ns;
+    }else{
+       struct gpioevent_data events[GPIO_POLL_EVENT_BATCH];
+       ssize_t len = read(fd, events, sizeof(events));
+       
+       if(len < (ssize_t)sizeof(events[0])) return -1;
+       num = len / sizeof(events[0]);
+       
+       *id = events[num - 1].id;
+       *timestamp = events[num - 1].timestamp;
+    }
+    
+    thread_ptr->events += num;
+    return num;
+}
+
+/* gpio_poll_dispatch - edge type + kernel timestamp for the callback, then the callback itself */
+static void gpio_poll_dispatch(struct gpio_event_t *thread_ptr, uint32_t id, uint64_t timestamp){
+    
+    if(thread_ptr->gpio_event_isr_param != NULL){
+       *(int *)thread_ptr->gpio_event_isr_param = (id == GPIOEVENT_EVENT_FALLING_EDGE) ? GPIOEVENT_EVENT_FALLING_EDGE : GPIOEVENT_EVENT_RISING_EDGE;
+    }
+    
+    thread_ptr->timestamp = timestamp;
+    
+    // Optional settle time (0 --> callback runs right away) ...
+    if(thread_ptr->wait_time != 0){
+       struct timespec request = {.tv_sec = 0, .tv_nsec = thread_ptr->wait_time};
+       nanosleep(&request, NULL);
+    }
+    
+    thread_ptr->gpio_event_isr_callback(thread_ptr->gpio_event_isr_param, thread_ptr->gpio_event_isr_user_data); // User data can be NULL pointer
+}
+
+/* gpio_poll_clock_ns - now in the clock of the edge timestamps */
+static uint64_t gpio_poll_clock_ns(int event_clock){
+    
+    struct timespec ts;
+    
+    clock_gettime((event_clock == GPIO_EVENT_CLOCK_REALTIME) ? CLOCK_REALTIME : CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* gpio_poll_record_wake - edge timestamp --> now into the wake-up histogram (atomic, read by other threads) */
+static void gpio_poll_record_wake(gpio_event_s *event, uint64_t now, uint64_t timestamp){
+    
+    gpio_wake_stats_s *st = &event->wake;
+    
+    if(event->event_clock == GPIO_EVENT_CLOCK_HTE || timestamp == 0 || now < timestamp){
+       return;
+    }
+    
+    uint64_t ns = now - timestamp;
+    uint64_t usec = ns / 1000;
+    int bin = (usec == 0) ? 0 : 64 - __builtin_clzll(usec);
+    if(bin >= GPIO_WAKE_HIST_BINS) bin = GPIO_WAKE_HIST_BINS - 1;
+    
+    __atomic_add_fetch(&st->count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&st->total_ns, ns, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&st->hist[bin], 1, __ATOMIC_RELAXED);
+    
+    uint64_t max = __atomic_load_n(&st->max_ns, __ATOMIC_RELAXED);
+    while(ns > max && !__atomic_compare_exchange_n(&st->max_ns, &max, ns, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+/* gpio_poll_process - drain queued edges of event->fd and run the callback (again while the line stays asserted)
+ * force - dispatch once even if no edge is queued (software wake-up). Returns number of callbacks */
+int gpio_poll_process(gpio_event_s *event, int force){
+    
+    uint32_t id = GPIOEVENT_EVENT_RISING_EDGE;
+    uint64_t timestamp = event->timestamp;
+    int calls = 0;
+    uint64_t now = gpio_poll_clock_ns(event->event_clock);
+    
+    // Drain all queued edges with one read - the chip IRQ is level based, one callback serves all of them ...
+    int num = gpio_poll_read_events(event, event->fd, &id, &timestamp);
+    if(num < 0 && !force){
+       return 0;
+    }
+    
+    if(num > 0){
+       gpio_poll_record_wake(event, now, timestamp);
+    }
+    
+#ifdef GPIODEV_DEBUG        
+    printf("%d event(s) on GPIO offset: %d, of %s\n", num, event->offset, event->dev_name);
+#endif
+    
+    if(event->gpio_event_isr_callback == NULL){
+       return 0;
+    }
+    
+    gpio_poll_dispatch(event, id, timestamp);
+    calls++;
+    
+    // Missed edge - a new reason latched while the previous one was served keeps the line asserted,
+    // no further edge will come: serve it again (the callback reads the chip status) ...
+    for(int i = 0; i < GPIO_POLL_MAX_REDISPATCH && gpio_poll_line_asserted(event, event->fd) == 1; i++){
+       event->missed++;
+       gpio_poll_dispatch(event, id, timestamp);
+       calls++;
+    }
+    
+    return calls;
+}
+
+void *gpio_poll_wait_thread(void *ptr){
+    
+    int res = 0;
+    
+    struct pollfd pfds[2] = {0};
+    
+    struct gpio_event_t *thread_ptr = (struct gpio_event_t *)ptr;
+    
+    // Line event fd - provided by the caller or requested here, in both cases only once ...
+    int fd = (thread_ptr->line_fd >= 0) ? thread_ptr->line_fd : gpio_poll_request_line(thread_ptr);
+    
+    if(fd < 0){
+       return NULL;
+    }
+    
+    thread_ptr->fd = fd;
+    
+    pfds[0].fd = thread_ptr->pipes[0];
+    pfds[0].events = POLLIN;
+    pfds[1].fd = fd;
+    pfds[1].events = POLLIN;
+    
+#ifdef GPIODEV_DEBUG    
+    printf("Pthread will be executed ...\n");
+#endif
+    
+    // While (1) loop ...
+    while(1){
+       if(poll(pfds,2,-1) < 0){ 
           // Check for errors ...
           if(errno == EINTR){
              continue;
           }
+          break;
+       }
           
-          // Terminate thread ...
-          if(pfds[0].revents & POLLIN){
-             read(pipes[0], &res, sizeof(res));
-             if(res == 1) break;
-          }
+       // Terminate thread ...
+       if(pfds[0].revents & POLLIN){
+          read(thread_ptr->pipes[0], &res, sizeof(res));
+          if(res == 1) break;
+       }
           
-          if(pfds[1].revents & POLLIN){
-#ifdef GPIODEV_DEBUG        
-             printf("%s event on GPIO offset: %d, of %s\n", (rq.eventflags & GPIOEVENT_EVENT_RISING_EDGE) ? "Rising edge": "Falling edge", thread_ptr->offset, thread_ptr->dev_name);
-#endif
-             
-             if(thread_ptr->gpio_event_isr_callback != NULL){
-                // Check for rising edge event ... 
-                if (rq.eventflags & GPIOEVENT_EVENT_RISING_EDGE){
-                    // Execute callback function ... 
-                    if(thread_ptr->gpio_event_isr_param != NULL){
-                       *(int *)thread_ptr->gpio_event_isr_param = GPIOEVENT_EVENT_RISING_EDGE;   
-                    }
-                }
-                
-                // Check for falling edge ...
-                if (rq.eventflags & GPIOEVENT_EVENT_FALLING_EDGE){
-                    // Execute callback function ...
-                    if(thread_ptr->gpio_event_isr_param != NULL){
-                        *(int *)thread_ptr->gpio_event_isr_param = GPIOEVENT_EVENT_FALLING_EDGE;
-                    }
-                }
-                
-                // Close rq.fd ... 
-                close(rq.fd);
-                gpio_event_enables = 0; 
-                
-                // Wait if thread_ptr->wait_time is higher then 0 ... 
-                if(thread_ptr->wait_time !=0){
-                   nanosleep(&request, &remaining); 
-                }
-                
-                // Call predefine callback ...  
-                thread_ptr->gpio_event_isr_callback(thread_ptr->gpio_event_isr_param, thread_ptr->gpio_event_isr_user_data); // User data can be NULL pointer
-                
-             }
-
-          }
-       } 
+       if(!(pfds[1].revents & POLLIN)){
+          continue;
+       }
+       
+       gpio_poll_process(thread_ptr, 0);
     }
     
     // Closing thread session ...
@@ -375,74 +707,273 @@ void *gpio_poll_wait_thread(void *ptr){
     printf("Pthread is about to terminate ...\n");
 #endif
     
-    // Close rq.fd ...
-    if(gpio_event_enables) close(rq.fd);  
+    // Close own line event fd (caller provided fd stays open) ...
+    if(thread_ptr->line_fd < 0) close(fd);  
     
     return NULL;
     
 }
 
-/* gpio_poll_thread_start - start thread */
-int gpio_poll_thread_start(char *dev_name, int offset, uint32_t event_flags,time_t wait_time, void (* p_callback)(void *user_param, void *user_data), void *p_param, void *p_user_data){
+/* gpio_poll_reset_context - clear the event context, scheduling attributes and wake-up stats are kept */
+static void gpio_poll_reset_context(gpio_event_s *event){
+    
+    gpio_thread_attr_s attr = event->attr;
+    gpio_wake_stats_s wake = event->wake;
+    int event_clock = event->event_clock;
+    
+    memset(event, 0, sizeof(*event));
+    
+    event->attr = attr;
+    event->wake = wake;
+    event->event_clock = event_clock;
+}
+
+/* gpio_thread_attr_apply - policy / priority and CPU affinity of a running thread (e.g. worker threads next to the poll thread) */
+int gpio_thread_attr_apply(pthread_t thread, const gpio_thread_attr_s *attr){
+    
+    int ret = 0;
+    
+    if(attr->policy == SCHED_FIFO || attr->policy == SCHED_RR){
+       struct sched_param sp = {.sched_priority = attr->priority};
+       if(pthread_setschedparam(thread, attr->policy, &sp) != 0) ret = -1;
+    }
+    
+    if(attr->cpu_mask != 0){
+       cpu_set_t set;
+       CPU_ZERO(&set);
+       for(int cpu = 0; cpu < 32; cpu++){
+           if(attr->cpu_mask & (1u << cpu)) CPU_SET(cpu, &set);
+       }
+       if(pthread_setaffinity_np(thread, sizeof(set), &set) != 0) ret = -1;
+    }
+    
+    return ret;
+}
+
+/* gpio_poll_thread_create - poll thread with event->attr: real-time policy, CPU affinity, pre-faulted locked stack
+ * Real-time class not permitted (no CAP_SYS_NICE / RLIMIT_RTPRIO) --> thread runs with the inherited policy, rt_applied = 0 */
+static int gpio_poll_thread_create(gpio_event_s *event){
+    
+    const gpio_thread_attr_s *a = &event->attr;
+    int rt = (a->policy == SCHED_FIFO || a->policy == SCHED_RR);
+    pthread_attr_t attr;
+    
+    pthread_attr_init(&attr);
+    
+    if(rt){
+       struct sched_param sp = {.sched_priority = a->priority};
+       pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+       pthread_attr_setschedpolicy(&attr, a->policy);
+       pthread_attr_setschedparam(&attr, &sp);
+    }
+    
+    if(a->cpu_mask != 0){
+       cpu_set_t set;
+       CPU_ZERO(&set);
+       for(int cpu = 0; cpu < 32; cpu++){
+           if(a->cpu_mask & (1u << cpu)) CPU_SET(cpu, &set);
+       }
+       pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+    }
+    
+    // Own stack - every page touched and locked, the IRQ path never takes a page fault ...
+    if(a->stack_size != 0){
+       long page = sysconf(_SC_PAGESIZE);
+       size_t len = (a->stack_size < (size_t)PTHREAD_STACK_MIN) ? (size_t)PTHREAD_STACK_MIN : a->stack_size;
+       len = (len + page - 1) & ~(size_t)(page - 1);
+       
+       void *stack = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+       if(stack != MAP_FAILED){
+          memset(stack, 0, len);
+          if(mlock(stack, len) != 0){
+#ifdef GPIODEV_DEBUG
+             printf("Poll thread stack can not be locked: %s\n", strerror(errno));
+#endif
+          }
+          pthread_attr_setstack(&attr, stack, len);
+          event->stack = stack;
+          event->stack_len = len;
+       }
+    }
+    
+    int ret = pthread_create(&event->event_thread, &attr, gpio_poll_wait_thread, (void*)event);
+    event->rt_applied = (ret == 0 && rt);
+    
+    if(ret == EPERM && rt){
+#ifdef GPIODEV_DEBUG
+       printf("Real-time policy not permitted - poll thread runs with the inherited policy\n");
+#endif
+       pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+       ret = pthread_create(&event->event_thread, &attr, gpio_poll_wait_thread, (void*)event);
+    }
+    
+    pthread_attr_destroy(&attr);
+    
+    if(ret != 0 && event->stack != NULL){
+       munmap(event->stack, event->stack_len);
+       event->stack = NULL;
+    }
+    
+    return ret;
+}
+
+/* gpio_poll_set_thread_attr - scheduling of the poll thread, used by the next gpio_poll_thread_start* */
+void gpio_poll_set_thread_attr(gpio_event_s *event, const gpio_thread_attr_s *attr){
+    
+    event->attr = *attr;
+}
+
+/* gpio_poll_get_wake_stats - wake-up latency snapshot */
+void gpio_poll_get_wake_stats(gpio_event_s *event, gpio_wake_stats_s *stats){
+    
+    uint64_t *src = (uint64_t *)&event->wake, *dst = (uint64_t *)stats;
+    
+    for(size_t i = 0; i < sizeof(gpio_wake_stats_s) / sizeof(uint64_t); i++){
+        dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+    }
+}
+
+/* gpio_poll_reset_wake_stats */
+void gpio_poll_reset_wake_stats(gpio_event_s *event){
+    
+    uint64_t *st = (uint64_t *)&event->wake;
+    
+    for(size_t i = 0; i < sizeof(gpio_wake_stats_s) / sizeof(uint64_t); i++){
+        __atomic_store_n(&st[i], 0, __ATOMIC_RELAXED);
+    }
+}
+
+/* gpio_poll_thread_run - start thread on prepared context (dev_name + offset or line_fd) */
+static int gpio_poll_thread_run(gpio_event_s *event, uint32_t event_flags,time_t wait_time, void (* p_callback)(void *user_param, void *user_data), void *p_param, void *p_user_data){
     
     // Pthread tutorial: https://www.cs.cmu.edu/afs/cs/academic/class/15492-f07/www/pthreads.html
     
     int  iret = -1, res = -1;
     
-    res = pipe(pipes);
+    res = pipe(event->pipes);
    
     if(res < 0){
        perror("pipe");
        return iret;
     }
-        
-    memset(&event_struct, 0, sizeof(event_struct));
     
-    event_struct.dev_name = dev_name;
-    event_struct.offset = offset;
-    event_struct.event_flags = event_flags;
-    event_struct.wait_time = wait_time;
-    event_struct.gpio_event_isr_callback = p_callback;
-    event_struct.gpio_event_isr_param = p_param;
-    event_struct.gpio_event_isr_user_data = p_user_data;
+    event->event_flags = event_flags;
+    event->wait_time = wait_time;
+    event->gpio_event_isr_callback = p_callback;
+    event->gpio_event_isr_param = p_param;
+    event->gpio_event_isr_user_data = p_user_data;
     
-    iret = pthread_create(&event_thread, NULL, gpio_poll_wait_thread, (void*)&event_struct);
+    iret = gpio_poll_thread_create(event);
    
     if(!iret){
 #ifdef GPIODEV_DEBUG         
         printf("Starting thread ...\n");
 #endif        
-        event_struct.thread_status = 1; // Thread is running ...
+        event->thread_status = 1; // Thread is running ...
     }else{
 #ifdef GPIODEV_DEBUG          
         printf("Thread can not be started ...\n");
 #endif
+        close(event->pipes[0]);
+        close(event->pipes[1]);
     }
     
     return iret;
     
 }
 
+/* gpio_poll_thread_start - start thread (event context is owned by the caller) */
+int gpio_poll_thread_start(gpio_event_s *event, const char *dev_name, int offset, uint32_t event_flags,time_t wait_time, void (* p_callback)(void *user_param, void *user_data), void *p_param, void *p_user_data){
+    
+    gpio_poll_reset_context(event);
+    
+    event->dev_name = dev_name;
+    event->offset = offset;
+    event->line_fd = -1;
+    event->abi = GPIO_ABI_V1;
+    event->line_index = -1;
+    
+    return gpio_poll_thread_run(event, event_flags, wait_time, p_callback, p_param, p_user_data);
+}
+
+/* gpio_poll_thread_start_fd - start thread on already opened line fd, never closed by the thread
+ * abi - GPIO_ABI_V1 (struct gpioevent_data) / GPIO_ABI_V2 (struct gpio_v2_line_event, e.g. gpio_v2_request_lines fd)
+ * line_index - index of the watched line in a v2 request for the level re-check (-1 - no level read, e.g. pipe) */
+int gpio_poll_thread_start_fd(gpio_event_s *event, int line_fd, int abi, int line_index, uint32_t event_flags,time_t wait_time, void (* p_callback)(void *user_param, void *user_data), void *p_param, void *p_user_data){
+    
+    gpio_poll_reset_context(event);
+    
+    event->dev_name = "line_fd";
+    event->offset = -1;
+    event->line_fd = line_fd;
+    event->abi = abi;
+    event->line_index = line_index;
+    
+    return gpio_poll_thread_run(event, event_flags, wait_time, p_callback, p_param, p_user_data);
+}
+
+/* gpio_poll_attach - event context without thread: the owner polls the returned fd (e.g. epoll) and calls gpio_poll_process
+ * line_fd >= 0 - already opened line fd (see gpio_poll_thread_start_fd), otherwise requested from dev_name + offset
+ * The fd is switched to non-blocking. Returns the line fd or -1 */
+int gpio_poll_attach(gpio_event_s *event, const char *dev_name, int offset, int line_fd, int abi, int line_index, uint32_t event_flags, void (* p_callback)(void *user_param, void *user_data), void *p_param, void *p_user_data){
+    
+    gpio_poll_reset_context(event);
+    
+    event->dev_name = (line_fd >= 0) ? "line_fd" : dev_name;
+    event->offset = offset;
+    event->line_fd = line_fd;
+    event->abi = abi;
+    event->line_index = line_index;
+    event->event_flags = event_flags;
+    event->gpio_event_isr_callback = p_callback;
+    event->gpio_event_isr_param = p_param;
+    event->gpio_event_isr_user_data = p_user_data;
+    
+    event->fd = (line_fd >= 0) ? line_fd : gpio_poll_request_line(event);
+    
+    if(event->fd < 0){
+       return -1;
+    }
+    
+    fcntl(event->fd, F_SETFL, fcntl(event->fd, F_GETFL) | O_NONBLOCK);
+    event->attached = 1;
+    
+    return event->fd;
+}
+
+/* gpio_poll_detach - release context of gpio_poll_attach (own line fd is closed) */
+void gpio_poll_detach(gpio_event_s *event){
+    
+    if(!event->attached){
+       return;
+    }
+    
+    if(event->line_fd < 0) close(event->fd);
+    gpio_poll_reset_context(event);
+}
+
 /* gpio_poll_thread_stop - stop thread */
-void gpio_poll_thread_stop(){
+void gpio_poll_thread_stop(gpio_event_s *event){
     
     int i = 1; // Stop running thread flag
     
     // Check thread_status -> 1 is running ...
-    if(event_struct.thread_status){
+    if(event->thread_status){
 #ifdef GPIODEV_DEBUG         
         printf("Stopping thread ...\n");
 #endif                
        // Write pipe ... 
-       write(pipes[1],&i,sizeof(i));  
+       write(event->pipes[1],&i,sizeof(i));  
        // pthread_join() function waits for the thread specified by thread to terminate
-       pthread_join(event_thread, NULL);
-       // Reset event_struct to 0 ...
-       memset(&event_struct, 0, sizeof(event_struct));
+       pthread_join(event->event_thread, NULL);
        // Close pipe
-       close(pipes[0]);
-       close(pipes[1]);
+       close(event->pipes[0]);
+       close(event->pipes[1]);
+       // Own stack - the thread is gone, unlocked and unmapped ...
+       if(event->stack != NULL){
+          munmap(event->stack, event->stack_len);
+       }
+       // Reset event context to 0 ...
+       gpio_poll_reset_context(event);
     }
 }
-
-
@@ -12,12 +12,102 @@
 
 #include <time.h>
 #include <stdint.h>
+#include <pthread.h>
+
+#define GPIO_POLL_EVENT_BATCH       16  // Line events drained per read (kernel kfifo depth)
+#define GPIO_POLL_MAX_REDISPATCH    4   // Callback repeats while the line stays asserted after it
+
+// Line event record formats
+#define GPIO_ABI_V1                 1   // struct gpioevent_data (GPIO_GET_LINEEVENT_IOCTL)
+#define GPIO_ABI_V2                 2   // struct gpio_v2_line_event (GPIO_V2_GET_LINE_IOCTL)
+
+// Event timestamp clocks (uAPI v2)
+#define GPIO_EVENT_CLOCK_MONOTONIC  0
+#define GPIO_EVENT_CLOCK_REALTIME   1
+#define GPIO_EVENT_CLOCK_HTE        2   // Hardware timestamp engine - falls back to MONOTONIC if the line has none
+
+#define GPIO_V2_REQ_MAX_LINES       4
+
+#define GPIO_WAKE_HIST_BINS         16  // log2 [us] bins of the poll thread wake-up latency
+
+// Poll thread scheduling (gpio_poll_set_thread_attr) - applied when the thread is created
+typedef struct gpio_thread_attr_t{
+    int policy;                // SCHED_OTHER (0, default), SCHED_FIFO, SCHED_RR
+    int priority;              // SCHED_FIFO / SCHED_RR priority (1 - 99)
+    uint32_t cpu_mask;         // CPU affinity (bit n - CPU n), 0 --> any CPU
+    size_t stack_size;         // > 0 --> thread stack of this size, pre-faulted and locked (mlock)
+}gpio_thread_attr_s;
+
+// Edge timestamp --> poll thread serving it (wake-up latency)
+typedef struct gpio_wake_stats_t{
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t hist[GPIO_WAKE_HIST_BINS];    // bin 0 - < 1 us, bin n - [2^(n-1), 2^n) us
+}gpio_wake_stats_s;
+
+// uAPI v2 line request - several lines (outputs + one edge detected input) behind one fd
+typedef struct gpio_v2_lines_t{
+    int fd;                                         // Request fd (-1 - not requested)
+    int num_lines;
+    unsigned int offsets[GPIO_V2_REQ_MAX_LINES];    // Line offsets, index = bit in get / set masks
+    int event_clock;                                // GPIO_EVENT_CLOCK_* granted by the kernel
+}gpio_v2_lines_s;
+
+// Poll thread context - one per watched line (no process wide state)
+typedef struct gpio_event_t{
+    const char *dev_name;
+    int offset;
+    int thread_status;
+    uint32_t event_flags;
+    time_t wait_time;
+    void (*gpio_event_isr_callback)(void *user_param, void *user_data);
+    void *gpio_event_isr_param;
+    void *gpio_event_isr_user_data;
+    int pipes[2];              // Stop pipe
+    int line_fd;               // Pre-opened line event fd (struct gpioevent_data records, e.g. software emulator), -1 --> requested from dev_name
+    int abi;                   // GPIO_ABI_V1 / GPIO_ABI_V2 records on the line fd
+    int line_index;            // v2 - index of the watched line in its request (level re-check), -1 --> none
+    uint32_t last_seqno;       // v2 - line sequence number of the last edge
+    uint64_t timestamp;        // Kernel timestamp [ns] of the edge being dispatched (event clock of the request)
+    uint64_t events;           // Edges received
+    uint64_t lost;             // v2 - edges dropped by the kernel (line sequence number gaps)
+    uint64_t missed;           // Callbacks repeated because the line stayed asserted (edge lost while serving)
+    int fd;                    // Line event fd in use (poll thread or gpio_poll_attach)
+    int attached;              // 1 --> no thread, the owner polls fd and calls gpio_poll_process
+    // Kept across start / stop ...
+    gpio_thread_attr_s attr;   // Poll thread scheduling, affinity and stack
+    int event_clock;           // GPIO_EVENT_CLOCK_* of the edge timestamps (wake-up latency, HTE - not recorded)
+    gpio_wake_stats_s wake;    // Wake-up latency of the poll thread
+    int rt_applied;            // 1 --> thread runs with attr.policy (0 - real-time class not permitted, inherited policy)
+    void *stack;               // Locked thread stack (attr.stack_size)
+    size_t stack_len;
+    pthread_t event_thread;
+}gpio_event_s;
 
 void gpio_list(const char *dev_name);
 void gpio_write_single(const char *dev_name, int offset, uint8_t value);
 int gpio_read_single(const char *dev_name, int offset, uint8_t *value);
+int gpio_line_request_output(const char *dev_name, int offset, uint8_t value);
+int gpio_line_set_value(int line_fd, uint8_t value);
+void gpio_line_release(int line_fd);
+int gpio_v2_request_lines(gpio_v2_lines_s *lines, const char *dev_name, const char *consumer,
+                          const int *out_offsets, const uint8_t *out_values, int num_out,
+                          int irq_offset, uint32_t event_flags, int event_clock, uint32_t debounce_us);
+int gpio_v2_line_index(const gpio_v2_lines_s *lines, int offset);
+int gpio_v2_set_value(gpio_v2_lines_s *lines, int offset, uint8_t value);
+int gpio_v2_get_value(gpio_v2_lines_s *lines, int offset);
+void gpio_v2_release(gpio_v2_lines_s *lines);
 int gpio_poll_wait(const char *dev_name, int offset, int timeout, uint32_t event_flags);
-int gpio_poll_thread_start(char *dev_name, int offset, uint32_t event_flags,time_t wait_time, void (* p_callback)(void *user_param, void *user_data), void *p_param, void *p_user_data);
-void gpio_poll_thread_stop();
+int gpio_poll_thread_start(gpio_event_s *event, const char *dev_name, int offset, uint32_t event_flags,time_t wait_time, void (* p_callback)(void *user_param, void *user_data), void *p_param, void *p_user_data);
+int gpio_poll_thread_start_fd(gpio_event_s *event, int line_fd, int abi, int line_index, uint32_t event_flags,time_t wait_time, void (* p_callback)(void *user_param, void *user_data), void *p_param, void *p_user_data);
+void gpio_poll_thread_stop(gpio_event_s *event);
+void gpio_poll_set_thread_attr(gpio_event_s *event, const gpio_thread_attr_s *attr);
+int gpio_thread_attr_apply(pthread_t thread, const gpio_thread_attr_s *attr);
+void gpio_poll_get_wake_stats(gpio_event_s *event, gpio_wake_stats_s *stats);
+void gpio_poll_reset_wake_stats(gpio_event_s *event);
+int gpio_poll_attach(gpio_event_s *event, const char *dev_name, int offset, int line_fd, int abi, int line_index, uint32_t event_flags, void (* p_callback)(void *user_param, void *user_data), void *p_param, void *p_user_data);
+int gpio_poll_process(gpio_event_s *event, int force);
+void gpio_poll_detach(gpio_event_s *event);
 
 #endif
@@ -1,60 +1,397 @@
 #include "io_utils.h"
 #include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
 
-#define GPIO_EXT_IS_TIMEOUT 10000000
+#define GPIO_EXT_IS_TIMEOUT 0    // No settle sleep before the IRQ callback (was 10 ms - a floor on every wake-up)
 
-// Internal structure to store midleware data 
-typedef struct gpio_settings_t{
-    char *gpio_dev_name;
-    char *gpio_dev_name_isr;
-    int gpio_cs_offset;
-    int gpio_irq_offset;
-    int p_call_param;
-}gpio_settings_s;
+// spidev transport - spidev_cs_write - drive emulated chip select (single ioctl if line handle is held)
+static void spidev_cs_write(io_utils_dev_s *io, uint8_t level){
+    
+    if(io->gpio_set.lines.fd >= 0 && gpio_v2_set_value(&io->gpio_set.lines, io->gpio_set.gpio_cs_offset, level) == 0){
+       return;
+    }
+    
+    if(io->gpio_set.gpio_cs_fd >= 0){
+       gpio_line_set_value(io->gpio_set.gpio_cs_fd, level);
+    }else{
+       gpio_write_single(io->gpio_set.gpio_dev_name, io->gpio_set.gpio_cs_offset, level);
+    }
+}
 
-static spi_t spi_int;
+static int spidev_open(io_utils_dev_s *io, const char *device, int mode, int bits, int speed){
+    
+    int ret_val = spi_init(&io->spi,
+                    device, // filename like "/dev/spidev0.0"
+                    mode,   // SPI_* (look "linux/spi/spidev.h")
+                    bits,   // bits per word (usually 8)
+                    speed); // max speed [Hz]
+    
+    io->xfer_max = io->spi.bufsiz;
+    io->xfer_pad = SPI_KMALLOC_MINALIGN;
+    
+    return ret_val;
+}
+
+static void spidev_close(io_utils_dev_s *io){
+    
+    if(io->spi.fd >= 0) spi_free(&io->spi);
+    io->spi.fd = -1;
+}
+
+static void spidev_set_xfer_speed(io_utils_dev_s *io, int reg_speed_hz, int burst_speed_hz){
+    
+    spi_set_xfer_speed(&io->spi, reg_speed_hz, burst_speed_hz);
+}
+
+static int spidev_transfer_reg16(io_utils_dev_s *io, uint16_t addr, uint8_t *rx, const uint8_t *tx, int len){
+    
+    return spi_transfer_reg16(&io->spi, addr, rx, tx, len, 1);   // Address byte swap is enabled ...
+}
 
-static gpio_settings_s gpio_set_int = {0};
+static int spidev_burst_reg16(io_utils_dev_s *io, uint16_t addr, uint8_t *rx, const uint8_t *tx, int len){
+    
+    return spi_burst_reg16(&io->spi, addr, rx, tx, len, 1);
+}
+
+static int spidev_exchange(io_utils_dev_s *io, uint8_t *rx, const uint8_t *tx, int len){
+    
+    return spi_exchange(&io->spi, rx, tx, len);
+}
+
+static int spidev_message(io_utils_dev_s *io, struct spi_ioc_transfer *xfer, int n){
+    
+    return spi_message(&io->spi, xfer, n);
+}
+
+const io_utils_transport_s io_utils_transport_spidev = {
+    .name = "spidev",
+    .open = spidev_open,
+    .close = spidev_close,
+    .set_xfer_speed = spidev_set_xfer_speed,
+    .cs_write = spidev_cs_write,
+    .transfer_reg16 = spidev_transfer_reg16,
+    .burst_reg16 = spidev_burst_reg16,
+    .exchange = spidev_exchange,
+    .message = spidev_message,
+};
+
+// io_utils_cs_write - drive emulated chip select
+static inline void io_utils_cs_write(io_utils_dev_s *io, uint8_t level){
+    
+    io->transport->cs_write(io, level);
+}
+
+// io_utils_dev_init - reset device context (no handles held, GPIO emulated CS), call once before any other io_utils_* call
+void io_utils_dev_init(io_utils_dev_s *io){
+    
+    memset(io, 0, sizeof(*io));
+    
+    io->transport = &io_utils_transport_spidev;
+    io->spi.fd = -1;
+    io->dw.ssi_fd = -1;
+    io->dw.gpio_fd = -1;
+    io->gpio_set.gpio_cs_fd = -1;
+    io->gpio_set.gpio_reset_offset = -1;
+    io->gpio_set.gpio_irq_offset = -1;
+    io->gpio_set.lines.fd = -1;
+    io->gpio_set.lines_isr.fd = -1;
+    io->irq_epfd = -1;
+    io->irq_efd = -1;
+    io->cs_mode = IO_UTILS_CS_GPIO;
+}
+
+// io_utils_set_transport - select SPI transport (IO_UTILS_TRANSPORT_SPIDEV / IO_UTILS_TRANSPORT_DW_UIO), call before io_utils_setup_gpio
+int io_utils_set_transport(io_utils_dev_s *io, int transport){
+    
+    switch(transport){
+        case IO_UTILS_TRANSPORT_SPIDEV: io->transport = &io_utils_transport_spidev; return 0;
+        case IO_UTILS_TRANSPORT_DW_UIO: io->transport = &io_utils_transport_dw_uio; return 0;
+        default: return -1;
+    }
+}
+
+// io_utils_set_transport_ops - custom transport (e.g. software emulator) with its own state, call before io_utils_setup_gpio
+void io_utils_set_transport_ops(io_utils_dev_s *io, const io_utils_transport_s *transport, void *priv){
+    
+    io->transport = transport;
+    io->priv = priv;
+}
+
+// io_utils_set_cs_mode - select chip select mode (IO_UTILS_CS_GPIO / IO_UTILS_CS_NATIVE), call before io_utils_setup_gpio
+void io_utils_set_cs_mode(io_utils_dev_s *io, int cs_mode){
+    
+    io->cs_mode = cs_mode;
+    
+}
+
+// io_utils_set_gpio_event_config - IRQ edge timestamp clock (GPIO_EVENT_CLOCK_*) and kernel debounce, call before io_utils_setup_gpio_lines
+void io_utils_set_gpio_event_config(io_utils_dev_s *io, int event_clock, uint32_t irq_debounce_us){
+    
+    io->gpio_set.event_clock = event_clock;
+    io->gpio_set.irq_debounce_us = irq_debounce_us;
+    
+}
 
 // io_utils_setup_gpio - setup gpio structure and CS for SPI
-void io_utils_setup_gpio(char *gpio_dev_name,char * gpio_dev_name_isr, int gpio_cs_offset){
+void io_utils_setup_gpio(io_utils_dev_s *io, const char *gpio_dev_name, const char *gpio_dev_name_isr, int gpio_cs_offset){
+    
+    io_utils_setup_gpio_lines(io, gpio_dev_name, gpio_dev_name_isr, gpio_cs_offset, -1, -1);
+    
+}
+
+// io_utils_setup_gpio_lines - CS, RESET and IRQ (offset -1 --> not used) as one uAPI v2 request per GPIO chip
+// Lines are held until io_utils_release_gpio, kernels without uAPI v2 get the v1 CS line handle
+void io_utils_setup_gpio_lines(io_utils_dev_s *io, const char *gpio_dev_name, const char *gpio_dev_name_isr, int gpio_cs_offset, int gpio_reset_offset, int gpio_irq_offset){
+    
+    gpio_settings_s *gpio_set = &io->gpio_set;
+    int out_offsets[2];
+    uint8_t out_values[2] = {GPIO_HI_LEVEL, GPIO_HI_LEVEL};    // CS inactive, chip out of reset
+    int num_out = 0;
+    
+    // Release lines if setup is called again ...
+    io_utils_release_gpio(io);
+    
+    int event_clock = gpio_set->event_clock;
+    uint32_t irq_debounce_us = gpio_set->irq_debounce_us;
+    
+    memset(gpio_set, 0, sizeof(*gpio_set));
+    
+    gpio_set->gpio_dev_name = gpio_dev_name;            // Devive gpio name - e.g: /dev/gpiochip2 
+    gpio_set->gpio_cs_offset = gpio_cs_offset;          // CS GPIO offset - standard GPIO port is used to emulate SPI chip select 
+    gpio_set->gpio_reset_offset = gpio_reset_offset;
+    gpio_set->gpio_irq_offset = gpio_irq_offset;
+    gpio_set->event_clock = event_clock;
+    gpio_set->irq_debounce_us = irq_debounce_us;
+    gpio_set->gpio_cs_fd = -1;
+    gpio_set->lines.fd = -1;
+    gpio_set->lines_isr.fd = -1;
+    
+    gpio_set->gpio_dev_name_isr = gpio_dev_name_isr;    // Devive gpio name - e.g: /dev/gpiochip0 
+    
+    // Native CS - SPI controller drives CS, no GPIO line is needed (DW transport drives CS through the mapped GPIO block) ...
+    int use_cs = (io->cs_mode != IO_UTILS_CS_NATIVE && io->transport == &io_utils_transport_spidev);
+    
+    // Lines owned by the transport (software emulator) are not requested ...
+    if(io->transport->gpio_write == NULL){
+       if(use_cs) out_offsets[num_out++] = gpio_cs_offset;
+       if(gpio_reset_offset >= 0) out_offsets[num_out++] = gpio_reset_offset;
+    }
+    if(io->transport->irq_line_fd != NULL){
+       gpio_irq_offset = -1;
+    }
+    
+    int irq_same_chip = (gpio_irq_offset >= 0 && gpio_dev_name_isr != NULL && strcmp(gpio_dev_name, gpio_dev_name_isr) == 0);
+    
+    if(num_out > 0 || irq_same_chip){
+       gpio_v2_request_lines(&gpio_set->lines, gpio_dev_name, "at86rf215", out_offsets, out_values, num_out,
+                             irq_same_chip ? gpio_irq_offset : -1, GPIOEVENT_REQUEST_RISING_EDGE, event_clock, irq_debounce_us);
+    }
+    
+    if(gpio_irq_offset >= 0 && !irq_same_chip && gpio_dev_name_isr != NULL){
+       gpio_v2_request_lines(&gpio_set->lines_isr, gpio_dev_name_isr, "at86rf215_irq", NULL, NULL, 0,
+                             gpio_irq_offset, GPIOEVENT_REQUEST_RISING_EDGE, event_clock, irq_debounce_us);
+    }
+    
+    if(!use_cs || gpio_set->lines.fd >= 0){
+       return;
+    }
+    
+    // uAPI v1 - request CS line once with "HI" level by default - handle is kept until io_utils_release_gpio ...
+    gpio_set->gpio_cs_fd = gpio_line_request_output(gpio_set->gpio_dev_name, gpio_set->gpio_cs_offset, GPIO_HI_LEVEL);
     
-    memset(&gpio_set_int, 0, sizeof(gpio_set_int));
+    // Fallback to per edge request (slow path) if line handle can not be held ...
+    if(gpio_set->gpio_cs_fd < 0){
+       gpio_write_single(gpio_set->gpio_dev_name, gpio_set->gpio_cs_offset, GPIO_HI_LEVEL);
+    }
     
-    gpio_set_int.gpio_dev_name = gpio_dev_name;            // Devive gpio name - e.g: /dev/gpiochip2 
-    gpio_set_int.gpio_cs_offset = gpio_cs_offset;          // CS GPIO offset - standard GPIO port is used to emulate SPI chip select 
+}
+
+// io_utils_release_gpio - release CS / RESET / IRQ line handles
+void io_utils_release_gpio(io_utils_dev_s *io){
     
-    gpio_set_int.gpio_dev_name_isr = gpio_dev_name_isr;    // Devive gpio name - e.g: /dev/gpiochip0 
+    gpio_line_release(io->gpio_set.gpio_cs_fd);
+    io->gpio_set.gpio_cs_fd = -1;
     
-    // Set CS to "HI" level by default ...
-    gpio_write_single(gpio_set_int.gpio_dev_name, gpio_set_int.gpio_cs_offset, GPIO_HI_LEVEL);
+    gpio_v2_release(&io->gpio_set.lines);
+    gpio_v2_release(&io->gpio_set.lines_isr);
     
 }
 
 // io_utils_write_gpio - set GPIO pin as output + level
-void io_utils_write_gpio(int gpio_offset, uint8_t level){
+void io_utils_write_gpio(io_utils_dev_s *io, int gpio_offset, uint8_t level){
+     
+     // Lines owned by the transport (software emulator) ...
+     if(io->transport->gpio_write != NULL){
+        io->transport->gpio_write(io, gpio_offset, level);
+        return;
+     }
         
+     // Line held in the uAPI v2 request - single ioctl ...
+     if(gpio_v2_set_value(&io->gpio_set.lines, gpio_offset, level) == 0){
+        return;
+     }
+        
+     // CS line is held by io_utils - use line handle (re-request would fail with EBUSY) ...
+     if(gpio_offset == io->gpio_set.gpio_cs_offset && io->gpio_set.gpio_cs_fd >= 0){
+        gpio_line_set_value(io->gpio_set.gpio_cs_fd, level);
+        return;
+     }
+     
      // Set selected GPIO as output with given level - GPIO_HI_LEVEL / GPIO_LO_LEVEL
-     gpio_write_single(gpio_set_int.gpio_dev_name, gpio_offset, level);
+     gpio_write_single(io->gpio_set.gpio_dev_name, gpio_offset, level);
+    
+}
+
+// io_utils_irq_source - IRQ line event fd: transport fd or line of a uAPI v2 request (0), v1 line to be requested (1), error (-1)
+static int io_utils_irq_source(io_utils_dev_s *io, int gpio_offset, int *fd, int *abi, int *line_index){
+    
+    io->irq_event.event_clock = GPIO_EVENT_CLOCK_MONOTONIC;
+    
+    // IRQ line provided by the transport - the same poll thread, only the event fd differs ...
+    if(io->transport->irq_line_fd != NULL){
+       *fd = io->transport->irq_line_fd(io, gpio_offset);
+       *abi = GPIO_ABI_V2;
+       *line_index = -1;
+       return (*fd < 0) ? -1 : 0;
+    }
+    
+    // IRQ line already held in a uAPI v2 request (io_utils_setup_gpio_lines) ...
+    gpio_v2_lines_s *lines = (gpio_v2_line_index(&io->gpio_set.lines, gpio_offset) >= 0) ? &io->gpio_set.lines : &io->gpio_set.lines_isr;
+    *line_index = gpio_v2_line_index(lines, gpio_offset);
+    
+    if(*line_index >= 0){
+       *fd = lines->fd;
+       *abi = GPIO_ABI_V2;
+       io->irq_event.event_clock = lines->event_clock;
+       return 0;
+    }
     
+    *fd = -1;
+    *abi = GPIO_ABI_V1;
+    return 1;
 }
 
 // io_utils_setup_interrupt - setup external interrupt and callback function + user data 
-int io_utils_setup_interrupt(int gpio_offset, void (* p_callback)(void *user_param, void *user_data), void *p_user_data){
+int io_utils_setup_interrupt(io_utils_dev_s *io, int gpio_offset, void (* p_callback)(void *user_param, void *user_data), void *p_user_data){
     
     int ret_val = 0;
+    int fd, abi, line_index;
+    
+    io->gpio_set.gpio_irq_offset = gpio_offset;
+    
+    int src = io_utils_irq_source(io, gpio_offset, &fd, &abi, &line_index);
+    
+    if(src < 0){
+       return -1;
+    }
+    
+    if(src == 0){
+       return gpio_poll_thread_start_fd(&io->irq_event, fd, abi, line_index, GPIOEVENT_EVENT_RISING_EDGE , GPIO_EXT_IS_TIMEOUT , p_callback, (void *)&io->gpio_set.p_call_param, p_user_data);
+    }
     
     // Check for external GPIO interrupt events (GPIOEVENT_EVENT_RISING_EDGE - default or GPIOEVENT_EVENT_FALLING_EDGE ) ...
-    ret_val = gpio_poll_thread_start(gpio_set_int.gpio_dev_name_isr, gpio_offset, GPIOEVENT_EVENT_RISING_EDGE , GPIO_EXT_IS_TIMEOUT , p_callback, (void *)&gpio_set_int.p_call_param, p_user_data);
+    ret_val = gpio_poll_thread_start(&io->irq_event, io->gpio_set.gpio_dev_name_isr, gpio_offset, GPIOEVENT_EVENT_RISING_EDGE , GPIO_EXT_IS_TIMEOUT , p_callback, (void *)&io->gpio_set.p_call_param, p_user_data);
     
     return ret_val;
 }
 
+// io_utils_setup_interrupt_fd - external interrupt without poll thread, returns one pollable fd (epoll set of the line event fd + wake-up eventfd)
+// The owner polls it (e.g. in its epoll reactor) and calls io_utils_process_interrupt when readable - the callback runs on the owner's thread
+int io_utils_setup_interrupt_fd(io_utils_dev_s *io, int gpio_offset, void (* p_callback)(void *user_param, void *user_data), void *p_user_data){
+    
+    struct epoll_event ev = {.events = EPOLLIN};
+    int fd, abi, line_index;
+    
+    io->gpio_set.gpio_irq_offset = gpio_offset;
+    
+    int src = io_utils_irq_source(io, gpio_offset, &fd, &abi, &line_index);
+    
+    if(src < 0){
+       return -1;
+    }
+    
+    fd = gpio_poll_attach(&io->irq_event, io->gpio_set.gpio_dev_name_isr, gpio_offset, fd, abi, line_index, GPIOEVENT_EVENT_RISING_EDGE,
+                          p_callback, (void *)&io->gpio_set.p_call_param, p_user_data);
+    
+    if(fd < 0){
+       return -1;
+    }
+    
+    io->irq_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    io->irq_epfd = epoll_create1(EPOLL_CLOEXEC);
+    
+    ev.data.fd = fd;
+    if(io->irq_efd < 0 || io->irq_epfd < 0 || epoll_ctl(io->irq_epfd, EPOLL_CTL_ADD, fd, &ev) != 0){
+       io_utils_disable_interrupt(io);
+       return -1;
+    }
+    
+    ev.data.fd = io->irq_efd;
+    if(epoll_ctl(io->irq_epfd, EPOLL_CTL_ADD, io->irq_efd, &ev) != 0){
+       io_utils_disable_interrupt(io);
+       return -1;
+    }
+    
+    return io->irq_epfd;
+}
+
+// io_utils_process_interrupt - drain the pollable IRQ fd and run the callback inline, returns number of callbacks
+int io_utils_process_interrupt(io_utils_dev_s *io){
+    
+    uint64_t cnt = 0;
+    
+    if(io->irq_epfd < 0){
+       return -1;
+    }
+    
+    // Software wake-up - serve the chip even without a queued edge ...
+    int kicked = (read(io->irq_efd, &cnt, sizeof(cnt)) == sizeof(cnt));
+    
+    return gpio_poll_process(&io->irq_event, kicked);
+}
+
+// io_utils_kick_interrupt - make the pollable IRQ fd readable (next io_utils_process_interrupt runs the callback)
+void io_utils_kick_interrupt(io_utils_dev_s *io){
+    
+    uint64_t cnt = 1;
+    
+    if(io->irq_efd >= 0 && write(io->irq_efd, &cnt, sizeof(cnt)) < 0){
+       // Counter saturated - the fd is readable anyway ...
+    }
+}
+
+// io_utils_set_irq_thread_attr - policy / priority, CPU affinity and locked stack of the IRQ poll thread (before io_utils_setup_interrupt)
+void io_utils_set_irq_thread_attr(io_utils_dev_s *io, const gpio_thread_attr_s *attr){
+    
+    gpio_poll_set_thread_attr(&io->irq_event, attr);
+    
+}
+
+// io_utils_lock_memory - lock all current and future pages of the process (no page faults on the IRQ path)
+int io_utils_lock_memory(void){
+    
+    return mlockall(MCL_CURRENT | MCL_FUTURE);
+    
+}
+
 // io_utils_disable_interrupt - disable external interrupt 
-void io_utils_disable_interrupt(){
+void io_utils_disable_interrupt(io_utils_dev_s *io){
+    
+    // Pollable fd mode - no thread, only the fds ...
+    if(io->irq_event.attached){
+       if(io->irq_epfd >= 0) close(io->irq_epfd);
+       if(io->irq_efd >= 0) close(io->irq_efd);
+       io->irq_epfd = -1;
+       io->irq_efd = -1;
+       gpio_poll_detach(&io->irq_event);
+       return;
+    }
     
     // Disable polling interrupts 
-    gpio_poll_thread_stop();
+    gpio_poll_thread_stop(&io->irq_event);
     
 }
 
@@ -67,94 +404,314 @@ void io_utils_usleep(int usec){
 }
 
 // io_utils_spi_init - init spi bus
-int io_utils_spi_init(spi_t **spi, const char *device, int mode, int bits, int speed){
+int io_utils_spi_init(io_utils_dev_s *io, const char *device, int mode, int bits, int speed){
     
     int ret_val = 0;
     
-    if(gpio_set_int.gpio_dev_name == NULL) return -1;
-    
-    // Init spi device ...
-    ret_val = spi_init(&spi_int,
-                    device, // filename like "/dev/spidev0.0"
-                    mode,   // SPI_* (look "linux/spi/spidev.h")
-                    bits,   // bits per word (usually 8)
-                    speed); // max speed [Hz]
+    if(io->gpio_set.gpio_dev_name == NULL) return -1;
     
-    if(ret_val != 0){
-       *spi = 0;  
-    }else{
-       *spi = &spi_int;    
-    }
+    // Init spi device (spidev: "/dev/spidev0.0", DW: SSI UIO node "/dev/uio0") ...
+    ret_val = io->transport->open(io, device, mode, bits, speed);
     
     return ret_val;
 
 }
 
 // io_utils_spi_close - close spi bus
-void io_utils_spi_close(spi_t *spi){
+void io_utils_spi_close(io_utils_dev_s *io){
     
     // Deinit spi device
-    spi_free(spi); spi = 0;
+    io->transport->close(io);
+}
+
+// io_utils_spi_set_xfer_speed - register accesses / batches at reg_speed_hz, bursts at burst_speed_hz (0 - spi_init speed)
+void io_utils_spi_set_xfer_speed(io_utils_dev_s *io, int reg_speed_hz, int burst_speed_hz){
+    
+    io->transport->set_xfer_speed(io, reg_speed_hz, burst_speed_hz);
 }
 
 // io_utils_spi_read_buffer - spi read buffer
-int io_utils_spi_read_buffer(spi_t *spi, uint16_t addr, uint8_t *buffer, uint8_t size){
+int io_utils_spi_read_buffer(io_utils_dev_s *io, uint16_t addr, uint8_t *buffer, uint8_t size){
     
     int ret_val = 0;
     
-    gpio_write_single(gpio_set_int.gpio_dev_name, gpio_set_int.gpio_cs_offset, GPIO_LO_LEVEL);
+    // Native CS - address + data in one SPI_IOC_MESSAGE ...
+    if(io->cs_mode == IO_UTILS_CS_NATIVE){
+       return io->transport->transfer_reg16(io, addr, buffer, NULL, size);
+    }
+    
+    io_utils_cs_write(io, GPIO_LO_LEVEL);
     
     // Read SPI register wrapper ...
-    ret_val = spi_read_reg16(spi, addr, buffer, size, 1);   // Address byte swap is enabled ...
+    ret_val = io->transport->transfer_reg16(io, addr, buffer, NULL, size);
     
-    gpio_write_single(gpio_set_int.gpio_dev_name, gpio_set_int.gpio_cs_offset, GPIO_HI_LEVEL);
+    io_utils_cs_write(io, GPIO_HI_LEVEL);
 
     return ret_val;
 }
 
 // io_utils_spi_write_buffer - spi write buffer
-int io_utils_spi_write_buffer(spi_t *spi, uint16_t addr, uint8_t *buffer, uint8_t size){
+int io_utils_spi_write_buffer(io_utils_dev_s *io, uint16_t addr, uint8_t *buffer, uint8_t size){
     
     int ret_val = 0;
     
-    gpio_write_single(gpio_set_int.gpio_dev_name, gpio_set_int.gpio_cs_offset, GPIO_LO_LEVEL);
+    // Native CS - address + data in one SPI_IOC_MESSAGE ...
+    if(io->cs_mode == IO_UTILS_CS_NATIVE){
+       return io->transport->transfer_reg16(io, addr, NULL, buffer, size);
+    }
+    
+    io_utils_cs_write(io, GPIO_LO_LEVEL);
     
-    // Read SPI register wrapper ...  
-    ret_val = spi_write_reg16(spi, addr, buffer, size, 1);  // Address byte swap is enabled ...
+    // Write SPI register wrapper ...  
+    ret_val = io->transport->transfer_reg16(io, addr, NULL, buffer, size);
     
-    gpio_write_single(gpio_set_int.gpio_dev_name, gpio_set_int.gpio_cs_offset, GPIO_HI_LEVEL);
+    io_utils_cs_write(io, GPIO_HI_LEVEL);
     
     return ret_val;
 
 }
 
 // io_utils_spi_read_byte - spi read byte
-int io_utils_spi_read_byte(spi_t *spi, uint16_t addr, uint8_t *byte){
+int io_utils_spi_read_byte(io_utils_dev_s *io, uint16_t addr, uint8_t *byte){
+    
+    return io_utils_spi_read_buffer(io, addr, byte, 1);
+}
+
+// io_utils_spi_write_byte - spi write byte
+int io_utils_spi_write_byte(io_utils_dev_s *io, uint16_t addr, uint8_t byte){
+    
+    return io_utils_spi_write_buffer(io, addr, &byte, 1);
+}
+
+// io_utils_msg_room - payload bytes of one transport message with 'n' transfers (padding of every transfer subtracted)
+static inline size_t io_utils_msg_room(io_utils_dev_s *io, int n){
+    
+    return (size_t)(io->xfer_max - n * io->xfer_pad);
+}
+
+// io_utils_spi_burst - zero-copy burst of any length, split at the transport limit (spidev bufsiz)
+static int io_utils_spi_burst(io_utils_dev_s *io, uint16_t addr, uint8_t *rx, const uint8_t *tx, size_t size){
     
     int ret_val = 0;
+    size_t done = 0;
+    size_t burst_max = io_utils_msg_room(io, 2) - 2;   // address + data transfers
+    size_t exchange_max = io_utils_msg_room(io, 1);    // data transfer
+    
+    if(size == 0) return 0;
+    
+    if(io->cs_mode == IO_UTILS_CS_NATIVE){
+       // Native CS - CS is released after every message, each chunk is re-addressed (address + offset) ...
+       while(done < size && ret_val >= 0){
+           size_t len = size - done;
+           if(len > burst_max) len = burst_max;
+           
+           uint16_t chunk_addr = (addr & 0xC000) | ((addr + done) & 0x3FFF);
+           ret_val = io->transport->burst_reg16(io, chunk_addr, rx ? rx + done : NULL, tx ? tx + done : NULL, len);
+           done += len;
+       }
+    }else{
+       // GPIO CS - CS is held low for the whole burst, chip auto-increments the address ...
+       io_utils_cs_write(io, GPIO_LO_LEVEL);
+       
+       size_t len = size;
+       if(len > burst_max) len = burst_max;
+       
+       ret_val = io->transport->burst_reg16(io, addr, rx, tx, len);
+       done = len;
+       
+       while(done < size && ret_val >= 0){
+           len = size - done;
+           if(len > exchange_max) len = exchange_max;
+           
+           ret_val = io->transport->exchange(io, rx ? rx + done : NULL, tx ? tx + done : NULL, len);
+           done += len;
+       }
+       
+       io_utils_cs_write(io, GPIO_HI_LEVEL);
+    }
     
-    gpio_write_single(gpio_set_int.gpio_dev_name, gpio_set_int.gpio_cs_offset, GPIO_LO_LEVEL);
-    // Read SPI register wrapper ...
+    return (ret_val < 0) ? ret_val : (int)size;
+}
+
+// io_utils_spi_read_burst - spi read burst (data land directly in buffer)
+int io_utils_spi_read_burst(io_utils_dev_s *io, uint16_t addr, uint8_t *buffer, size_t size){
     
-    ret_val = spi_read_reg16(spi, addr, byte, 1, 1);   // Address byte swap is enabled ...
+    return io_utils_spi_burst(io, addr, buffer, NULL, size);
+}
+
+// io_utils_spi_write_burst - spi write burst (data are sent directly from buffer)
+int io_utils_spi_write_burst(io_utils_dev_s *io, uint16_t addr, const uint8_t *buffer, size_t size){
     
-    gpio_write_single(gpio_set_int.gpio_dev_name, gpio_set_int.gpio_cs_offset, GPIO_HI_LEVEL);
+    return io_utils_spi_burst(io, addr, NULL, buffer, size);
+}
+
+// io_utils_spi_batch_begin - start new (empty) batch
+void io_utils_spi_batch_begin(io_utils_spi_batch_s *batch){
     
-    return ret_val;
+    batch->num_ops = 0;
+    batch->num_bytes = 0;
 }
 
-// io_utils_spi_write_byte - spi write byte
-int io_utils_spi_write_byte(spi_t *spi, uint16_t addr, uint8_t byte){
+// io_utils_spi_batch_append - queue one register operation (2 byte address + data) as one transfer
+static int io_utils_spi_batch_append(io_utils_spi_batch_s *batch, uint16_t addr, uint8_t *slot, const uint8_t *buffer, uint8_t size){
     
-    int ret_val = 0;
+    int len = 2 + size;
+    
+    // Batch is full - caller has to commit first ...
+    if(batch->num_ops >= IO_UTILS_SPI_BATCH_MAX_OPS || batch->num_bytes + len > IO_UTILS_SPI_BATCH_MAX_BYTES){
+       return -1;
+    }
     
-    gpio_write_single(gpio_set_int.gpio_dev_name, gpio_set_int.gpio_cs_offset, GPIO_LO_LEVEL);
-    // Read SPI register wrapper ...  
-    ret_val = spi_write_reg16(spi, addr, &byte, 1, 1);  // Address byte swap is enabled ...
+    uint8_t *tx = &batch->tx[batch->num_bytes];
+    struct spi_ioc_transfer *xfer = &batch->xfer[batch->num_ops];
     
-    gpio_write_single(gpio_set_int.gpio_dev_name, gpio_set_int.gpio_cs_offset, GPIO_HI_LEVEL);
+    // Address is sent MSB first ...
+    tx[0] = (addr >> 8) & 0xFF;
+    tx[1] = addr & 0xFF;
     
-    return ret_val;
+    if(buffer != NULL){
+       memcpy(&tx[2], buffer, size);
+    }else{
+       memset(&tx[2], 0, size);
+    }
+    
+    memset(xfer, 0, sizeof(*xfer));
+    xfer->tx_buf = (__u64)(uintptr_t)tx;
+    xfer->rx_buf = (__u64)(uintptr_t)(slot ? &batch->rx[batch->num_bytes] : NULL);
+    xfer->len = (__u32)len;
+    
+    batch->rx_slot[batch->num_ops] = slot;
+    batch->num_ops++;
+    batch->num_bytes += len;
+    
+    return 0;
+}
+
+// io_utils_spi_batch_append_read - queue register read, data lands in caller supplied slot after commit
+int io_utils_spi_batch_append_read(io_utils_spi_batch_s *batch, uint16_t addr, uint8_t *slot, uint8_t size){
+    
+    return io_utils_spi_batch_append(batch, addr, slot, NULL, size);
+}
+
+// io_utils_spi_batch_append_write - queue register write (data are copied into batch)
+int io_utils_spi_batch_append_write(io_utils_spi_batch_s *batch, uint16_t addr, const uint8_t *buffer, uint8_t size){
+    
+    return io_utils_spi_batch_append(batch, addr, NULL, buffer, size);
+}
+
+// io_utils_spi_batch_run - number of operations from 'first' on which continue each other's address range
+// (same direction - the R/W flag is part of the address, all with an rx buffer or none), limited to one transport transfer
+static int io_utils_spi_batch_run(io_utils_spi_batch_s *batch, int first, int max_len){
+    
+    const uint8_t *tx = (const uint8_t *)(uintptr_t)batch->xfer[first].tx_buf;
+    uint16_t next = (uint16_t)(((tx[0] << 8) | tx[1]) + batch->xfer[first].len - 2);
+    int len = batch->xfer[first].len;
+    int n = 1;
+    
+    while(first + n < batch->num_ops){
+       struct spi_ioc_transfer *xfer = &batch->xfer[first + n];
+       tx = (const uint8_t *)(uintptr_t)xfer->tx_buf;
+       
+       if((uint16_t)((tx[0] << 8) | tx[1]) != next || len + (int)xfer->len - 2 > max_len) break;
+       
+       // One rx buffer decision per merged transfer - operations with and without a read slot are not mixed ...
+       if((xfer->rx_buf != 0) != (batch->xfer[first].rx_buf != 0)) break;
+       
+       next = (uint16_t)(next + xfer->len - 2);
+       len += xfer->len - 2;
+       n++;
+    }
+    
+    return n;
+}
 
+// io_utils_spi_batch_merged - send 'n' contiguous operations as one CS-held transfer (chip auto-increments the address),
+// read data are scattered back to the per-operation rx staging so the slot copy does not change
+static int io_utils_spi_batch_merged(io_utils_dev_s *io, io_utils_spi_batch_s *batch, int first, int n){
+    
+    uint8_t tx[IO_UTILS_SPI_BATCH_MAX_BYTES];
+    uint8_t rx[IO_UTILS_SPI_BATCH_MAX_BYTES];
+    struct spi_ioc_transfer xfer = batch->xfer[first];
+    int len = 2, ofs = 2, ret_val = 0;
+    
+    // First address header + data of all operations ...
+    memcpy(tx, (const uint8_t *)(uintptr_t)batch->xfer[first].tx_buf, 2);
+    for(int i=first;i<first + n;i++){
+        memcpy(&tx[len], (const uint8_t *)(uintptr_t)batch->xfer[i].tx_buf + 2, batch->xfer[i].len - 2);
+        len += batch->xfer[i].len - 2;
+    }
+    
+    xfer.tx_buf = (__u64)(uintptr_t)tx;
+    xfer.rx_buf = (__u64)(uintptr_t)(batch->xfer[first].rx_buf ? rx : NULL);
+    xfer.len = (__u32)len;
+    xfer.cs_change = 0;
+    
+    io_utils_cs_write(io, GPIO_LO_LEVEL);
+    ret_val = io->transport->message(io, &xfer, 1);
+    io_utils_cs_write(io, GPIO_HI_LEVEL);
+    
+    if(ret_val >= 0 && xfer.rx_buf){
+       for(int i=first;i<first + n;i++){
+           memcpy((uint8_t *)(uintptr_t)batch->xfer[i].rx_buf + 2, &rx[ofs], batch->xfer[i].len - 2);
+           ofs += batch->xfer[i].len - 2;
+       }
+    }
+    
+    return ret_val;
 }
 
+// io_utils_spi_batch_commit - send all queued operations and fill read slots
+// (native CS - one message; GPIO CS - one message per run of contiguous operations)
+int io_utils_spi_batch_commit(io_utils_dev_s *io, io_utils_spi_batch_s *batch){
+    
+    int ret_val = 0, n = 1;
+    
+    if(batch->num_ops == 0) return 0;
+    
+    if(io->cs_mode == IO_UTILS_CS_NATIVE){
+       // Native CS - CS is released between transfers (cs_change), one SPI_IOC_MESSAGE(n) for the whole batch,
+       // split only where the padded transfers would exceed the transport limit ...
+       for(int i=0;i<batch->num_ops && ret_val >= 0;i+=n){
+           size_t cost = batch->xfer[i].len + io->xfer_pad;
+           
+           for(n=1;i + n < batch->num_ops;n++){
+               cost += batch->xfer[i + n].len + io->xfer_pad;
+               if(cost > (size_t)io->xfer_max) break;
+           }
+           
+           for(int j=i;j<i + n - 1;j++){
+               batch->xfer[j].cs_change = 1;
+           }
+           batch->xfer[i + n - 1].cs_change = 0;
+           
+           ret_val = io->transport->message(io, &batch->xfer[i], n);
+       }
+    }else{
+       // GPIO CS can not toggle inside of one message - contiguous operations share one CS-held transfer,
+       // the rest is one transfer per operation ...
+       for(int i=0;i<batch->num_ops && ret_val >= 0;i+=n){
+           n = io_utils_spi_batch_run(batch, i, (int)io_utils_msg_room(io, 1));
+           if(n > 1){
+              ret_val = io_utils_spi_batch_merged(io, batch, i, n);
+              continue;
+           }
+           io_utils_cs_write(io, GPIO_LO_LEVEL);
+           ret_val = io->transport->message(io, &batch->xfer[i], 1);
+           io_utils_cs_write(io, GPIO_HI_LEVEL);
+       }
+    }
+    
+    if(ret_val >= 0){
+       // Copy read data (without address bytes) to caller slots ...
+       for(int i=0;i<batch->num_ops;i++){
+           if(batch->rx_slot[i] != NULL){
+              memcpy(batch->rx_slot[i], (uint8_t *)(uintptr_t)batch->xfer[i].rx_buf + 2, batch->xfer[i].len - 2);
+           }
+       }
+       ret_val = batch->num_bytes;
+    }
+    
+    io_utils_spi_batch_begin(batch);
+    
+    return ret_val;
+}
@@ -9,22 +9,116 @@
 
 #include "gpiodev_lib.h"
 #include "spi.h"
+#include "io_utils_dw.h"
 
 #include <stdint.h>
+#include <stddef.h>
 
 #define GPIO_HI_LEVEL 1
 #define GPIO_LO_LEVEL 0
 
-void io_utils_setup_gpio(char *gpio_dev_name,char * gpio_dev_name_isr, int gpio_cs_offset);
-void io_utils_write_gpio(int gpio_offset, uint8_t level);
-int io_utils_setup_interrupt(int gpio_offset, void (* p_callback)(void *user_param, void *user_data), void *p_user_data);
-void io_utils_disable_interrupt();
+// Chip select modes
+#define IO_UTILS_CS_GPIO   0  // CS emulated by GPIO line around each transfer (default)
+#define IO_UTILS_CS_NATIVE 1  // CS driven by SPI controller (cs_change semantics) - one SPI_IOC_MESSAGE per access
+
+// SPI transports
+#define IO_UTILS_TRANSPORT_SPIDEV  0  // /dev/spidevX.Y ioctl + gpiochip CS line (default)
+#define IO_UTILS_TRANSPORT_DW_UIO  1  // DesignWare SSI FIFO + GPIO data register mmap'ed through UIO
+
+// Batched register transactions - committed as one SPI_IOC_MESSAGE(n) with native CS; GPIO CS has to toggle
+// around every access, so only runs of contiguous addresses (same direction) share one transfer - scattered
+// accesses still cost one message each
+#define IO_UTILS_SPI_BATCH_MAX_OPS   32    // max. register operations per batch
+#define IO_UTILS_SPI_BATCH_MAX_BYTES 1024  // max. address + data bytes per batch
+
+typedef struct io_utils_spi_batch_t{
+    int num_ops;                                            // queued operations
+    int num_bytes;                                          // used bytes in tx / rx staging buffers
+    struct spi_ioc_transfer xfer[IO_UTILS_SPI_BATCH_MAX_OPS];
+    uint8_t *rx_slot[IO_UTILS_SPI_BATCH_MAX_OPS];           // caller supplied read slots (NULL for writes)
+    uint8_t tx[IO_UTILS_SPI_BATCH_MAX_BYTES];
+    uint8_t rx[IO_UTILS_SPI_BATCH_MAX_BYTES];
+}io_utils_spi_batch_s;
+
+// GPIO settings of one device
+typedef struct gpio_settings_t{
+    const char *gpio_dev_name;
+    const char *gpio_dev_name_isr;
+    int gpio_cs_offset;
+    int gpio_irq_offset;
+    int gpio_cs_fd;            // CS line handle (uAPI v1 fallback) - requested once, kept for the device lifetime
+    int gpio_reset_offset;     // -1 --> not requested up front
+    gpio_v2_lines_s lines;     // uAPI v2 request on gpio_dev_name - CS, RESET (+ IRQ on the same chip)
+    gpio_v2_lines_s lines_isr; // uAPI v2 request on gpio_dev_name_isr - IRQ on another chip
+    int event_clock;           // GPIO_EVENT_CLOCK_* of IRQ edge timestamps (io_utils_set_gpio_event_config)
+    uint32_t irq_debounce_us;  // Kernel debounce of the IRQ line, 0 --> off
+    int p_call_param;
+}gpio_settings_s;
+
+struct io_utils_dev_t;
+
+// SPI transport - the byte moving layer below io_utils (CS framing, bursts and batches stay in io_utils)
+typedef struct io_utils_transport_t{
+    const char *name;
+    int  (*open)(struct io_utils_dev_t *io, const char *device, int mode, int bits, int speed);
+    void (*close)(struct io_utils_dev_t *io);
+    void (*set_xfer_speed)(struct io_utils_dev_t *io, int reg_speed_hz, int burst_speed_hz);
+    void (*cs_write)(struct io_utils_dev_t *io, uint8_t level);                                                 // emulated CS
+    int  (*transfer_reg16)(struct io_utils_dev_t *io, uint16_t addr, uint8_t *rx, const uint8_t *tx, int len);  // address + data (<= 256), register speed
+    int  (*burst_reg16)(struct io_utils_dev_t *io, uint16_t addr, uint8_t *rx, const uint8_t *tx, int len);     // address + data (<= xfer_max - 2 * xfer_pad - 2), burst speed
+    int  (*exchange)(struct io_utils_dev_t *io, uint8_t *rx, const uint8_t *tx, int len);                       // data only (<= xfer_max - xfer_pad), burst speed
+    int  (*message)(struct io_utils_dev_t *io, struct spi_ioc_transfer *xfer, int n);                           // prepared transfers
+    void (*gpio_write)(struct io_utils_dev_t *io, int offset, uint8_t level);                                   // optional - lines owned by the transport (NULL --> gpiochip)
+    int  (*irq_line_fd)(struct io_utils_dev_t *io, int offset);                                                 // optional - IRQ edge fd, struct gpio_v2_line_event records (NULL --> gpiochip)
+}io_utils_transport_s;
+
+extern const io_utils_transport_s io_utils_transport_spidev;
+extern const io_utils_transport_s io_utils_transport_dw_uio;
+
+// Per device middleware context - SPI handle, GPIO lines, CS mode and IRQ poll thread
+typedef struct io_utils_dev_t{
+    const io_utils_transport_s *transport;
+    int xfer_max;              // max. bytes of one transport message (spidev bufsiz)
+    int xfer_pad;              // worst case padding of every transfer inside of a message (spidev kmalloc alignment)
+    spi_t spi;                 // IO_UTILS_TRANSPORT_SPIDEV
+    io_utils_dw_s dw;          // IO_UTILS_TRANSPORT_DW_UIO
+    gpio_settings_s gpio_set;
+    int cs_mode;               // IO_UTILS_CS_GPIO / IO_UTILS_CS_NATIVE (spidev only)
+    gpio_event_s irq_event;    // External interrupt poll thread (or attached line, io_utils_setup_interrupt_fd)
+    int irq_epfd;              // Pollable IRQ fd - line event fd + irq_efd (-1 --> poll thread mode)
+    int irq_efd;               // Software wake-up of irq_epfd (io_utils_kick_interrupt)
+    void *priv;                // Custom transport state (io_utils_set_transport_ops)
+}io_utils_dev_s;
+
+void io_utils_dev_init(io_utils_dev_s *io);
+int io_utils_set_transport(io_utils_dev_s *io, int transport);
+void io_utils_set_transport_ops(io_utils_dev_s *io, const io_utils_transport_s *transport, void *priv);
+void io_utils_set_cs_mode(io_utils_dev_s *io, int cs_mode);
+void io_utils_setup_gpio(io_utils_dev_s *io, const char *gpio_dev_name, const char *gpio_dev_name_isr, int gpio_cs_offset);
+void io_utils_setup_gpio_lines(io_utils_dev_s *io, const char *gpio_dev_name, const char *gpio_dev_name_isr, int gpio_cs_offset, int gpio_reset_offset, int gpio_irq_offset);
+void io_utils_set_gpio_event_config(io_utils_dev_s *io, int event_clock, uint32_t irq_debounce_us);
+void io_utils_release_gpio(io_utils_dev_s *io);
+void io_utils_write_gpio(io_utils_dev_s *io, int gpio_offset, uint8_t level);
+int io_utils_setup_interrupt(io_utils_dev_s *io, int gpio_offset, void (* p_callback)(void *user_param, void *user_data), void *p_user_data);
+int io_utils_setup_interrupt_fd(io_utils_dev_s *io, int gpio_offset, void (* p_callback)(void *user_param, void *user_data), void *p_user_data);
+int io_utils_process_interrupt(io_utils_dev_s *io);
+void io_utils_kick_interrupt(io_utils_dev_s *io);
+void io_utils_set_irq_thread_attr(io_utils_dev_s *io, const gpio_thread_attr_s *attr);
+int io_utils_lock_memory(void);
+void io_utils_disable_interrupt(io_utils_dev_s *io);
 void io_utils_usleep(int usec);
-int io_utils_spi_init(spi_t **spi, const char *device, int mode, int bits, int speed);
-void io_utils_spi_close(spi_t *spi);
-int io_utils_spi_read_buffer(spi_t *spi, uint16_t addr, uint8_t *buffer, uint8_t size);
-int io_utils_spi_write_buffer(spi_t *spi, uint16_t addr, uint8_t *buffer, uint8_t size);
-int io_utils_spi_read_byte(spi_t *spi, uint16_t addr, uint8_t *byte);
-int io_utils_spi_write_byte(spi_t *spi, uint16_t addr, uint8_t byte);
+int io_utils_spi_init(io_utils_dev_s *io, const char *device, int mode, int bits, int speed);
+void io_utils_spi_close(io_utils_dev_s *io);
+void io_utils_spi_set_xfer_speed(io_utils_dev_s *io, int reg_speed_hz, int burst_speed_hz);
+int io_utils_spi_read_buffer(io_utils_dev_s *io, uint16_t addr, uint8_t *buffer, uint8_t size);
+int io_utils_spi_write_buffer(io_utils_dev_s *io, uint16_t addr, uint8_t *buffer, uint8_t size);
+int io_utils_spi_read_byte(io_utils_dev_s *io, uint16_t addr, uint8_t *byte);
+int io_utils_spi_write_byte(io_utils_dev_s *io, uint16_t addr, uint8_t byte);
+int io_utils_spi_read_burst(io_utils_dev_s *io, uint16_t addr, uint8_t *buffer, size_t size);
+int io_utils_spi_write_burst(io_utils_dev_s *io, uint16_t addr, const uint8_t *buffer, size_t size);
+void io_utils_spi_batch_begin(io_utils_spi_batch_s *batch);
+int io_utils_spi_batch_append_read(io_utils_spi_batch_s *batch, uint16_t addr, uint8_t *slot, uint8_t size);
+int io_utils_spi_batch_append_write(io_utils_spi_batch_s *batch, uint16_t addr, const uint8_t *buffer, uint8_t size);
+int io_utils_spi_batch_commit(io_utils_dev_s *io, io_utils_spi_batch_s *batch);
 
 #endif
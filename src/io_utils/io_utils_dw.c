@@ -0,0 +1,307 @@
+/**
+ * io_utils_dw - DesignWare APB SSI + GPIO transport through UIO mmap
+ **/
+
+#include "io_utils.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#define DW_XFER_MAX         (1 << 30)   // No message size limit - bursts are never split
+#define DW_POLL_LIMIT       1000000     // FIFO polls without progress before the transfer is abandoned
+#define DW_UIO_MAP_DEFAULT  0x1000
+
+#ifdef IO_UTILS_DW_REG_HOOKS
+#define DW_RD(base, ofs)        io_utils_dw_reg_read((base), (ofs))
+#define DW_WR(base, ofs, val)   io_utils_dw_reg_write((base), (ofs), (val))
+#else
+#define DW_RD(base, ofs)        ((base)[(ofs) >> 2])
+#define DW_WR(base, ofs, val)   ((base)[(ofs) >> 2] = (uint32_t)(val))
+#endif
+
+// dw_uio_attr - read /sys/class/uio/uioN/maps/map0/<name> (hex), 0 if missing
+static size_t dw_uio_attr(const char *uio_dev, const char *name){
+    
+    char path[128];
+    unsigned long val = 0;
+    const char *node = strrchr(uio_dev, '/');
+    
+    snprintf(path, sizeof(path), "/sys/class/uio/%s/maps/map0/%s", node ? node + 1 : uio_dev, name);
+    
+    FILE *f = fopen(path, "r");
+    if(f == NULL) return 0;
+    if(fscanf(f, "%lx", &val) != 1) val = 0;
+    fclose(f);
+    
+    return (size_t)val;
+}
+
+// dw_uio_map - map register block of a UIO device (map0)
+static volatile uint32_t *dw_uio_map(const char *uio_dev, int *fd, void **map, size_t *map_size){
+    
+    size_t size = dw_uio_attr(uio_dev, "size");
+    size_t offset = dw_uio_attr(uio_dev, "offset");   // Block start inside of the first page
+    
+    if(size == 0) size = DW_UIO_MAP_DEFAULT;
+    size += offset;
+    
+    *fd = open(uio_dev, O_RDWR | O_SYNC);
+    if(*fd < 0) return NULL;
+    
+    *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, *fd, 0);
+    if(*map == MAP_FAILED){
+       close(*fd); *fd = -1; *map = NULL;
+       return NULL;
+    }
+    
+    *map_size = size;
+    return (volatile uint32_t *)((uint8_t *)*map + offset);
+}
+
+static void dw_uio_unmap(int *fd, void **map, size_t map_size){
+    
+    if(*map != NULL) munmap(*map, map_size);
+    if(*fd >= 0) close(*fd);
+    *map = NULL;
+    *fd = -1;
+}
+
+// io_utils_dw_baudr - SSI clock divider for requested speed (even, 2 - 65534, never faster than requested)
+uint32_t io_utils_dw_baudr(uint32_t ssi_clk_hz, int speed){
+    
+    uint32_t div = 65534;
+    
+    if(speed > 0){
+       div = (ssi_clk_hz + (uint32_t)speed - 1) / (uint32_t)speed;
+       div = (div + 1) & ~1u;
+    }
+    
+    if(div < 2) div = 2;
+    if(div > 65534) div = 65534;
+    
+    return div;
+}
+
+// dw_set_baudr - divider can only change while SSI is disabled
+static inline void dw_set_baudr(io_utils_dw_s *dw, uint32_t baudr){
+    
+    if(dw->baudr == baudr) return;
+    
+    DW_WR(dw->ssi, DW_SSI_SSIENR, 0);
+    DW_WR(dw->ssi, DW_SSI_BAUDR, baudr);
+    DW_WR(dw->ssi, DW_SSI_SSIENR, 1);
+    dw->baudr = baudr;
+}
+
+// dw_flush - abandon a transfer: disabling SSI clears both FIFOs, divider is re-programmed by the next transfer
+static void dw_flush(io_utils_dw_s *dw){
+    
+    DW_WR(dw->ssi, DW_SSI_SSIENR, 0);
+    DW_WR(dw->ssi, DW_SSI_SSIENR, 1);
+    dw->baudr = 0;
+}
+
+// dw_stream - full-duplex transfer of [hdr + data], TX FIFO is kept filled, RX FIFO drained
+// (never more than fifo_depth bytes in flight - RX FIFO can not overflow)
+static int dw_stream(io_utils_dw_s *dw, uint32_t baudr, const uint8_t *hdr, int hdr_len, uint8_t *rx, const uint8_t *tx, int len){
+    
+    int total = hdr_len + len;
+    int sent = 0, recv = 0, idle = 0;
+    
+    dw_set_baudr(dw, baudr);
+    
+    while(recv < total){
+        int room = dw->fifo_depth - (int)DW_RD(dw->ssi, DW_SSI_TXFLR);
+        int inflight = dw->fifo_depth - (sent - recv);
+        if(room > inflight) room = inflight;
+        
+        for(; room > 0 && sent < total; room--, sent++){
+            uint8_t b = (sent < hdr_len) ? hdr[sent] : (tx ? tx[sent - hdr_len] : 0);
+            DW_WR(dw->ssi, DW_SSI_DR, b);
+        }
+        
+        uint32_t n = DW_RD(dw->ssi, DW_SSI_RXFLR);
+        
+        if(n == 0){
+           if(++idle > DW_POLL_LIMIT){
+              // Stale bytes must not shift into the next transfer ...
+              dw_flush(dw);
+              return SPI_ERR_EXCHANGE;
+           }
+           continue;
+        }
+        idle = 0;
+        
+        for(; n > 0; n--, recv++){
+            uint8_t b = (uint8_t)DW_RD(dw->ssi, DW_SSI_DR);
+            if(rx && recv >= hdr_len) rx[recv - hdr_len] = b;
+        }
+    }
+    
+    return total;
+}
+
+// dw_cs_write - CS line in the mapped GPIO block, ordered after the last SSI access
+static void dw_cs_write(io_utils_dev_s *io, uint8_t level){
+    
+    io_utils_dw_s *dw = &io->dw;
+    
+    if(dw->gpio == NULL) return;
+    
+    __sync_synchronize();
+    uint32_t v = DW_RD(dw->gpio, DW_GPIO_DR);
+    DW_WR(dw->gpio, DW_GPIO_DR, level ? (v | dw->cs_mask) : (v & ~dw->cs_mask));
+    __sync_synchronize();
+}
+
+// io_utils_dw_configure - GPIO block with CS line + SSI input clock (0 - IO_UTILS_DW_SSI_CLK_HZ), call before io_utils_spi_init
+void io_utils_dw_configure(io_utils_dev_s *io, const char *gpio_uio, uint32_t ssi_clk_hz){
+    
+    io->dw.gpio_uio = gpio_uio;
+    io->dw.ssi_clk_hz = ssi_clk_hz;
+}
+
+// io_utils_dw_attach - program already mapped (or fake) register blocks: 8 bit Motorola SPI, TX & RX, polled
+int io_utils_dw_attach(io_utils_dev_s *io, volatile uint32_t *ssi, volatile uint32_t *gpio, int mode, int speed){
+    
+    io_utils_dw_s *dw = &io->dw;
+    uint32_t ctrlr0 = 7;   // DFS - 8 bit frames
+    int fifo = 0;
+    
+    // DW SSI drops its native CS whenever the TX FIFO runs empty - only a GPIO CS frames an access ...
+    if(ssi == NULL || gpio == NULL || io->cs_mode != IO_UTILS_CS_GPIO) return -1;
+    
+    dw->ssi = ssi;
+    dw->gpio = gpio;
+    if(dw->ssi_clk_hz == 0) dw->ssi_clk_hz = IO_UTILS_DW_SSI_CLK_HZ;
+    dw->cs_mask = 1u << io->gpio_set.gpio_cs_offset;
+    
+    if(mode & SPI_CPHA) ctrlr0 |= DW_SSI_CTRLR0_SCPH;
+    if(mode & SPI_CPOL) ctrlr0 |= DW_SSI_CTRLR0_SCPOL;
+    
+    DW_WR(ssi, DW_SSI_SSIENR, 0);
+    DW_WR(ssi, DW_SSI_IMR, 0);
+    DW_WR(ssi, DW_SSI_CTRLR0, ctrlr0);
+    
+    // FIFO depth - first TXFTLR value which does not read back ...
+    for(fifo = 1; fifo < DW_SSI_MAX_FIFO; fifo++){
+        DW_WR(ssi, DW_SSI_TXFTLR, fifo);
+        if(DW_RD(ssi, DW_SSI_TXFTLR) != (uint32_t)fifo) break;
+    }
+    DW_WR(ssi, DW_SSI_TXFTLR, 0);
+    dw->fifo_depth = fifo;
+    
+    dw->baudr_default = io_utils_dw_baudr(dw->ssi_clk_hz, speed);
+    dw->baudr_reg = dw->baudr_default;
+    dw->baudr_burst = dw->baudr_default;
+    dw->baudr = dw->baudr_default;
+    DW_WR(ssi, DW_SSI_BAUDR, dw->baudr);
+    
+    // Slave 0 selected for good - with GPIO CS the native line is not wired ...
+    DW_WR(ssi, DW_SSI_SER, 1);
+    DW_WR(ssi, DW_SSI_SSIENR, 1);
+    
+    // CS as output, inactive (HI) ...
+    DW_WR(gpio, DW_GPIO_DR, DW_RD(gpio, DW_GPIO_DR) | dw->cs_mask);
+    DW_WR(gpio, DW_GPIO_DDR, DW_RD(gpio, DW_GPIO_DDR) | dw->cs_mask);
+    
+    io->xfer_max = DW_XFER_MAX;
+    io->xfer_pad = 0;
+    
+    return 0;
+}
+
+static int dw_open(io_utils_dev_s *io, const char *device, int mode, int bits, int speed){
+    
+    io_utils_dw_s *dw = &io->dw;
+    volatile uint32_t *ssi = NULL, *gpio = NULL;
+    
+    if(bits != 0 && bits != 8) return SPI_ERR_SET_BITS;
+    
+    // Native CS is not usable - SSI releases it between FIFO refills (see io_utils_dw_attach) ...
+    if(io->cs_mode != IO_UTILS_CS_GPIO || dw->gpio_uio == NULL) return SPI_ERR_OPEN;
+    
+    ssi = dw_uio_map(device, &dw->ssi_fd, &dw->ssi_map, &dw->ssi_map_size);
+    if(ssi == NULL) return SPI_ERR_OPEN;
+    
+    gpio = dw_uio_map(dw->gpio_uio, &dw->gpio_fd, &dw->gpio_map, &dw->gpio_map_size);
+    if(gpio == NULL){
+       dw_uio_unmap(&dw->ssi_fd, &dw->ssi_map, dw->ssi_map_size);
+       return SPI_ERR_OPEN;
+    }
+    
+    return io_utils_dw_attach(io, ssi, gpio, mode, speed);
+}
+
+static void dw_close(io_utils_dev_s *io){
+    
+    io_utils_dw_s *dw = &io->dw;
+    
+    if(dw->ssi_map != NULL) DW_WR(dw->ssi, DW_SSI_SSIENR, 0);
+    
+    dw_uio_unmap(&dw->ssi_fd, &dw->ssi_map, dw->ssi_map_size);
+    dw_uio_unmap(&dw->gpio_fd, &dw->gpio_map, dw->gpio_map_size);
+    dw->ssi = NULL;
+    dw->gpio = NULL;
+}
+
+static void dw_set_xfer_speed(io_utils_dev_s *io, int reg_speed_hz, int burst_speed_hz){
+    
+    io_utils_dw_s *dw = &io->dw;
+    
+    dw->baudr_reg = reg_speed_hz > 0 ? io_utils_dw_baudr(dw->ssi_clk_hz, reg_speed_hz) : dw->baudr_default;
+    dw->baudr_burst = burst_speed_hz > 0 ? io_utils_dw_baudr(dw->ssi_clk_hz, burst_speed_hz) : dw->baudr_default;
+}
+
+static int dw_transfer_reg16(io_utils_dev_s *io, uint16_t addr, uint8_t *rx, const uint8_t *tx, int len){
+    
+    uint8_t hdr[2] = { (addr >> 8) & 0xFF, addr & 0xFF };   // Address MSB first
+    
+    return dw_stream(&io->dw, io->dw.baudr_reg, hdr, 2, rx, tx, len);
+}
+
+static int dw_burst_reg16(io_utils_dev_s *io, uint16_t addr, uint8_t *rx, const uint8_t *tx, int len){
+    
+    uint8_t hdr[2] = { (addr >> 8) & 0xFF, addr & 0xFF };
+    
+    return dw_stream(&io->dw, io->dw.baudr_burst, hdr, 2, rx, tx, len);
+}
+
+static int dw_exchange(io_utils_dev_s *io, uint8_t *rx, const uint8_t *tx, int len){
+    
+    return dw_stream(&io->dw, io->dw.baudr_burst, NULL, 0, rx, tx, len);
+}
+
+// dw_message - transfers one after another (framed by the caller's GPIO CS)
+static int dw_message(io_utils_dev_s *io, struct spi_ioc_transfer *xfer, int n){
+    
+    io_utils_dw_s *dw = &io->dw;
+    int total = 0;
+    
+    for(int i=0;i<n;i++){
+        uint32_t baudr = xfer[i].speed_hz ? io_utils_dw_baudr(dw->ssi_clk_hz, xfer[i].speed_hz) : dw->baudr_reg;
+        int ret = dw_stream(dw, baudr, NULL, 0, (uint8_t *)(uintptr_t)xfer[i].rx_buf,
+                            (const uint8_t *)(uintptr_t)xfer[i].tx_buf, (int)xfer[i].len);
+        if(ret < 0) return ret;
+        total += ret;
+    }
+    
+    return total;
+}
+
+const io_utils_transport_s io_utils_transport_dw_uio = {
+    .name = "dw_uio",
+    .open = dw_open,
+    .close = dw_close,
+    .set_xfer_speed = dw_set_xfer_speed,
+    .cs_write = dw_cs_write,
+    .transfer_reg16 = dw_transfer_reg16,
+    .burst_reg16 = dw_burst_reg16,
+    .exchange = dw_exchange,
+    .message = dw_message,
+};
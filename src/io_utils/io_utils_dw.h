@@ -0,0 +1,70 @@
+/**
+ * io_utils_dw - DesignWare APB SSI ("snps,dw-apb-ssi") + GPIO ("snps,dw-apb-gpio")
+ * transport, register blocks mapped through UIO, polled FIFO (no syscalls per access)
+ * h. file
+ **/
+
+#ifndef IO_UTILS_DW_H_
+#define IO_UTILS_DW_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// SSI register offsets
+#define DW_SSI_CTRLR0   0x00
+#define DW_SSI_CTRLR1   0x04
+#define DW_SSI_SSIENR   0x08
+#define DW_SSI_SER      0x10
+#define DW_SSI_BAUDR    0x14
+#define DW_SSI_TXFTLR   0x18
+#define DW_SSI_RXFTLR   0x1C
+#define DW_SSI_TXFLR    0x20
+#define DW_SSI_RXFLR    0x24
+#define DW_SSI_SR       0x28
+#define DW_SSI_IMR      0x2C
+#define DW_SSI_DR       0x60
+
+#define DW_SSI_SR_BUSY          0x01
+#define DW_SSI_CTRLR0_SCPH      (1 << 6)
+#define DW_SSI_CTRLR0_SCPOL     (1 << 7)
+#define DW_SSI_MAX_FIFO         256
+
+// GPIO register offsets (port A)
+#define DW_GPIO_DR      0x00
+#define DW_GPIO_DDR     0x04
+
+#define IO_UTILS_DW_SSI_CLK_HZ  200000000   // SocFPGA spi_m_clk
+
+struct io_utils_dev_t;
+
+// DesignWare transport state (inside of io_utils_dev_s)
+typedef struct io_utils_dw_t{
+    volatile uint32_t *ssi;    // SSI register block
+    volatile uint32_t *gpio;   // GPIO register block with the CS line
+    int ssi_fd;                // UIO handles (-1 - blocks attached by the caller)
+    int gpio_fd;
+    void *ssi_map;
+    void *gpio_map;
+    size_t ssi_map_size;
+    size_t gpio_map_size;
+    const char *gpio_uio;      // UIO node of the GPIO block, e.g. "/dev/uio1"
+    uint32_t ssi_clk_hz;       // SSI input clock
+    uint32_t cs_mask;          // CS bit in GPIO DR
+    int fifo_depth;
+    uint32_t baudr;            // Divider currently programmed
+    uint32_t baudr_default;    // Divider of the open() speed
+    uint32_t baudr_reg;        // Divider of register transfers
+    uint32_t baudr_burst;      // Divider of bursts
+}io_utils_dw_s;
+
+void io_utils_dw_configure(struct io_utils_dev_t *io, const char *gpio_uio, uint32_t ssi_clk_hz);
+int io_utils_dw_attach(struct io_utils_dev_t *io, volatile uint32_t *ssi, volatile uint32_t *gpio, int mode, int speed);
+uint32_t io_utils_dw_baudr(uint32_t ssi_clk_hz, int speed);
+
+#ifdef IO_UTILS_DW_REG_HOOKS
+// Register level test build - every access goes to a memory backed fake of the register blocks
+uint32_t io_utils_dw_reg_read(volatile uint32_t *base, uint32_t ofs);
+void io_utils_dw_reg_write(volatile uint32_t *base, uint32_t ofs, uint32_t val);
+#endif
+
+#endif
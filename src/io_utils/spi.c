@@ -10,6 +10,23 @@
 #include <string.h>    // memset()
 #include <fcntl.h>     // open()
 #include <sys/ioctl.h> // ioctl()
+#include <stdio.h>     // fopen()
+//----------------------------------------------------------------------------
+// read spidev 'bufsiz' module parameter (max. bytes of one message)
+static int spi_get_bufsiz(void)
+{
+  int bufsiz = 0;
+  FILE *fp = fopen(SPI_BUFSIZ_PATH, "r");
+
+  if (fp)
+  {
+    if (fscanf(fp, "%d", &bufsiz) != 1)
+      bufsiz = 0;
+    fclose(fp);
+  }
+
+  return (bufsiz > 2) ? bufsiz : SPI_DEFAULT_BUFSIZ;
+}
 //----------------------------------------------------------------------------
 // open and init SPIdev
 // * spi_mode may have next mask: SPI_LOOP | SPI_CPHA | SPI_CPOL |
@@ -21,6 +38,10 @@ int spi_init(spi_t *self,
              int bits,           // bits per word (usually 8)
              int speed)          // max speed [Hz]
 {
+  // per-transfer speeds follow the max. speed until spi_set_xfer_speed()
+  self->reg_speed = 0;
+  self->burst_speed = 0;
+
   // open SPIdev
   self->fd = open(device, O_RDWR);
   if (self->fd < 0)
@@ -87,7 +108,10 @@ int spi_init(spi_t *self,
     return SPI_ERR_SET_SPEED;
   }
 
-  SPI_DBG("open device='%s' mode=%d bits=%d lsb=%d max_speed=%d [Hz]", device, (int)self->mode, (int)self->bits, (int)self->lsb, (int)self->speed);
+  // get spidev message size limit
+  self->bufsiz = spi_get_bufsiz();
+
+  SPI_DBG("open device='%s' mode=%d bits=%d lsb=%d max_speed=%d [Hz] bufsiz=%d", device, (int)self->mode, (int)self->bits, (int)self->lsb, (int)self->speed, self->bufsiz);
 
   return SPI_ERR_NONE;
 }
@@ -137,6 +161,15 @@ int spi_set_speed(spi_t *self, int speed)
   return SPI_ERR_NONE;
 }
 //----------------------------------------------------------------------------
+// sets per-transfer speeds (spi_ioc_transfer.speed_hz)
+void spi_set_xfer_speed(spi_t *self, int reg_speed, int burst_speed)
+{
+  self->reg_speed = (__u32)(reg_speed > 0 ? reg_speed : 0);
+  self->burst_speed = (__u32)(burst_speed > 0 ? burst_speed : 0);
+
+  SPI_DBG("set transfer speed register=%d [Hz], burst=%d [Hz]", (int)self->reg_speed, (int)self->burst_speed);
+}
+//----------------------------------------------------------------------------
 // close SPIdev file and free memory
 void spi_free(spi_t *self)
 {
@@ -195,6 +228,7 @@ int spi_exchange(spi_t *self, void *rx_buf, const void *tx_buf, int len)
   xfer[0].tx_buf = (__u64)tx_buf; // output buffer
   xfer[0].rx_buf = (__u64)rx_buf; // input buffer
   xfer[0].len = (__u32)len;       // length of data to write
+  xfer[0].speed_hz = self->burst_speed;
 
   retv = ioctl(self->fd, SPI_IOC_MESSAGE(1), xfer);
   if (retv < 0)
@@ -327,3 +361,126 @@ int spi_write_reg16(spi_t *self, uint16_t reg_addr, const void *tx_buf, int len,
 
   return retv;
 }
+//----------------------------------------------------------------------------
+// send prepared transfers as one message - ioctl(SPI_IOC_MESSAGE(n))
+int spi_message(spi_t *self, struct spi_ioc_transfer *xfer, int n)
+{
+  int retv;
+
+  // transfers without own speed run at register speed
+  for (int i = 0; i < n; i++)
+  {
+    if (xfer[i].speed_hz == 0)
+      xfer[i].speed_hz = self->reg_speed;
+  }
+
+  retv = ioctl(self->fd, SPI_IOC_MESSAGE(n), xfer);
+  if (retv < 0)
+  {
+    SPI_DBG("error in spi_message(): ioctl(SPI_IOC_MESSAGE(%d)) return %d", n, retv);
+    return SPI_ERR_EXCHANGE;
+  }
+
+  return retv;
+}
+//----------------------------------------------------------------------------
+// read and/or write data from/to specific register address as one contiguous
+// full-duplex transfer [2 byte address + data] - exactly one ioctl
+int spi_transfer_reg16(spi_t *self, uint16_t reg_addr, void *rx_buf, const void *tx_buf, int len, int swap)
+{
+  int retv;
+  uint8_t tx[2 + SPI_REG16_MAX_LEN];
+  uint8_t rx[2 + SPI_REG16_MAX_LEN];
+
+  struct spi_ioc_transfer xfer[1] = {0};
+
+  if (len < 0 || len > SPI_REG16_MAX_LEN)
+  {
+    SPI_DBG("error in spi_transfer_reg16(): invalid length %d", len);
+    return SPI_ERR_EXCHANGE;
+  }
+
+  // address is always sent MSB first on the wire
+  if (swap)
+  {
+    tx[0] = (reg_addr >> 8) & 0xFF;
+    tx[1] = reg_addr & 0xFF;
+  }
+  else
+  {
+    tx[0] = reg_addr & 0xFF;
+    tx[1] = (reg_addr >> 8) & 0xFF;
+  }
+
+  if (tx_buf)
+    memcpy(&tx[2], tx_buf, len);
+  else
+    memset(&tx[2], 0, len);
+
+  // Write message for address + data (cs_change = 0 -> CS released at the end of message)
+  xfer[0].tx_buf = (__u64)(uintptr_t)tx;                      // output buffer
+  xfer[0].rx_buf = (__u64)(uintptr_t)(rx_buf ? rx : NULL);    // input buffer
+  xfer[0].len = (__u32)(2 + len);                              // length of address + data
+  xfer[0].speed_hz = self->reg_speed;
+
+  retv = ioctl(self->fd, SPI_IOC_MESSAGE(1), xfer);
+  if (retv < 0)
+  {
+    SPI_DBG("error in spi_transfer_reg16(): ioctl(SPI_IOC_MESSAGE(1)) return %d", retv);
+    return rx_buf ? SPI_ERR_READ : SPI_ERR_WRITE;
+  }
+
+  if (rx_buf)
+    memcpy(rx_buf, &rx[2], len);
+
+  return retv;
+}
+//----------------------------------------------------------------------------
+// read and/or write data from/to specific register address directly from/to
+// caller buffers [2 byte address + data as two transfers of one message]
+int spi_burst_reg16(spi_t *self, uint16_t reg_addr, void *rx_buf, const void *tx_buf, int len, int swap)
+{
+  int retv;
+  uint8_t addr[2];
+
+  struct spi_ioc_transfer xfer[2] = {0};
+
+  if (len < 0 || len + 2 > SPI_MSG_ROOM(self->bufsiz, 2))
+  {
+    SPI_DBG("error in spi_burst_reg16(): invalid length %d", len);
+    return SPI_ERR_EXCHANGE;
+  }
+
+  // address is always sent MSB first on the wire
+  if (swap)
+  {
+    addr[0] = (reg_addr >> 8) & 0xFF;
+    addr[1] = reg_addr & 0xFF;
+  }
+  else
+  {
+    addr[0] = reg_addr & 0xFF;
+    addr[1] = (reg_addr >> 8) & 0xFF;
+  }
+
+  // Write message for register address
+  xfer[0].tx_buf = (__u64)(uintptr_t)addr;   // output buffer
+  xfer[0].rx_buf = (__u64)0;                 // input buffer
+  xfer[0].len = (__u32)sizeof(addr);         // length of address
+  xfer[0].speed_hz = self->burst_speed;
+
+  // Write message for data (cs_change = 0 -> CS held between transfers)
+  xfer[1].tx_buf = (__u64)(uintptr_t)tx_buf; // output buffer
+  xfer[1].rx_buf = (__u64)(uintptr_t)rx_buf; // input buffer
+  xfer[1].len = (__u32)len;                  // length of data
+  xfer[1].speed_hz = self->burst_speed;
+
+  retv = ioctl(self->fd, SPI_IOC_MESSAGE(2), xfer);
+  if (retv < 0)
+  {
+    SPI_DBG("error in spi_burst_reg16(): ioctl(SPI_IOC_MESSAGE(2)) return %d", retv);
+    return rx_buf ? SPI_ERR_READ : SPI_ERR_WRITE;
+  }
+
+  return retv;
+}
@@ -31,6 +31,17 @@
 #  define SPI_DBG(fmt, ...) // debug output off
 #endif // SPI_DEBUG
 //----------------------------------------------------------------------------
+// max. data length of one contiguous register transfer (without 2 byte address)
+#define SPI_REG16_MAX_LEN 256
+// spidev message size limit if /sys/module/spidev/parameters/bufsiz can't be read
+#define SPI_DEFAULT_BUFSIZ 4096
+#define SPI_BUFSIZ_PATH "/sys/module/spidev/parameters/bufsiz"
+// spidev pads every transfer of a message to ARCH_KMALLOC_MINALIGN before checking
+// bufsiz - worst case (arm64 DMA alignment), one per transfer
+#define SPI_KMALLOC_MINALIGN 128
+// payload bytes of one message with `n` transfers which always fit into bufsiz
+#define SPI_MSG_ROOM(bufsiz, n) ((bufsiz) - (n) * SPI_KMALLOC_MINALIGN)
+//----------------------------------------------------------------------------
 // `spi_t` type structure
 typedef struct spi_ {
   int   fd;    // file descriptor: fd = open(filename, O_RDWR);
@@ -38,6 +49,9 @@ typedef struct spi_ {
   __u8  mode;  // SPI mode
   __u8  lsb;   // LSB first
   __u8  bits;  // bits per word
+  int   bufsiz; // max. bytes of one SPI_IOC_MESSAGE (spidev 'bufsiz' parameter)
+  __u32 reg_speed;   // speed_hz of register transfers / messages [Hz] (0 -> 'speed')
+  __u32 burst_speed; // speed_hz of bursts and raw exchanges [Hz] (0 -> 'speed')
 } spi_t;
 //----------------------------------------------------------------------------
 #ifdef __cplusplus
@@ -61,6 +75,10 @@ int spi_set_mode(spi_t* self, int mode);
 // sets speed on existing spi
 int spi_set_speed(spi_t* self, int speed);
 //----------------------------------------------------------------------------
+// sets per-transfer speeds (spi_ioc_transfer.speed_hz) - register transfers
+// vs. bursts, 0 -> max speed set by spi_init() / spi_set_speed()
+void spi_set_xfer_speed(spi_t* self, int reg_speed, int burst_speed);
+//----------------------------------------------------------------------------
 // close SPIdev file and free memory
 void spi_free(spi_t *self);
 //----------------------------------------------------------------------------
@@ -84,6 +102,19 @@ int spi_read_reg16(spi_t *self, uint16_t reg_addr, void* rx_buf, int len, int sw
 //----------------------------------------------------------------------------
 // write data to SPIdev to specific register address
 int spi_write_reg16(spi_t *self, uint16_t reg_addr, const void* tx_buf, int len, int swap);
+//----------------------------------------------------------------------------
+// send prepared transfers as one message - ioctl(SPI_IOC_MESSAGE(n))
+int spi_message(spi_t *self, struct spi_ioc_transfer *xfer, int n);
+//----------------------------------------------------------------------------
+// read and/or write data from/to specific register address as one contiguous
+// full-duplex transfer (2 byte address + data) - exactly one ioctl
+// * rx_buf or tx_buf may be NULL, len <= SPI_REG16_MAX_LEN
+int spi_transfer_reg16(spi_t *self, uint16_t reg_addr, void* rx_buf, const void* tx_buf, int len, int swap);
+//----------------------------------------------------------------------------
+// read and/or write data from/to specific register address directly from/to
+// caller buffers - address and data are two transfers of one message (CS held)
+// * rx_buf or tx_buf may be NULL, 2 + len <= SPI_MSG_ROOM(self->bufsiz, 2)
+int spi_burst_reg16(spi_t *self, uint16_t reg_addr, void* rx_buf, const void* tx_buf, int len, int swap);
 
 #ifdef __cplusplus
 }
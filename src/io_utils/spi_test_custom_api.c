@@ -7,6 +7,8 @@
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
+#include <stdlib.h>
+#include <time.h>
 
 //-----------------------------------------------------------------------------
 #define SPI_DEVICE "/dev/spidev0.0"   // or #define SPI_DEVICE "/dev/spidev1.0"
@@ -19,10 +21,13 @@
 /* --  Version register -- */
 #define REG_RF_PN 0x000D
 #define REG_RF_VN 0x000E
+/* --  BBC0 RX frame buffer -- */
+#define REG_BBC0_FBRXS 0x2000
+#define FRAME_BUFFER_SIZE 2047
 
 typedef struct at86rf215_st_t{
        int version;
-       spi_t *io_spi;
+       io_utils_dev_s io;
 }at86rf215_st;
 
 unsigned int thread_cnt = 0;
@@ -44,7 +49,7 @@ static int at86rf215_write_buffer(at86rf215_st* dev, uint16_t addr, uint8_t *buf
     
     memcpy(chunk_tx, buffer, size);
 
-    return io_utils_spi_write_buffer(dev->io_spi, addr, chunk_tx, size);
+    return io_utils_spi_write_buffer(&dev->io, addr, chunk_tx, size);
 }
 
 static int at86rf215_read_buffer(at86rf215_st* dev, uint16_t addr, uint8_t *buffer, uint8_t size){
@@ -53,7 +58,7 @@ static int at86rf215_read_buffer(at86rf215_st* dev, uint16_t addr, uint8_t *buff
     uint8_t chunk_rx[256] = {0};
     addr = (addr & 0x3FFF);
 
-    int ret = io_utils_spi_read_buffer(dev->io_spi, addr, chunk_rx, size);
+    int ret = io_utils_spi_read_buffer(&dev->io, addr, chunk_rx, size);
 
     if (ret > 0){
         memcpy(buffer, chunk_rx, size);
@@ -67,7 +72,7 @@ static int at86rf215_write_byte(at86rf215_st* dev, uint16_t addr, uint8_t val){
     uint8_t chunk_tx = val;
     addr = (addr & 0x3FFF) | 0x8000;
     
-    return io_utils_spi_write_byte(dev->io_spi, addr, chunk_tx);
+    return io_utils_spi_write_byte(&dev->io, addr, chunk_tx);
 }
 
 static int at86rf215_read_byte(at86rf215_st* dev, uint16_t addr){
@@ -75,7 +80,7 @@ static int at86rf215_read_byte(at86rf215_st* dev, uint16_t addr){
     uint8_t chunk_rx = {0};
     addr = (addr & 0x3FFF);
     
-    int ret = io_utils_spi_read_byte(dev->io_spi, addr, &chunk_rx);
+    int ret = io_utils_spi_read_byte(&dev->io, addr, &chunk_rx);
     
     if (ret < 0){
         return ret;
@@ -126,6 +131,75 @@ int at86rf215_print_version(at86rf215_st* dev){
 	return pn;
 }
 
+// bench_elapsed_s - elapsed time in seconds between two CLOCK_MONOTONIC samples
+static double bench_elapsed_s(struct timespec *t0, struct timespec *t1){
+    
+    return (double)(t1->tv_sec - t0->tv_sec) + (double)(t1->tv_nsec - t0->tv_nsec) * 1e-9;
+}
+
+// bench_register_ops - register read ops/sec: per edge CS re-request (before) vs. persistent CS line handle (after)
+static void bench_register_ops(at86rf215_st* dev, int iterations){
+    
+    struct timespec t0, t1;
+    uint8_t val = 0;
+    double before = 0.0, after = 0.0;
+    
+    // Before - CS line is opened, requested, set and closed on every edge ...
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for(int i=0;i<iterations;i++){
+        gpio_write_single(GPIO_DEVICE, GPIO_CS_OFFSET, GPIO_LO_LEVEL);
+        spi_read_reg16(&dev->io.spi, REG_RF_PN, &val, 1, 1);
+        gpio_write_single(GPIO_DEVICE, GPIO_CS_OFFSET, GPIO_HI_LEVEL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    before = iterations / bench_elapsed_s(&t0, &t1);
+    
+    // After - CS line handle is held by io_utils, one ioctl per edge ...
+    io_utils_setup_gpio(&dev->io, GPIO_DEVICE, GPIO_DEVICE, GPIO_CS_OFFSET);
+    
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for(int i=0;i<iterations;i++){
+        io_utils_spi_read_byte(&dev->io, REG_RF_PN, &val);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    after = iterations / bench_elapsed_s(&t0, &t1);
+    
+    printf("Register read benchmark (%d iterations, last value 0x%02x):\n", iterations, val);
+    printf("  per edge CS request: %.0f ops/sec\n", before);
+    printf("  persistent CS handle: %.0f ops/sec (x%.2f)\n", after, after / before);
+}
+
+// bench_frame_buffer - full frame buffer read: 255 byte chunks via bounce buffer (before) vs. zero-copy burst (after)
+static void bench_frame_buffer(at86rf215_st* dev, int iterations){
+    
+    struct timespec t0, t1;
+    static uint8_t frame[FRAME_BUFFER_SIZE];
+    double before = 0.0, after = 0.0;
+    
+    // Before - uint8_t sized register reads, each one copied out of a stack buffer ...
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for(int i=0;i<iterations;i++){
+        for(int ofs=0;ofs<FRAME_BUFFER_SIZE;ofs+=255){
+            int len = (FRAME_BUFFER_SIZE - ofs) > 255 ? 255 : (FRAME_BUFFER_SIZE - ofs);
+            at86rf215_read_buffer(dev, REG_BBC0_FBRXS + ofs, &frame[ofs], len);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    before = iterations / bench_elapsed_s(&t0, &t1);
+    
+    // After - one burst straight into the caller buffer ...
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for(int i=0;i<iterations;i++){
+        io_utils_spi_read_burst(&dev->io, REG_BBC0_FBRXS, frame, FRAME_BUFFER_SIZE);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    after = iterations / bench_elapsed_s(&t0, &t1);
+    
+    printf("Frame buffer read benchmark (%d iterations, %d bytes, bufsiz %d):\n", iterations, FRAME_BUFFER_SIZE, dev->io.spi.bufsiz);
+    printf("  255 byte chunks: %.0f frames/sec\n", before);
+    printf("  zero-copy burst: %.0f frames/sec (x%.2f)\n", after, after / before);
+}
+
 static void gpio_event_callback(void *param, void *user_data){
     
     struct at86rf215_st_t *data_ptr = (struct at86rf215_st_t *)user_data;
@@ -148,32 +222,66 @@ static void gpio_event_callback(void *param, void *user_data){
     
 }
 
-int main(){
+int main(int argc, char *argv[]){
    
+  int opt = 0;
+  int bench_iterations = 0;
+  int bench_frame_iterations = 0;
+  int burst_speed = 0;
+  
   at86rf215_st rf_struct ={0}; 
   rf_struct.version = 0x9999;  // Test value only ...
+  
+  // -b <iterations> --> run register access benchmark only
+  // -f <iterations> --> run frame buffer burst benchmark only
+  // -s <hz>         --> burst SPI clock (per-transfer speed_hz), registers stay at 1 MHz
+  while((opt = getopt(argc, argv, "b:f:s:")) != -1){
+      if(opt == 'b') bench_iterations = atoi(optarg);
+      if(opt == 'f') bench_frame_iterations = atoi(optarg);
+      if(opt == 's') burst_speed = atoi(optarg);
+  }
     
   gpio_list(GPIO_DEVICE);
   
+  // Init io_utils device context
+  io_utils_dev_init(&rf_struct.io);
+  
   // Init GPIO bank + SPI CS  
-  io_utils_setup_gpio(GPIO_DEVICE, GPIO_CS_OFFSET); 
+  io_utils_setup_gpio(&rf_struct.io, GPIO_DEVICE, GPIO_DEVICE, GPIO_CS_OFFSET); 
     
   // Init SPI + spi struct
-  int ret = io_utils_spi_init(&rf_struct.io_spi, SPI_DEVICE, 0, 0, 1000000);
+  int ret = io_utils_spi_init(&rf_struct.io, SPI_DEVICE, 0, 0, 1000000);
   
   if(ret!=0){
      printf("Unable to init SPI device !!!\n");
      return 1; 
   }
   
+  if(bench_iterations > 0){
+     // Benchmark needs the CS line free for the per edge request variant ...
+     io_utils_release_gpio(&rf_struct.io);
+     bench_register_ops(&rf_struct, bench_iterations);
+     io_utils_release_gpio(&rf_struct.io);
+     io_utils_spi_close(&rf_struct.io);
+     return 0;
+  }
+  
+  if(bench_frame_iterations > 0){
+     io_utils_spi_set_xfer_speed(&rf_struct.io, 0, burst_speed);
+     bench_frame_buffer(&rf_struct, bench_frame_iterations);
+     io_utils_release_gpio(&rf_struct.io);
+     io_utils_spi_close(&rf_struct.io);
+     return 0;
+  }
+  
   // Print version of AT86RF215 ...
   at86rf215_print_version(&rf_struct);
   
   // Reset GPIO to 0
-  io_utils_write_gpio(GPIO_RESET_OFFSET, GPIO_LO_LEVEL);
+  io_utils_write_gpio(&rf_struct.io, GPIO_RESET_OFFSET, GPIO_LO_LEVEL);
   
   // Setup external interrupt callback
-  ret = io_utils_setup_interrupt(GPIO_EXT_INT_OFFSET, &gpio_event_callback, (void *)&rf_struct);
+  ret = io_utils_setup_interrupt(&rf_struct.io, GPIO_EXT_INT_OFFSET, &gpio_event_callback, (void *)&rf_struct);
   
   if(ret!=0){
      printf("Unable to set externall interrupt !!!\n");
@@ -182,9 +290,9 @@ int main(){
   
   for(int i=0;i<60;i++){
      // io_utils_write_gpio --> toggle 0/1
-     io_utils_write_gpio(GPIO_RESET_OFFSET, GPIO_HI_LEVEL);
+     io_utils_write_gpio(&rf_struct.io, GPIO_RESET_OFFSET, GPIO_HI_LEVEL);
      sleep(2);
-     io_utils_write_gpio(GPIO_RESET_OFFSET, GPIO_LO_LEVEL);
+     io_utils_write_gpio(&rf_struct.io, GPIO_RESET_OFFSET, GPIO_LO_LEVEL);
   }
   
   // Show callback status:
@@ -194,10 +302,13 @@ int main(){
   sleep(60);
   
   // Disable external interrupt
-  io_utils_disable_interrupt();
+  io_utils_disable_interrupt(&rf_struct.io);
   
   // Close SPI      
-  io_utils_spi_close(rf_struct.io_spi);      
+  io_utils_spi_close(&rf_struct.io);      
+  
+  // Release CS line handle
+  io_utils_release_gpio(&rf_struct.io);
   
   return 0;
 }
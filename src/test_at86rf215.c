@@ -1,7 +1,11 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <ctype.h>
 #include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/epoll.h>
 #include "at86rf215.h"
 #include "at86rf215_radio.h"
 #include "io_utils/io_utils.h"
@@ -19,9 +23,32 @@ at86rf215_st dev =
     .spi_mode = 0,        // SPI mode (0)
     .spi_bits = 0,        // SPI bits mode (0 ... 8 bits) 
     .spi_speed = 1000000, // SPI baud rate
+    .cs_mode = IO_UTILS_CS_GPIO, // CS emulated by GPIO, IO_UTILS_CS_NATIVE --> CS driven by SPI core
+    .spi_speed_auto = 0,  // 1 --> frame buffer bursts at the fastest verified SPI clock (at86rf215_spi_characterize)
     
 };
 
+// Additional devices for TEST_MULTI_DEV (own SPI bus / GPIO chips, no shared io_utils state) ...
+#define TEST_MULTI_DEV_NUM 2
+
+at86rf215_st dev_multi[TEST_MULTI_DEV_NUM - 1] =
+{
+    {
+        .cs_pin = GPIO_CS_OFFSET,
+        .reset_pin = GPIO_RESET_OFFSET,
+        .irq_pin = GPIO_EXT_INT_OFFSET,
+
+        .spi_mode = 0,
+        .spi_bits = 0,
+        .spi_speed = 1000000,
+        .cs_mode = IO_UTILS_CS_NATIVE,
+
+        .spi_dev = "/dev/spidev1.0",
+        .gpio_dev = "/dev/gpiochip2",
+        .gpio_dev_isr = "/dev/gpiochip0",
+    },
+};
+
 uint16_t unknown_regs[] = { 0x0015, 
                             0x0115, 0x0117, 0x0118, 0x0119, 0x011A, 0x011B, 0x011C, 0x011D, 0x011E, 0x011F, 0x0120, 0x0123, 0x0124, 0x0129,
                             0x0215, 0x0217, 0x0218, 0x0219, 0x021A, 0x021B, 0x021C, 0x021D, 0x021E, 0x021F, 0x0220, 0x0223, 0x0224, 0x0229};
@@ -32,6 +59,7 @@ uint8_t defaults[] =    {   0x0E,
 
 // -----------------------------------------------------------------------------------------
                         
+#if TEST_TX || TEST_RX
 static void myflush ( FILE *in ){
   int ch;
 
@@ -63,6 +91,7 @@ static int str_compare(const char *input, char *output){
     }
     return check_result;
 }
+#endif // TEST_TX || TEST_RX
                             
 // This test checks the version number and part numbers of the device
 int test_at86rf215_read_all_regs(at86rf215_st* dev)
@@ -246,6 +275,644 @@ int test_at86rf215_continues_iq_loopback (at86rf215_st* dev, at86rf215_rf_channe
     return 1;
 }
 
+// -----------------------------------------------------------------------------------------
+// Asynchronous SPI engine vs. synchronous register reads (volatile RF09_STATE - never cached)
+// depth - number of requests kept in flight
+
+static double test_elapsed_us(struct timespec *t0, struct timespec *t1)
+{
+    return (t1->tv_sec - t0->tv_sec) * 1e6 + (t1->tv_nsec - t0->tv_nsec) * 1e-3;
+}
+
+int test_at86rf215_async_benchmark (at86rf215_st* dev, int iterations, int depth)
+{
+    struct timespec t0, t1, ts;
+    struct timespec submit_ts[AT86RF215_ASYNC_RING_SIZE];
+    uint8_t slot[AT86RF215_ASYNC_RING_SIZE];
+    double sync_us = 0.0, async_us = 0.0, latency_us = 0.0;
+    int submitted = 0, completed = 0;
+
+    if (depth < 1) depth = 1;
+    if (depth > AT86RF215_ASYNC_RING_SIZE) depth = AT86RF215_ASYNC_RING_SIZE;
+
+    // Synchronous path ...
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < iterations; i++)
+    {
+        at86rf215_read_byte(dev, REG_RF09_STATE);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    sync_us = test_elapsed_us(&t0, &t1);
+
+    // Asynchronous path - 'depth' requests in flight ...
+    if (at86rf215_async_start(dev) != 0)
+    {
+        return 0;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    while (completed < iterations)
+    {
+        while (submitted < iterations && submitted - completed < depth)
+        {
+            int idx = submitted % AT86RF215_ASYNC_RING_SIZE;
+            at86rf215_async_sqe_st sqe = {
+                .op = at86rf215_async_op_read,
+                .addr = REG_RF09_STATE,
+                .buffer = &slot[idx],
+                .size = 1,
+                .tag = (uint64_t)submitted,
+            };
+            clock_gettime(CLOCK_MONOTONIC, &submit_ts[idx]);
+            if (at86rf215_async_submit(dev, &sqe, 1) != 1) break;
+            submitted++;
+        }
+
+        at86rf215_async_cqe_st cqe;
+        if (at86rf215_async_wait(dev, &cqe, 1000) == 1)
+        {
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            latency_us += test_elapsed_us(&submit_ts[cqe.tag % AT86RF215_ASYNC_RING_SIZE], &ts);
+            completed++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    async_us = test_elapsed_us(&t0, &t1);
+
+    at86rf215_async_stop(dev);
+
+    printf("TEST:AT86RF215:ASYNC:ITERATIONS=%d, DEPTH=%d\n", iterations, depth);
+    printf("TEST:AT86RF215:ASYNC:SYNC=%.0f ops/sec, %.2f usec/op\n", iterations / sync_us * 1e6, sync_us / iterations);
+    printf("TEST:AT86RF215:ASYNC:ASYNC=%.0f ops/sec, %.2f usec avg. completion latency\n", iterations / async_us * 1e6, latency_us / iterations);
+    return 1;
+}
+
+// -----------------------------------------------------------------------------------------
+// SPI bus arbiter wait time histogram (only acquisitions which had to wait)
+
+void test_at86rf215_print_bus_stats (at86rf215_st* dev)
+{
+    at86rf215_bus_stats_st stats;
+    const char* name[2] = {"NORMAL", "HIGH"};
+
+    at86rf215_bus_get_stats(dev, &stats);
+
+    for (int p = 0; p < 2; p++)
+    {
+        printf("TEST:AT86RF215:BUS:%s:WAITS=%llu, AVG=%.2f usec, MAX=%.2f usec\n", name[p],
+               (unsigned long long)stats.acquired_slow[p],
+               stats.acquired_slow[p] ? stats.total_wait_ns[p] / 1e3 / stats.acquired_slow[p] : 0.0,
+               stats.max_wait_ns[p] / 1e3);
+        for (int b = 0; b < AT86RF215_BUS_HIST_BINS; b++)
+        {
+            if (stats.wait_hist[p][b] == 0) continue;
+            printf("TEST:AT86RF215:BUS:%s:HIST[%s %d usec]=%llu\n", name[p],
+                   (b == AT86RF215_BUS_HIST_BINS - 1) ? ">=" : "<", 1 << (b - (b == AT86RF215_BUS_HIST_BINS - 1)),
+                   (unsigned long long)stats.wait_hist[p][b]);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------------------
+// N devices driven from N threads - aggregate throughput vs. a single device
+// Each device has its own io_utils context, so ops/sec should scale with the number of devices
+
+typedef struct
+{
+    at86rf215_st* dev;
+    int iterations;
+    double elapsed_us;
+} test_multi_dev_arg_st;
+
+static void* test_multi_dev_thread(void* arg)
+{
+    test_multi_dev_arg_st* a = (test_multi_dev_arg_st*)arg;
+    struct timespec t0, t1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < a->iterations; i++)
+    {
+        at86rf215_read_byte(a->dev, REG_RF09_STATE);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    a->elapsed_us = test_elapsed_us(&t0, &t1);
+    return NULL;
+}
+
+int test_at86rf215_multi_device_benchmark (at86rf215_st** devs, int num_devs, int iterations)
+{
+    pthread_t threads[num_devs];
+    test_multi_dev_arg_st args[num_devs];
+    struct timespec t0, t1;
+    double single_ops = 0.0, total_us = 0.0;
+
+    // One device alone ...
+    args[0] = (test_multi_dev_arg_st){ .dev = devs[0], .iterations = iterations };
+    test_multi_dev_thread(&args[0]);
+    single_ops = iterations / args[0].elapsed_us * 1e6;
+
+    // All devices in parallel, one thread each ...
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < num_devs; i++)
+    {
+        args[i] = (test_multi_dev_arg_st){ .dev = devs[i], .iterations = iterations };
+        pthread_create(&threads[i], NULL, test_multi_dev_thread, &args[i]);
+    }
+    for (int i = 0; i < num_devs; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    total_us = test_elapsed_us(&t0, &t1);
+
+    double total_ops = (double)num_devs * iterations / total_us * 1e6;
+
+    printf("TEST:AT86RF215:MULTI_DEV:DEVICES=%d, ITERATIONS=%d\n", num_devs, iterations);
+    printf("TEST:AT86RF215:MULTI_DEV:SINGLE=%.0f ops/sec\n", single_ops);
+    for (int i = 0; i < num_devs; i++)
+    {
+        printf("TEST:AT86RF215:MULTI_DEV:DEV%d=%.0f ops/sec\n", i, iterations / args[i].elapsed_us * 1e6);
+    }
+    printf("TEST:AT86RF215:MULTI_DEV:AGGREGATE=%.0f ops/sec, scaling x%.2f (ideal x%d)\n", total_ops, total_ops / single_ops, num_devs);
+    return 1;
+}
+
+// -----------------------------------------------------------------------------------------
+// Software emulator (at86rf215_st.emulated) - reset values, state machine timing and TRXRDY interrupt
+
+static void test_emulator_irq_count(at86rf215_st* dev, int bit, void* user)
+{
+    __atomic_add_fetch((int*)user, 1, __ATOMIC_RELAXED);
+}
+
+int test_at86rf215_emulator_check (at86rf215_st* dev)
+{
+    int pass = 1;
+    int num_regs = sizeof(unknown_regs) / sizeof(uint16_t);
+    struct timespec t0, t1;
+    at86rf215_emu_stats_st stats;
+
+    for (int i = 0; i < num_regs; i ++)
+    {
+        if (at86rf215_read_byte(dev, unknown_regs[i]) != defaults[i]) pass = 0;
+    }
+    printf("TEST:AT86RF215:EMU:DEFAULTS:PASS=%d\n", pass);
+
+    // TRXOFF --> TXPREP with TRXRDY unmasked, subscribed as callback and wait object ...
+    int irqs = dev->num_interrupts;
+    int sub_calls = 0;
+    event_st sub_event = {0};
+    event_node_init(&sub_event);
+    at86rf215_irq_sub_st* sub_cb = at86rf215_irq_subscribe(dev, AT86RF215_IRQ_RADIO(at86rf215_rf_channel_900mhz, at86rf215_radio_irq_trx_ready),
+                                                           test_emulator_irq_count, &sub_calls);
+    at86rf215_irq_sub_st* sub_ev = at86rf215_irq_subscribe_event(dev, AT86RF215_IRQ_RADIO(at86rf215_rf_channel_900mhz, at86rf215_radio_irq_trx_ready),
+                                                                 &sub_event);
+    at86rf215_write_byte(dev, REG_RF09_IRQM, 1 << RF_IRQM_TRXRDY);
+    at86rf215_radio_set_state(dev, at86rf215_rf_channel_900mhz, at86rf215_radio_state_cmd_trx_off);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    at86rf215_radio_set_state(dev, at86rf215_rf_channel_900mhz, at86rf215_radio_state_cmd_tx_prep);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    int state = at86rf215_radio_get_state(dev, at86rf215_rf_channel_900mhz);
+    if (event_node_wait_timeout(&sub_event, 100000) != 0) pass = 0;
+    at86rf215_irq_unsubscribe(dev, sub_cb);
+    at86rf215_irq_unsubscribe(dev, sub_ev);
+    event_node_close(&sub_event);
+    io_utils_usleep(50000);
+    at86rf215_write_byte(dev, REG_RF09_IRQM, 0);
+    at86rf215_radio_set_state(dev, at86rf215_rf_channel_900mhz, at86rf215_radio_state_cmd_trx_off);
+
+    printf("TEST:AT86RF215:EMU:TXPREP:STATE=%d, SET_STATE=%.1f usec, IRQS=%d\n", state, test_elapsed_us(&t0, &t1), dev->num_interrupts - irqs);
+    printf("TEST:AT86RF215:EMU:CAL:LOW=(%d,%d), HIGH=(%d,%d)\n", dev->cal.low_ch_i, dev->cal.low_ch_q, dev->cal.hi_ch_i, dev->cal.hi_ch_q);
+    if (state != at86rf215_radio_state_cmd_tx_prep || dev->num_interrupts == irqs) pass = 0;
+
+    printf("TEST:AT86RF215:EMU:SUBSCRIBER:CALLS=%d\n", sub_calls);
+    if (sub_calls == 0) pass = 0;
+
+    event_stats_st ev_stats;
+    event_node_get_stats(&dev->events.lo_trx_ready_event, &ev_stats);
+    printf("TEST:AT86RF215:EMU:TRXRDY_EVENT:SIGNALS=%llu, WAITS=%llu, SPIN_HITS=%llu, TIMEOUTS=%llu, MAX_WAKE=%.1f usec\n",
+           (unsigned long long)ev_stats.signals, (unsigned long long)ev_stats.waits, (unsigned long long)ev_stats.spin_hits,
+           (unsigned long long)ev_stats.timeouts, ev_stats.max_wake_ns / 1e3);
+
+    at86rf215_irq_latency_st lat;
+    at86rf215_get_irq_latency(dev, &lat);
+    for (int s = 0; s < at86rf215_irq_lat_stages; s++)
+    {
+        printf("TEST:AT86RF215:EMU:IRQ_LATENCY:%s:N=%llu, MAX=%.1f usec\n", at86rf215_irq_latency_stage_name(s),
+               (unsigned long long)lat.stage[s].count, lat.stage[s].max_ns / 1e3);
+    }
+
+    at86rf215_radio_state_stats_st st_stats;
+    at86rf215_radio_get_state_stats(dev, at86rf215_rf_channel_900mhz, &st_stats);
+    printf("TEST:AT86RF215:EMU:STATE_TRANSITIONS:N=%llu, TIMEOUTS=%llu, POLLS=%llu, MEAN=%.1f usec, MAX=%.1f usec\n",
+           (unsigned long long)st_stats.transitions, (unsigned long long)st_stats.timeouts, (unsigned long long)st_stats.polls,
+           st_stats.transitions ? st_stats.total_ns / 1e3 / st_stats.transitions : 0.0, st_stats.max_ns / 1e3);
+    if (st_stats.timeouts != 0) pass = 0;
+
+    if (at86rf215_emu_get_stats(dev, &stats) == 0)
+    {
+        printf("TEST:AT86RF215:EMU:STATS:FRAMES=%llu, BYTES=%llu, COMMANDS=%llu, TRANSITIONS=%llu, IRQ_EDGES=%llu\n",
+               (unsigned long long)stats.frames, (unsigned long long)stats.bytes, (unsigned long long)stats.commands,
+               (unsigned long long)stats.transitions, (unsigned long long)stats.irq_edges);
+    }
+
+    // Edge sequence numbers (uAPI v2 records) - every queued edge reached the poll thread ...
+    printf("TEST:AT86RF215:EMU:IRQ_LINE:EVENTS=%llu, LOST=%llu\n",
+           (unsigned long long)dev->io.irq_event.events, (unsigned long long)dev->io.irq_event.lost);
+    if (dev->io.irq_event.lost != 0) pass = 0;
+
+    printf("TEST:AT86RF215:EMU:PASS=%d\n", pass);
+    return pass;
+}
+
+// -----------------------------------------------------------------------------------------
+// IRQ without poll thread (at86rf215_st.irq_fd_mode) - the device event fd is served from an epoll loop
+// on this thread; runs on its own emulated device
+
+int test_at86rf215_event_fd (void)
+{
+    static at86rf215_st efd_dev = { .irq_pin = GPIO_EXT_INT_OFFSET, .emulated = 1, .irq_fd_mode = 1 };
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &efd_dev }, out;
+    struct timespec t0, t1;
+    int pass = 1;
+
+    if (at86rf215_init(&efd_dev) != 0)
+    {
+        printf("TEST:AT86RF215:EVENT_FD:PASS=0\n");
+        return 0;
+    }
+
+    int epfd = epoll_create1(0);
+    epoll_ctl(epfd, EPOLL_CTL_ADD, at86rf215_get_event_fd(&efd_dev), &ev);
+
+    // Edges queued during init are served first ...
+    at86rf215_write_byte(&efd_dev, REG_RF09_IRQM, 1 << RF_IRQM_TRXRDY);
+    at86rf215_radio_set_state(&efd_dev, at86rf215_rf_channel_900mhz, at86rf215_radio_state_cmd_trx_off);
+    while (epoll_wait(epfd, &out, 1, 0) > 0) at86rf215_process_events((at86rf215_st*)out.data.ptr);
+    int irqs = efd_dev.num_interrupts;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    at86rf215_write_byte(&efd_dev, REG_RF09_CMD, at86rf215_radio_state_cmd_tx_prep);
+    int n = epoll_wait(epfd, &out, 1, 100);
+    if (n == 1) at86rf215_process_events((at86rf215_st*)out.data.ptr);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    printf("TEST:AT86RF215:EVENT_FD:TXPREP:IRQS=%d, CMD_TO_DISPATCH=%.1f usec\n", efd_dev.num_interrupts - irqs, test_elapsed_us(&t0, &t1));
+    if (n != 1 || efd_dev.num_interrupts == irqs) pass = 0;
+
+    at86rf215_write_byte(&efd_dev, REG_RF09_IRQM, 0);
+    close(epfd);
+    at86rf215_close(&efd_dev, 0);
+
+    printf("TEST:AT86RF215:EVENT_FD:PASS=%d\n", pass);
+    return pass;
+}
+
+// -----------------------------------------------------------------------------------------
+// IRQ line not wired - AT86RF215_IRQ_MODE_POLL: init without irq_pin, TRXRDY by polling the IRQS bytes
+
+int test_at86rf215_irq_poll (void)
+{
+    static at86rf215_st poll_dev = { .irq_pin = -1, .emulated = 1, .irq_mode = AT86RF215_IRQ_MODE_POLL };
+    struct timespec t0, t1;
+    int pass = 1;
+
+    if (at86rf215_init(&poll_dev) != 0)
+    {
+        printf("TEST:AT86RF215:IRQ_POLL:PASS=0\n");
+        return 0;
+    }
+
+    at86rf215_write_byte(&poll_dev, REG_RF09_IRQM, 1 << RF_IRQM_TRXRDY);
+    at86rf215_radio_set_state(&poll_dev, at86rf215_rf_channel_900mhz, at86rf215_radio_state_cmd_trx_off);
+    while (at86rf215_irq_poll(&poll_dev) > 0);
+    event_node_signal_ready(&poll_dev.events.lo_trx_ready_event, 0);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    at86rf215_write_byte(&poll_dev, REG_RF09_CMD, at86rf215_radio_state_cmd_tx_prep);
+    int ret = at86rf215_wait_event(&poll_dev, &poll_dev.events.lo_trx_ready_event, 100000);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    printf("TEST:AT86RF215:IRQ_POLL:TXPREP:RET=%d, CMD_TO_WAITER=%.1f usec\n", ret, test_elapsed_us(&t0, &t1));
+    if (ret != 0) pass = 0;
+
+    at86rf215_write_byte(&poll_dev, REG_RF09_IRQM, 0);
+    at86rf215_close(&poll_dev, 0);
+
+    printf("TEST:AT86RF215:IRQ_POLL:PASS=%d\n", pass);
+    return pass;
+}
+
+// -----------------------------------------------------------------------------------------
+// SPI transaction trace - recording cost per transaction and binary dump
+// Decode with: at86rf215_trace_decode -r src/at86rf215_regs.h <path>
+
+int test_at86rf215_trace (at86rf215_st* dev, int iterations, const char* path)
+{
+    struct timespec t0, t1;
+    uint8_t data[4] = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < iterations; i++)
+    {
+        at86rf215_trace_record(dev, at86rf215_trace_op_read, REG_RF09_STATE, 1, data, at86rf215_trace_begin(dev), 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    // Some real traffic on top of the synthetic entries ...
+    at86rf215_radio_set_state(dev, at86rf215_rf_channel_900mhz, at86rf215_radio_state_cmd_trx_off);
+    at86rf215_get_irqs(dev, (at86rf215_irq_st*)data, 0);
+
+    int num = at86rf215_trace_dump(dev, path);
+
+    printf("TEST:AT86RF215:TRACE:RECORD=%.1f nsec/transaction\n", test_elapsed_us(&t0, &t1) * 1e3 / iterations);
+    printf("TEST:AT86RF215:TRACE:DUMP=%d entries, %s\n", num, path);
+    return num > 0;
+}
+
+// -----------------------------------------------------------------------------------------
+// Deterministic replay of a recorded SPI session (at86rf215_trace_dump) - performance regression
+// Transactions are re-issued in recorded order below the library (no register shadow, no IRQ thread,
+// IRQ thread reads of the recording included), phases are split by at86rf215_trace_mark entries.
+// pace = 0 --> back-to-back (transaction cost only), 1 --> recorded start offsets are kept (chip timing)
+
+#define TEST_REPLAY_MAX_PHASES  32
+#define TEST_REPLAY_MAX_DEVS    16      // Deviations printed
+
+typedef struct
+{
+    char name[AT86RF215_TRACE_DATA + 1];
+    int transactions;
+    int truncated;                      // Writes longer than AT86RF215_TRACE_DATA (payload not recorded - skipped)
+    uint64_t calls;                     // Transport calls (replay_count_*)
+    uint64_t deviations;                // Reads which returned other data than recorded
+    double recorded_us;
+    double replay_min_us;
+    double replay_sum_us;
+} test_replay_phase_st;
+
+// Counting shim in front of the real transport - every call is one ioctl with spidev / gpiochip CS ...
+static const io_utils_transport_s *replay_real = NULL;
+static uint64_t replay_calls = 0;
+static int replay_skips_printed = 0;        // Skipped writes printed (first run only)
+
+static void replay_count_cs_write(io_utils_dev_s *io, uint8_t level)
+{
+    replay_calls++;
+    replay_real->cs_write(io, level);
+}
+
+static int replay_count_transfer_reg16(io_utils_dev_s *io, uint16_t addr, uint8_t *rx, const uint8_t *tx, int len)
+{
+    replay_calls++;
+    return replay_real->transfer_reg16(io, addr, rx, tx, len);
+}
+
+static int replay_count_burst_reg16(io_utils_dev_s *io, uint16_t addr, uint8_t *rx, const uint8_t *tx, int len)
+{
+    replay_calls++;
+    return replay_real->burst_reg16(io, addr, rx, tx, len);
+}
+
+static int replay_count_exchange(io_utils_dev_s *io, uint8_t *rx, const uint8_t *tx, int len)
+{
+    replay_calls++;
+    return replay_real->exchange(io, rx, tx, len);
+}
+
+static int replay_count_message(io_utils_dev_s *io, struct spi_ioc_transfer *xfer, int n)
+{
+    replay_calls++;
+    return replay_real->message(io, xfer, n);
+}
+
+static io_utils_transport_s replay_count_transport;
+
+static int test_replay_compare(const at86rf215_trace_entry_st *e, const uint8_t *rx, test_replay_phase_st *ph, int *printed)
+{
+    int n = (e->len < AT86RF215_TRACE_DATA) ? e->len : AT86RF215_TRACE_DATA;
+
+    if (memcmp(e->data, rx, n) == 0) return 0;
+
+    ph->deviations++;
+    if ((*printed)++ < TEST_REPLAY_MAX_DEVS)
+    {
+        printf("TEST:AT86RF215:REPLAY:DEVIATION:PHASE=%s, ADDR=0x%04X, RECORDED=", ph->name, e->addr);
+        for (int b = 0; b < n; b++) printf("%02X", e->data[b]);
+        printf(", REPLAY=");
+        for (int b = 0; b < n; b++) printf("%02X", rx[b]);
+        printf("\n");
+    }
+    return 1;
+}
+
+// test_replay_truncated - the recording holds only the first AT86RF215_TRACE_DATA bytes of the payload,
+// such a write is not replayed (the chip would get a zero tail) and is reported instead
+static int test_replay_truncated(const at86rf215_trace_entry_st *e, test_replay_phase_st *ph)
+{
+    if (e->len <= AT86RF215_TRACE_DATA) return 0;
+
+    ph->truncated++;
+    if (replay_skips_printed++ < TEST_REPLAY_MAX_DEVS)
+    {
+        printf("TEST:AT86RF215:REPLAY:SKIPPED:PHASE=%s, ADDR=0x%04X, LEN=%d (payload truncated in the recording)\n",
+               ph->name, e->addr, e->len);
+    }
+    return 1;
+}
+
+// test_replay_entry - one recorded transaction (a batch header consumes its operations), returns entries used
+static int test_replay_entry(at86rf215_st* dev, const at86rf215_trace_entry_st *e, int remaining,
+                             test_replay_phase_st *ph, int *printed)
+{
+    static uint8_t buf[0x10000];
+    static io_utils_spi_batch_s batch;
+    static uint8_t slot[IO_UTILS_SPI_BATCH_MAX_OPS][256];
+    int used = 1;
+
+    memset(buf, 0, e->len);
+    if (e->op != at86rf215_trace_op_batch) memcpy(buf, e->data, (e->len < AT86RF215_TRACE_DATA) ? e->len : AT86RF215_TRACE_DATA);
+
+    switch (e->op)
+    {
+        case at86rf215_trace_op_read:
+        case at86rf215_trace_op_batch_read:
+            io_utils_spi_read_buffer(&dev->io, e->addr, buf, e->len);
+            test_replay_compare(e, buf, ph, printed);
+            break;
+        case at86rf215_trace_op_write:
+        case at86rf215_trace_op_batch_write:
+            if (test_replay_truncated(e, ph)) return used;
+            io_utils_spi_write_buffer(&dev->io, e->addr | 0x8000, buf, e->len);
+            break;
+        case at86rf215_trace_op_read_burst:
+            io_utils_spi_read_burst(&dev->io, e->addr, buf, e->len);
+            test_replay_compare(e, buf, ph, printed);
+            break;
+        case at86rf215_trace_op_write_burst:
+            if (test_replay_truncated(e, ph)) return used;
+            io_utils_spi_write_burst(&dev->io, e->addr | 0x8000, buf, e->len);
+            break;
+        case at86rf215_trace_op_batch:
+            // Header + its operations as one commit, as recorded ...
+            io_utils_spi_batch_begin(&batch);
+            for (int i = 1; i <= e->data[0] && i < remaining; i++)
+            {
+                const at86rf215_trace_entry_st *o = &e[i];
+                uint8_t data[256] = {0};
+
+                if (o->op == at86rf215_trace_op_batch_read)
+                {
+                    io_utils_spi_batch_append_read(&batch, o->addr, slot[i - 1], o->len);
+                }
+                else if (o->op == at86rf215_trace_op_batch_write)
+                {
+                    if (!test_replay_truncated(o, ph))
+                    {
+                        memcpy(data, o->data, o->len);
+                        io_utils_spi_batch_append_write(&batch, o->addr | 0x8000, data, o->len);
+                    }
+                }
+                else break;
+                used++;
+            }
+            io_utils_spi_batch_commit(&dev->io, &batch);
+            for (int i = 1; i < used; i++)
+            {
+                if (e[i].op == at86rf215_trace_op_batch_read) test_replay_compare(&e[i], slot[i - 1], ph, printed);
+            }
+            break;
+        default:
+            return used;
+    }
+
+    ph->transactions++;
+    return used;
+}
+
+int test_at86rf215_replay (at86rf215_st* dev, const char* path, int runs, int pace)
+{
+    at86rf215_trace_file_hdr_st hdr;
+    test_replay_phase_st phases[TEST_REPLAY_MAX_PHASES];
+    struct timespec t0, t1;
+    int num_phases = 0, printed = 0;
+    replay_skips_printed = 0;
+
+    FILE* f = fopen(path, "rb");
+    if (f == NULL || fread(&hdr, sizeof(hdr), 1, f) != 1 || memcmp(hdr.magic, AT86RF215_TRACE_MAGIC, sizeof(hdr.magic)) != 0 ||
+        hdr.entry_size != sizeof(at86rf215_trace_entry_st))
+    {
+        printf("TEST:AT86RF215:REPLAY:ERROR=%s is not a trace dump of this library version\n", path);
+        if (f) fclose(f);
+        return 0;
+    }
+
+    at86rf215_trace_entry_st *ent = calloc(hdr.num_entries + 1, sizeof(at86rf215_trace_entry_st));
+    int num = fread(ent, sizeof(at86rf215_trace_entry_st), hdr.num_entries, f);
+    fclose(f);
+
+    if (hdr.recorded > hdr.num_entries)
+    {
+        printf("TEST:AT86RF215:REPLAY:WARNING=ring wrapped, %llu oldest transactions are missing\n",
+               (unsigned long long)(hdr.recorded - hdr.num_entries));
+    }
+
+    // Phases and their recorded duration (marker to next marker / last transaction end) ...
+    memset(phases, 0, sizeof(phases));
+    snprintf(phases[0].name, sizeof(phases[0].name), "start");
+    uint64_t phase_start = (num > 0) ? ent[0].ts_ns : 0;
+    for (int i = 0; i < num; i++)
+    {
+        uint64_t end = ent[i].ts_ns + ent[i].dur_ns;
+        if (ent[i].op == at86rf215_trace_op_mark && num_phases < TEST_REPLAY_MAX_PHASES - 1)
+        {
+            if (i > 0) num_phases++;
+            snprintf(phases[num_phases].name, sizeof(phases[num_phases].name), "%.*s", ent[i].len, (const char*)ent[i].data);
+            phase_start = ent[i].ts_ns;
+        }
+        phases[num_phases].recorded_us = (end - phase_start) / 1e3;
+    }
+    num_phases++;
+
+    // Transport calls counted by a shim in front of the real transport ...
+    replay_real = dev->io.transport;
+    replay_count_transport = *replay_real;
+    replay_count_transport.cs_write = replay_count_cs_write;
+    replay_count_transport.transfer_reg16 = replay_count_transfer_reg16;
+    replay_count_transport.burst_reg16 = replay_count_burst_reg16;
+    replay_count_transport.exchange = replay_count_exchange;
+    replay_count_transport.message = replay_count_message;
+    dev->io.transport = &replay_count_transport;
+    int syscalls = (replay_real == &io_utils_transport_spidev);
+
+    for (int run = 0; run < runs; run++)
+    {
+        int p = 0;
+        uint64_t calls0 = replay_calls;
+
+        // Same starting point as the recording (chip reset of at86rf215_init) ...
+        at86rf215_reset(dev);
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        uint64_t base_ns = (uint64_t)t0.tv_sec * 1000000000ull + t0.tv_nsec;
+
+        for (int i = 0; i < num; )
+        {
+            if (ent[i].op == at86rf215_trace_op_mark)
+            {
+                if (i > 0 && p < num_phases - 1)
+                {
+                    clock_gettime(CLOCK_MONOTONIC, &t1);
+                    double us = test_elapsed_us(&t0, &t1);
+                    phases[p].replay_sum_us += us;
+                    if (run == 0 || us < phases[p].replay_min_us) phases[p].replay_min_us = us;
+                    if (run == 0) phases[p].calls = replay_calls - calls0;
+                    calls0 = replay_calls;
+                    t0 = t1;
+                    p++;
+                }
+                i++;
+                continue;
+            }
+
+            if (pace)
+            {
+                uint64_t at = base_ns + (ent[i].ts_ns - ent[0].ts_ns);
+                struct timespec wake = { .tv_sec = at / 1000000000ull, .tv_nsec = at % 1000000000ull };
+                clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL);
+            }
+
+            // Counters of the first run only - later runs just add timing ...
+            test_replay_phase_st scratch = phases[p];
+            i += test_replay_entry(dev, &ent[i], num - i, (run == 0) ? &phases[p] : &scratch, &printed);
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double us = test_elapsed_us(&t0, &t1);
+        phases[p].replay_sum_us += us;
+        if (run == 0 || us < phases[p].replay_min_us) phases[p].replay_min_us = us;
+        if (run == 0) phases[p].calls = replay_calls - calls0;
+        printed = TEST_REPLAY_MAX_DEVS;
+        replay_skips_printed = TEST_REPLAY_MAX_DEVS;
+    }
+
+    dev->io.transport = replay_real;
+
+    printf("TEST:AT86RF215:REPLAY:FILE=%s, ENTRIES=%d, RUNS=%d, PACED=%d, TRANSPORT=%s\n", path, num, runs, pace, replay_real->name);
+    for (int p = 0; p < num_phases; p++)
+    {
+        test_replay_phase_st *ph = &phases[p];
+        printf("TEST:AT86RF215:REPLAY:PHASE=%-10s XFERS=%5d, CALLS=%6llu, SYSCALLS=%6llu, RECORDED=%10.1f usec, REPLAY_MIN=%10.1f usec, REPLAY_AVG=%10.1f usec, DEVIATIONS=%llu, TRUNCATED=%d\n",
+               ph->name, ph->transactions, (unsigned long long)ph->calls, (unsigned long long)(syscalls ? ph->calls : 0),
+               ph->recorded_us, ph->replay_min_us, ph->replay_sum_us / runs, (unsigned long long)ph->deviations, ph->truncated);
+    }
+
+    free(ent);
+    return num;
+}
+
 // -----------------------------------------------------------------------------------------
 // TEST SELECTION
 // -----------------------------------------------------------------------------------------
@@ -255,10 +922,18 @@ int test_at86rf215_continues_iq_loopback (at86rf215_st* dev, at86rf215_rf_channe
 #define TEST_IQ_RX_WIND_RAD 0 
 #define TEST_IQ_LB_WIND     0
 #define TEST_READ_ALL_REGS  0
+#define TEST_ASYNC_BENCH    0
+#define TEST_MULTI_DEV      0
+#define TEST_TRACE          0
+#define TEST_EMULATOR       0   // 1 --> all tests run against the software emulator (no hardware needed)
+#define TEST_IRQ_PRINT      0   // 1 --> every serviced interrupt is printed (at86rf215_irq_observer_print)
+#define TEST_EVENT_FD       0   // 1 --> IRQ served from an epoll loop without poll thread (emulated device)
+#define TEST_IRQ_POLL       0   // 1 --> no IRQ line, IRQS polled by the waiter (emulated device)
 
 // -- Using CMAKE to define these MACROS --
 // #define TEST_TX          1
 // #define TEST_RX          1
+// #define TEST_REPLAY      1
 
 // -----------------------------------------------------------------------------------------
 // MAIN
@@ -270,7 +945,67 @@ int main (int argc, char *argv[])
     char *end = NULL;
     
     at86rf215_iq_interface_config_st cfg = {0};
+    #if TEST_TX || TEST_RX
     at86rf215_irq_st irq = {0};
+    #endif
+
+    #if TEST_EMULATOR
+        dev.emulated = 1;
+        for (int i = 0; i < TEST_MULTI_DEV_NUM - 1; i++) dev_multi[i].emulated = 1;
+    #endif
+
+    // ---------------------------
+    // -- Session replay option --
+    // ---------------------------
+    #if TEST_REPLAY==1
+    {
+        int runs = 1;
+        int pace = 0;
+
+        // -- Parse input arguments --
+        while((opt = getopt(argc, argv, "ed:s:n:t")) != -1){
+            switch(opt){
+                case 'e':
+                    dev.emulated = 1;
+                    break;
+                case 'd':
+                    dev.spi_dev = optarg;
+                    break;
+                case 's':
+                    dev.spi_speed = strtol(optarg, &end, 10);
+                    break;
+                case 'n':
+                    runs = strtol(optarg, &end, 10);
+                    if (runs < 1) runs = 1;
+                    break;
+                case 't':
+                    pace = 1;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        if(optind >= argc){
+            printf("Usage: %s [-e emulated] [-d /dev/spidevX.Y] [-s spi_speed] [-n runs] [-t recorded pacing] trace.bin\n", argv[0]);
+            return 1;
+        }
+
+        // Raw device - no init sequence, the recording brings its own ...
+        if(at86rf215_open_io(&dev) != 0 || io_utils_spi_init(&dev.io, dev.spi_dev, dev.spi_mode, dev.spi_bits, dev.spi_speed) != 0){
+            return 1;
+        }
+
+        ret = test_at86rf215_replay(&dev, argv[optind], runs, pace);
+        at86rf215_close_io(&dev);
+
+        return (ret > 0) ? 0 : 1;
+    }
+    #endif
+
+    #if TEST_IRQ_PRINT
+        at86rf215_set_irq_observer(&dev, at86rf215_irq_observer_print, NULL);
+    #endif
 
 	if(at86rf215_init(&dev) == -1){
        return 1;   
@@ -302,6 +1037,46 @@ int main (int argc, char *argv[])
         test_at86rf215_read_all_regs_check(&dev);
     #endif
 
+    #if TEST_ASYNC_BENCH
+        test_at86rf215_async_benchmark(&dev, 10000, 16);
+        test_at86rf215_print_bus_stats(&dev);
+    #endif
+
+    #if TEST_EMULATOR
+        test_at86rf215_emulator_check(&dev);
+    #endif
+
+    #if TEST_EVENT_FD
+        test_at86rf215_event_fd();
+    #endif
+
+    #if TEST_IRQ_POLL
+        test_at86rf215_irq_poll();
+    #endif
+
+    #if TEST_TRACE
+        test_at86rf215_trace(&dev, 100000, "/tmp/at86rf215_trace.bin");
+    #endif
+
+    #if TEST_MULTI_DEV
+    {
+        at86rf215_st* devs[TEST_MULTI_DEV_NUM] = { &dev };
+        int num_devs = 1;
+
+        for (int i = 0; i < TEST_MULTI_DEV_NUM - 1; i++)
+        {
+            if (at86rf215_init(&dev_multi[i]) == 0) devs[num_devs++] = &dev_multi[i];
+        }
+
+        test_at86rf215_multi_device_benchmark(devs, num_devs, 10000);
+
+        for (int i = 1; i < num_devs; i++)
+        {
+            at86rf215_close(devs[i], 0);
+        }
+    }
+    #endif
+
     // -----------------------
     // -- TX testing option --
     // -----------------------